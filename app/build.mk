@@ -45,6 +45,28 @@ LOCAL_STATIC_LIBS := \
     libpostform
 include $(BUILD_BINARY)
 
+include $(CLEAR_VARS)
+LOCAL_NAME := format_bench
+LOCAL_CFLAGS := \
+    $(TARGET_CFLAGS) \
+    $(POSTFORM_CFLAGS)
+LOCAL_CXXFLAGS := \
+    $(LOCAL_CFLAGS) \
+    $(POSTFORM_CXXFLAGS)
+LOCAL_LDFLAGS := \
+    -Wl,--gc-sections \
+    -lnosys
+LOCAL_LINKER_FILE := \
+    $(LOCAL_DIR)/bench_memory.ld
+LOCAL_SRC := $(LOCAL_DIR)/src/bench_main.cpp
+LOCAL_ARM_ARCHITECTURE := v7-m
+LOCAL_ARM_FPU := nofp
+LOCAL_COMPILER := arm_clang
+LOCAL_STATIC_LIBS := \
+    libcortex_m_startup \
+    libpostform
+include $(BUILD_BINARY)
+
 include $(CLEAR_VARS)
 LOCAL_NAME := format_host
 LOCAL_CFLAGS := $(POSTFORM_CFLAGS)
@@ -55,3 +77,14 @@ LOCAL_SRC := $(LOCAL_DIR)/src/host_main.cpp
 LOCAL_STATIC_LIBS := libpostform_host
 LOCAL_LINKER_FILE := $(LOCAL_DIR)/host_ld.x
 include $(BUILD_BINARY)
+
+include $(CLEAR_VARS)
+LOCAL_NAME := format_load
+LOCAL_CFLAGS := $(POSTFORM_CFLAGS)
+LOCAL_CXXFLAGS := \
+    $(LOCAL_CFLAGS) \
+    $(POSTFORM_CXXFLAGS)
+LOCAL_SRC := $(LOCAL_DIR)/src/load_main.cpp
+LOCAL_STATIC_LIBS := libpostform_host
+LOCAL_LINKER_FILE := $(LOCAL_DIR)/host_ld.x
+include $(BUILD_BINARY)
@@ -0,0 +1,324 @@
+#include <cstdint>
+
+#include "postform/config.h"
+#include "postform/rtt/rtt_manager.h"
+#include "postform/rtt_logger.h"
+
+// Benchmark firmware for Cortex-M3 targets, meant to run under an emulator
+// with `postform_qemu_bench` or on a board under a debugger with semihosting.
+//
+// Every shape of LOG_* call is logged through every writer from its own
+// function, so that its flash usage can be read from the ELF file. The
+// results are printed through semihosting, one line per benchmark:
+//
+//   <writer> <shape> <records> <ticks> <bytes> <stack bytes>
+//
+// Ticks are CPU cycles counted by the DWT when it is available. Otherwise
+// they are SysTick ticks, which QEMU derives from the instruction count when
+// run with -icount. The RTT channel is drained after every record, outside
+// the benchmarked functions, and the ticks of draining it are subtracted.
+
+namespace {
+
+namespace Registers {
+inline volatile uint32_t& at(uintptr_t address) {
+  return *reinterpret_cast<volatile uint32_t*>(address);
+}
+volatile uint32_t& DEMCR = at(0xE000EDFC);
+volatile uint32_t& DWT_CTRL = at(0xE0001000);
+volatile uint32_t& DWT_CYCCNT = at(0xE0001004);
+volatile uint32_t& SYST_CSR = at(0xE000E010);
+volatile uint32_t& SYST_RVR = at(0xE000E014);
+volatile uint32_t& SYST_CVR = at(0xE000E018);
+}  // namespace Registers
+
+constexpr uint32_t DEMCR_TRCENA = 1U << 24;
+constexpr uint32_t DWT_CTRL_CYCCNTENA = 1U << 0;
+constexpr uint32_t SYST_CSR_ENABLE_CORE_CLOCK = (1U << 0) | (1U << 2);
+constexpr uint32_t SYSTICK_MASK = 0x00FFFFFF;
+
+//! Records logged between two reads of the tick counter. Small enough for the
+//! 24-bit SysTick not to wrap twice.
+constexpr uint32_t BATCH_SIZE = 64;
+constexpr uint32_t NUM_BATCHES = 16;
+//! Bytes of stack painted below the stack pointer to measure stack usage
+constexpr uint32_t STACK_PAINT_SIZE = 1024;
+constexpr uint32_t STACK_PAINT_PATTERN = 0xA5A5A5A5;
+
+bool s_use_dwt = false;
+
+void semihostingCall(uint32_t operation, const void* argument) {
+  register uint32_t r0 asm("r0") = operation;
+  register const void* r1 asm("r1") = argument;
+  asm volatile("bkpt 0xAB" : "+r"(r0) : "r"(r1) : "memory");
+}
+
+void print(const char* string) {
+  constexpr uint32_t SYS_WRITE0 = 0x04;
+  semihostingCall(SYS_WRITE0, string);
+}
+
+void print(uint32_t value) {
+  char digits[11];
+  char* digit = &digits[sizeof(digits) - 1];
+  *digit = '\0';
+  do {
+    *--digit = static_cast<char>('0' + (value % 10U));
+    value /= 10U;
+  } while (value != 0);
+  print(digit);
+}
+
+[[noreturn]] void exitEmulator() {
+  constexpr uint32_t SYS_EXIT = 0x18;
+  constexpr uint32_t ADP_STOPPED_APPLICATION_EXIT = 0x20026;
+  semihostingCall(SYS_EXIT,
+                  reinterpret_cast<const void*>(ADP_STOPPED_APPLICATION_EXIT));
+  while (true) {
+  }
+}
+
+void initTickCounter() {
+  Registers::SYST_RVR = SYSTICK_MASK;
+  Registers::SYST_CVR = 0;
+  Registers::SYST_CSR = SYST_CSR_ENABLE_CORE_CLOCK;
+
+  Registers::DEMCR |= DEMCR_TRCENA;
+  Registers::DWT_CYCCNT = 0;
+  Registers::DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+  // Emulators that don't model the DWT leave the cycle counter stopped
+  const uint32_t start = Registers::DWT_CYCCNT;
+  for (volatile uint32_t i = 0; i < 16; i++) {
+  }
+  s_use_dwt = Registers::DWT_CYCCNT != start;
+}
+
+uint32_t readTicks() {
+  if (s_use_dwt) {
+    return Registers::DWT_CYCCNT;
+  }
+  // SysTick counts down
+  return SYSTICK_MASK - Registers::SYST_CVR;
+}
+
+uint32_t elapsedTicks(uint32_t start, uint32_t end) {
+  if (s_use_dwt) {
+    return end - start;
+  }
+  return (end - start) & SYSTICK_MASK;
+}
+
+}  // namespace
+
+namespace Postform {
+
+uint64_t getGlobalTimestamp() {
+  static uint32_t s_count = 0;
+  return s_count++;
+}
+
+/**
+ * @brief Writer that only counts the bytes of the records, to measure the
+ * cost of encoding them.
+ */
+class NullWriter {
+ public:
+  explicit NullWriter(uint32_t* bytes) : m_bytes(bytes) {}
+
+  void write(const uint8_t*, uint32_t size) { *m_bytes += size; }
+
+  operator bool() { return true; }
+
+ private:
+  uint32_t* m_bytes;
+};
+
+class NullLogger : public Logger<NullLogger, NullWriter> {
+ public:
+  uint32_t bytes = 0;
+
+ private:
+  NullWriter getWriter() { return NullWriter{&bytes}; }
+
+  friend Logger<NullLogger, NullWriter>;
+};
+
+class RawRttLogger : public Logger<RawRttLogger, Rtt::RawWriter> {
+ private:
+  Rtt::RawWriter getWriter() {
+    return Rtt::Manager::getInstance().getRawWriter();
+  }
+
+  friend Logger<RawRttLogger, Rtt::RawWriter>;
+};
+
+}  // namespace Postform
+
+DECLARE_POSTFORM_CONFIG(.timestamp_frequency = 1);
+
+namespace {
+
+Postform::NullLogger s_null_logger;
+Postform::RawRttLogger s_raw_logger;
+Postform::RttLogger s_cobs_logger;
+
+uint32_t s_rtt_bytes = 0;
+volatile uint32_t s_value = 0x12345678;
+const char SHORT_STRING[] = "0123456789abcdef";
+
+//! Drain of the writers that don't need one
+void noDrain() {}
+
+/**
+ * @brief Empties the RTT up channel, like a reader that always keeps up.
+ */
+__attribute__((noinline)) void drainRttChannel() {
+  auto& channel = Postform::Rtt::getControlBlock().up_channel;
+  const uint32_t write = channel.write.load(std::memory_order_relaxed);
+  const uint32_t read = channel.read.load(std::memory_order_relaxed);
+  channel.read.store(write, std::memory_order_relaxed);
+  s_rtt_bytes +=
+      (write >= read) ? (write - read) : (channel.size - read + write);
+}
+
+uint32_t bytesWritten(const char* writer) {
+  return (writer[0] == 'n') ? s_null_logger.bytes : s_rtt_bytes;
+}
+
+/**
+ * @brief Runs a call site once with the stack below the current stack
+ * pointer painted, returning the number of bytes of stack it used.
+ */
+__attribute__((noinline)) uint32_t measureStack(void (*call_site)()) {
+  uint32_t stack_pointer;
+  asm volatile("mov %0, sp" : "=r"(stack_pointer));
+  // Leave room for the registers this function spills
+  volatile uint32_t* const top =
+      reinterpret_cast<volatile uint32_t*>(stack_pointer) - 16;
+  volatile uint32_t* const bottom = top - (STACK_PAINT_SIZE / 4);
+  for (volatile uint32_t* word = bottom; word < top; word++) {
+    *word = STACK_PAINT_PATTERN;
+  }
+  call_site();
+  volatile uint32_t* word = bottom;
+  while ((word < top) && (*word == STACK_PAINT_PATTERN)) {
+    word++;
+  }
+  return (top - word) * sizeof(uint32_t);
+}
+
+/**
+ * @brief Ticks taken by the benchmark loop when it only drains the writer,
+ * which are subtracted from the ticks of the call sites.
+ */
+uint32_t measureDrainTicks(void (*drain)()) {
+  uint32_t ticks = 0;
+  for (uint32_t batch = 0; batch < NUM_BATCHES; batch++) {
+    const uint32_t start = readTicks();
+    for (uint32_t i = 0; i < BATCH_SIZE; i++) {
+      drain();
+    }
+    ticks += elapsedTicks(start, readTicks());
+  }
+  return ticks;
+}
+
+void runBenchmark(const char* writer, const char* shape, void (*call_site)(),
+                  void (*drain)()) {
+  const uint32_t stack = measureStack(call_site);
+  drain();
+  const uint32_t start_bytes = bytesWritten(writer);
+  uint32_t ticks = 0;
+  for (uint32_t batch = 0; batch < NUM_BATCHES; batch++) {
+    const uint32_t start = readTicks();
+    for (uint32_t i = 0; i < BATCH_SIZE; i++) {
+      call_site();
+      drain();
+    }
+    ticks += elapsedTicks(start, readTicks());
+  }
+  const uint32_t drain_ticks = measureDrainTicks(drain);
+  ticks = (ticks > drain_ticks) ? (ticks - drain_ticks) : 0;
+  const uint32_t records = BATCH_SIZE * NUM_BATCHES;
+
+  print(writer);
+  print(" ");
+  print(shape);
+  print(" ");
+  print(records);
+  print(" ");
+  print(ticks);
+  print(" ");
+  // The first record of the stack measurement is not counted
+  print(bytesWritten(writer) - start_bytes);
+  print(" ");
+  print(stack);
+  print("\n");
+}
+
+}  // namespace
+
+// A function per writer and shape, named postform_bench_<writer>_<shape>
+#define POSTFORM_BENCH_CALL_SITE(writer, logger, shape, ...) \
+  extern "C" __attribute__((noinline)) void                  \
+      postform_bench_##writer##_##shape() {                  \
+    auto* logger_ptr = &(logger);                            \
+    __VA_ARGS__;                                             \
+  }
+
+#define POSTFORM_BENCH_SHAPES(writer, logger)                              \
+  POSTFORM_BENCH_CALL_SITE(writer, logger, no_args,                        \
+                           LOG_INFO(logger_ptr, "No arguments"))           \
+  POSTFORM_BENCH_CALL_SITE(writer, logger, int_1,                          \
+                           const uint32_t value = s_value;                 \
+                           LOG_INFO(logger_ptr, "%u", value))              \
+  POSTFORM_BENCH_CALL_SITE(writer, logger, int_2,                          \
+                           const uint32_t value = s_value;                 \
+                           LOG_INFO(logger_ptr, "%u %u", value, value))    \
+  POSTFORM_BENCH_CALL_SITE(writer, logger, int_4,                          \
+                           const uint32_t value = s_value;                 \
+                           LOG_INFO(logger_ptr, "%u %u %u %u", value,      \
+                                    value, value, value))                  \
+  POSTFORM_BENCH_CALL_SITE(writer, logger, int_8,                          \
+                           const uint32_t value = s_value;                 \
+                           LOG_INFO(logger_ptr, "%u %u %u %u %u %u %u %u", \
+                                    value, value, value, value, value,     \
+                                    value, value, value))                  \
+  POSTFORM_BENCH_CALL_SITE(writer, logger, string,                         \
+                           LOG_INFO(logger_ptr, "%s", SHORT_STRING))       \
+  POSTFORM_BENCH_CALL_SITE(writer, logger, interned_string,                \
+                           LOG_INFO(logger_ptr, "%k",                      \
+                                    "An interned string"_intern))          \
+  POSTFORM_BENCH_CALL_SITE(writer, logger, pointer,                        \
+                           LOG_INFO(logger_ptr, "%p",                      \
+                                    reinterpret_cast<void*>(0x20001000)))
+
+POSTFORM_BENCH_SHAPES(null, s_null_logger)
+POSTFORM_BENCH_SHAPES(rtt_raw, s_raw_logger)
+POSTFORM_BENCH_SHAPES(rtt_cobs, s_cobs_logger)
+
+#define POSTFORM_BENCH_RUN_SHAPES(writer, drain)                          \
+  runBenchmark(#writer, "no_args", postform_bench_##writer##_no_args,    \
+               drain);                                                   \
+  runBenchmark(#writer, "int_1", postform_bench_##writer##_int_1, drain); \
+  runBenchmark(#writer, "int_2", postform_bench_##writer##_int_2, drain); \
+  runBenchmark(#writer, "int_4", postform_bench_##writer##_int_4, drain); \
+  runBenchmark(#writer, "int_8", postform_bench_##writer##_int_8, drain); \
+  runBenchmark(#writer, "string", postform_bench_##writer##_string,      \
+               drain);                                                   \
+  runBenchmark(#writer, "interned_string",                               \
+               postform_bench_##writer##_interned_string, drain);        \
+  runBenchmark(#writer, "pointer", postform_bench_##writer##_pointer,    \
+               drain)
+
+int main() {
+  initTickCounter();
+  print(s_use_dwt ? "clock dwt\n" : "clock systick\n");
+
+  POSTFORM_BENCH_RUN_SHAPES(null, noDrain);
+  POSTFORM_BENCH_RUN_SHAPES(rtt_raw, drainRttChannel);
+  POSTFORM_BENCH_RUN_SHAPES(rtt_cobs, drainRttChannel);
+
+  print("done\n");
+  exitEmulator();
+}
@@ -1,9 +1,12 @@
 
 #include <atomic>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 #include "postform/config.h"
 #include "postform/file_logger.h"
+#include "postform/socket_logger.h"
 
 namespace Postform {
 uint64_t getGlobalTimestamp() {
@@ -14,50 +17,48 @@ uint64_t getGlobalTimestamp() {
 
 DECLARE_POSTFORM_CONFIG(.timestamp_frequency = 1);
 
-int main(int argc, const char* argv[]) {
-  if (argc != 2) {
-    printf("Expected 2 arguments!\n");
-    return -1;
-  }
-
-  Postform::FileLogger logger{std::string{argv[1]}};
-
+template <class Logger>
+void logIterations(Logger* logger, uint32_t num_iterations) {
   uint32_t iteration = 0;
-  for (uint32_t i = 0; i < 10; i++) {
+  for (uint32_t i = 0; i < num_iterations; i++) {
     // All the logs here together act as the worst case for the decoder. Without
     // proper framing they would be confused from the host. If they all show
     // that means that the COBS framing works
-    LOG_DEBUG(&logger, "Iteration number: %u", iteration);
-    LOG_DEBUG(&logger, "Is this %s or what?!", "nice");
-    LOG_INFO(&logger, "I am %d years old...", 28);
-    LOG_WARNING(&logger, "Third string! With multiple %s and more numbers: %d",
+    LOG_DEBUG(logger, "Iteration number: %u", iteration);
+    LOG_DEBUG(logger, "Is this %s or what?!", "nice");
+    LOG_INFO(logger, "I am %d years old...", 28);
+    LOG_WARNING(logger, "Third string! With multiple %s and more numbers: %d",
                 "args", -1124);
-    LOG_ERROR(&logger, "Oh boy, error %d just happened", 234556);
+    LOG_ERROR(logger, "Oh boy, error %d just happened", 234556);
     char char_array[] = "123";
-    LOG_ERROR(&logger, "This is my char array: %s", char_array);
-    LOG_ERROR(&logger, "different unsigned sizes: %hhu, %hu, %u, %lu, %llu",
+    LOG_ERROR(logger, "This is my char array: %s", char_array);
+    LOG_ERROR(logger, "different unsigned sizes: %hhu, %hu, %u, %lu, %llu",
               static_cast<unsigned char>(123),
               static_cast<unsigned short>(43212),
               static_cast<unsigned int>(123123123),
               static_cast<unsigned long>(123123123),
               static_cast<unsigned long long>(123123123));
-    LOG_ERROR(&logger, "different signed sizes: %hhd, %hd, %d, %ld, %lld",
+    LOG_ERROR(logger, "different signed sizes: %hhd, %hd, %d, %ld, %lld",
               static_cast<signed char>(-123), static_cast<short>(-13212),
               static_cast<int>(-123123123), static_cast<long>(-123123123),
               static_cast<long long>(-123123123));
-    LOG_ERROR(&logger, "different octal sizes: %hho, %ho, %o, %lo, %llo",
+    LOG_ERROR(logger, "different octal sizes: %hho, %ho, %o, %lo, %llo",
               static_cast<unsigned char>(0123),
               static_cast<unsigned short>(0123),
               static_cast<unsigned int>(0123123),
               static_cast<unsigned long>(0123123123),
               static_cast<unsigned long long>(0123123123));
-    LOG_ERROR(&logger, "different hex sizes: %hhx, %hx, %x, %lx, %llx",
+    LOG_ERROR(logger, "different hex sizes: %hhx, %hx, %x, %lx, %llx",
               static_cast<unsigned char>(0xf3),
               static_cast<unsigned short>(0x1321),
               static_cast<unsigned int>(0x12341235),
               static_cast<unsigned long>(0x12341234),
               static_cast<unsigned long long>(0x1234567812345678));
-    LOG_ERROR(&logger, "Pointer %p", reinterpret_cast<void*>(0x12341234));
+    LOG_ERROR(logger, "Pointer %p", reinterpret_cast<void*>(0x12341234));
+    LOG_ERROR(logger, "Floats: %f, %le, %g", 1.5f, -12345.678, 0.0001f);
+    LOG_ERROR(logger, "Bytes: %*b", Postform::Bytes("\x01\x23\xAB", 3));
+    LOG_ERROR(logger, "Array: %*d", (std::array{-1, 2, 300}));
+    LOG_ERROR(logger, "Level: %{Postform::LogLevel}", Postform::LogLevel::INFO);
 
     constexpr auto interned_string =
         "Lorem ipsum dolor sit amet, consectetur adipiscing elit. "
@@ -87,10 +88,30 @@ int main(int argc, const char* argv[]) {
         "pellentesque purus sed velit placerat ultricies. In ut erat diam. "
         "Suspendisse potenti."_intern;
 
-    LOG_DEBUG(&logger,
+    LOG_DEBUG(logger,
               "Now if I wanted to print a really long text I can use %%k: %k",
               interned_string);
 
     iteration++;
   }
 }
+
+int main(int argc, const char* argv[]) {
+  if ((argc != 2) && (argc != 3)) {
+    printf("Usage: %s <log file | unix:<path> | tcp:<ip>:<port>> "
+           "[iterations]\n",
+           argv[0]);
+    return -1;
+  }
+
+  const uint32_t num_iterations = (argc == 3) ? atoi(argv[2]) : 10;
+  const std::string destination{argv[1]};
+  if ((destination.rfind("unix:", 0) == 0) ||
+      (destination.rfind("tcp:", 0) == 0)) {
+    Postform::SocketLogger logger{destination};
+    logIterations(&logger, num_iterations);
+  } else {
+    Postform::FileLogger logger{destination};
+    logIterations(&logger, num_iterations);
+  }
+}
@@ -0,0 +1,104 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+#include "postform/config.h"
+#include "postform/file_logger.h"
+
+// Load generator for the throughput regression harness. It writes a mix of
+// records similar to the one of a real application: mostly short debug and
+// info logs with a few integers, some strings, warnings and errors, and a
+// share of trace spans and metrics.
+
+namespace Postform {
+uint64_t getGlobalTimestamp() {
+  static std::atomic_uint64_t count;
+  return count.fetch_add(1, std::memory_order_relaxed);
+}
+}  // namespace Postform
+
+DECLARE_POSTFORM_CONFIG(.timestamp_frequency = 1000000);
+
+namespace {
+
+/**
+ * @brief xorshift32, so that every run writes the same records.
+ */
+class Random {
+ public:
+  explicit Random(uint32_t seed) : m_state(seed != 0 ? seed : 1) {}
+
+  uint32_t next() {
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 17;
+    m_state ^= m_state << 5;
+    return m_state;
+  }
+
+ private:
+  uint32_t m_state;
+};
+
+const char* const DEVICE_NAMES[] = {"uart0", "spi1", "i2c0", "adc",
+                                    "flash_controller"};
+
+/**
+ * @brief Writes a single record, picked from the mix with a random number
+ * between 0 and 99.
+ * @return the number of records written.
+ */
+uint32_t logRecord(Postform::FileLogger* logger, Random* random,
+                   uint32_t iteration) {
+  const uint32_t choice = random->next() % 100U;
+  const uint32_t value = random->next();
+  if (choice < 30) {
+    LOG_DEBUG(logger, "Processing sample %u", value & 0xFFFU);
+  } else if (choice < 50) {
+    LOG_INFO(logger, "Sensor %u read %d mV at %u", value % 8U,
+             static_cast<int32_t>(value % 3300U) - 1000, iteration);
+  } else if (choice < 60) {
+    LOG_DEBUG(logger, "Rx buffer %p holds %u bytes, flags 0x%x",
+              reinterpret_cast<void*>(0x20000000U + (value & 0xFFF0U)),
+              value % 512U, value >> 24);
+  } else if (choice < 68) {
+    LOG_INFO(logger, "Device %s changed state to %u",
+             DEVICE_NAMES[value % 5U], value % 4U);
+  } else if (choice < 73) {
+    LOG_WARNING(logger, "Retrying transfer %u after %d errors", iteration,
+                static_cast<int32_t>(value % 5U));
+  } else if (choice < 75) {
+    LOG_ERROR(logger, "Checksum mismatch: expected 0x%x, got 0x%x", value,
+              value ^ 0x5AU);
+  } else if (choice < 77) {
+    LOG_INFO(logger, "%k", "Configuration reloaded from flash"_intern);
+  } else if (choice < 87) {
+    POSTFORM_TRACE_BEGIN(logger, "process_sample");
+    POSTFORM_TRACE_END(logger, "process_sample");
+    return 2;
+  } else if (choice < 95) {
+    POSTFORM_COUNTER(logger, "rx_bytes", value % 256U);
+  } else {
+    POSTFORM_GAUGE(logger, "queue_depth", value % 32U);
+  }
+  return 1;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  if ((argc != 3) && (argc != 4)) {
+    printf("Usage: %s <log file> <records> [seed]\n", argv[0]);
+    return -1;
+  }
+
+  const uint32_t num_records = strtoul(argv[2], nullptr, 0);
+  const uint32_t seed = (argc == 4) ? strtoul(argv[3], nullptr, 0) : 1U;
+  Random random{seed};
+  Postform::FileLogger logger{argv[1]};
+  uint32_t records = 0;
+  for (uint32_t iteration = 0; records < num_records; iteration++) {
+    records += logRecord(&logger, &random, iteration);
+  }
+  printf("%u\n", records);
+  return 0;
+}
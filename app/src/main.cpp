@@ -9,6 +9,8 @@
 #include "cortex_m_hal/systick.h"
 #include "postform/rtt_logger.h"
 
+DECLARE_POSTFORM_STATS(0);
+
 void configureUart() {
   rcc_periph_clock_enable(rcc_periph_clken::RCC_GPIOA);
 
@@ -45,6 +47,7 @@ int main() {
   systick.init(systick_clk_hz);
 
   logger.setLevel(Postform::LogLevel::DEBUG);
+  logger.setStats(&_postform_stats);
 
   uint32_t iteration = 0;
   while (true) {
@@ -0,0 +1,311 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include "postform/file_logger.h"
+#include "postform/logger.h"
+#include "postform/rtt/rtt_manager.h"
+#include "postform/rtt_logger.h"
+
+// Microbenchmarks of the logger hot path: every LOG_* shape is logged through
+// every writer in a loop, and the cost of a record is reported as time,
+// encoded bytes and heap allocations.
+//
+// Usage: postform_bench [filter] [min time in ms]
+// Only the benchmarks whose name contains the filter are run.
+
+namespace {
+
+std::atomic<uint64_t> s_allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  s_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* memory = std::malloc(size);
+  if (memory == nullptr) {
+    std::abort();
+  }
+  return memory;
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+namespace Postform {
+
+uint64_t getGlobalTimestamp() {
+  static std::atomic_uint64_t count;
+  return count.fetch_add(1, std::memory_order_relaxed);
+}
+
+namespace Rtt {
+
+// The RTT writers write to a channel in host memory. The benchmark drains it
+// after every record, like a reader that always keeps up.
+ControlBlock& getControlBlock() {
+  static constexpr std::uint32_t UP_BUFFER_SIZE = 64 * 1024;
+  static constexpr std::uint32_t DOWN_BUFFER_SIZE = 16;
+  static std::uint8_t s_up_buffer[UP_BUFFER_SIZE];
+  static std::uint8_t s_down_buffer[DOWN_BUFFER_SIZE];
+  static ControlBlock s_control_block{s_up_buffer, UP_BUFFER_SIZE,
+                                      s_down_buffer, DOWN_BUFFER_SIZE};
+  return s_control_block;
+}
+
+}  // namespace Rtt
+
+/**
+ * @brief Writer that only counts the bytes of the records, to measure the
+ * cost of encoding them.
+ */
+class NullWriter {
+ public:
+  explicit NullWriter(uint64_t* bytes) : m_bytes(bytes) {}
+
+  void write(const uint8_t*, uint32_t size) { *m_bytes += size; }
+
+  operator bool() { return true; }
+
+ private:
+  uint64_t* m_bytes;
+};
+
+class NullLogger : public Logger<NullLogger, NullWriter> {
+ public:
+  uint64_t bytes = 0;
+
+ private:
+  NullWriter getWriter() { return NullWriter{&bytes}; }
+
+  friend Logger<NullLogger, NullWriter>;
+};
+
+class RawRttLogger : public Logger<RawRttLogger, Rtt::RawWriter> {
+ private:
+  Rtt::RawWriter getWriter() {
+    return Rtt::Manager::getInstance().getRawWriter();
+  }
+
+  friend Logger<RawRttLogger, Rtt::RawWriter>;
+};
+
+}  // namespace Postform
+
+namespace {
+
+struct Options {
+  const char* filter = "";
+  std::chrono::nanoseconds min_time = std::chrono::milliseconds{200};
+};
+
+/**
+ * @brief Runs a benchmark until it takes at least the minimum time and prints
+ * its results.
+ * @param body logs a single record.
+ * @param bytes returns the number of bytes written by the writer so far.
+ */
+template <class Body, class Bytes>
+void run(const Options& options, const char* writer, const char* shape,
+         Body&& body, Bytes&& bytes) {
+  const std::string name = std::string{writer} + "/" + shape;
+  if (name.find(options.filter) == std::string::npos) {
+    return;
+  }
+
+  // Warm up the caches and make any lazy initialization happen now
+  for (uint32_t i = 0; i < 1000; i++) {
+    body();
+  }
+
+  uint64_t iterations = 1000;
+  while (true) {
+    const uint64_t start_bytes = bytes();
+    const uint64_t start_allocations =
+        s_allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+      body();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if ((elapsed >= options.min_time) || (iterations >= (1ULL << 32))) {
+      const double records = static_cast<double>(iterations);
+      printf("%-28s %12.1f %14.2f %16.3f\n", name.c_str(),
+             std::chrono::duration<double, std::nano>(elapsed).count() /
+                 records,
+             static_cast<double>(bytes() - start_bytes) / records,
+             static_cast<double>(s_allocations.load(std::memory_order_relaxed) -
+                                 start_allocations) /
+                 records);
+      return;
+    }
+    iterations *= 2;
+  }
+}
+
+/**
+ * @brief Benchmarks all the shapes of LOG_* calls with a logger.
+ * @param drain called after every record, to make room for the next one.
+ */
+template <class Logger, class Drain, class Bytes>
+void runShapes(const Options& options, const char* writer, Logger* logger,
+               Drain&& drain, Bytes&& bytes) {
+  // Read through a volatile so that the encoding is not done at compile time
+  volatile uint32_t value = 0x12345678;
+  char short_string[17] = {};
+  memset(short_string, 'a', sizeof(short_string) - 1);
+  char long_string[257] = {};
+  memset(long_string, 'b', sizeof(long_string) - 1);
+  const std::string_view long_string_view{long_string,
+                                          sizeof(long_string) - 1};
+
+  run(
+      options, writer, "no_args",
+      [&] {
+        LOG_INFO(logger, "No arguments");
+        drain();
+      },
+      bytes);
+  run(
+      options, writer, "1_int",
+      [&] {
+        const uint32_t number = value;
+        LOG_INFO(logger, "%u", number);
+        drain();
+      },
+      bytes);
+  run(
+      options, writer, "2_ints",
+      [&] {
+        const uint32_t number = value;
+        LOG_INFO(logger, "%u %u", number, number);
+        drain();
+      },
+      bytes);
+  run(
+      options, writer, "4_ints",
+      [&] {
+        const uint32_t number = value;
+        LOG_INFO(logger, "%u %u %u %u", number, number, number, number);
+        drain();
+      },
+      bytes);
+  run(
+      options, writer, "8_ints",
+      [&] {
+        const uint32_t number = value;
+        LOG_INFO(logger, "%u %u %u %u %u %u %u %u", number, number, number,
+                 number, number, number, number, number);
+        drain();
+      },
+      bytes);
+  run(
+      options, writer, "empty_string",
+      [&] {
+        LOG_INFO(logger, "%s", "");
+        drain();
+      },
+      bytes);
+  run(
+      options, writer, "16_char_string",
+      [&] {
+        LOG_INFO(logger, "%s", short_string);
+        drain();
+      },
+      bytes);
+  run(
+      options, writer, "256_char_string",
+      [&] {
+        LOG_INFO(logger, "%s", long_string);
+        drain();
+      },
+      bytes);
+  run(
+      options, writer, "256_char_string_view",
+      [&] {
+        LOG_INFO(logger, "%.*s", long_string_view);
+        drain();
+      },
+      bytes);
+  run(
+      options, writer, "interned_string",
+      [&] {
+        LOG_INFO(logger, "%k", "An interned string"_intern);
+        drain();
+      },
+      bytes);
+  run(
+      options, writer, "pointer",
+      [&] {
+        LOG_INFO(logger, "%p", static_cast<void*>(short_string));
+        drain();
+      },
+      bytes);
+}
+
+/**
+ * @brief Empties the RTT up channel, returning the number of bytes it held.
+ */
+uint32_t drainRttChannel() {
+  auto& channel = Postform::Rtt::getControlBlock().up_channel;
+  const uint32_t write = channel.write.load(std::memory_order_acquire);
+  const uint32_t read = channel.read.load(std::memory_order_relaxed);
+  channel.read.store(write, std::memory_order_release);
+  return (write >= read) ? (write - read) : (channel.size - read + write);
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  Options options;
+  if (argc > 1) {
+    options.filter = argv[1];
+  }
+  if (argc > 2) {
+    options.min_time = std::chrono::milliseconds{atoi(argv[2])};
+  }
+
+  printf("%-28s %12s %14s %16s\n", "benchmark", "ns/record", "bytes/record",
+         "allocs/record");
+
+  {
+    Postform::NullLogger logger;
+    runShapes(
+        options, "null", &logger, [] {}, [&] { return logger.bytes; });
+  }
+
+  {
+    uint64_t rtt_bytes = 0;
+    const auto drain = [&] { rtt_bytes += drainRttChannel(); };
+    const auto bytes = [&] { return rtt_bytes; };
+    Postform::RawRttLogger raw_logger;
+    runShapes(options, "rtt_raw", &raw_logger, drain, bytes);
+    Postform::RttLogger cobs_logger;
+    runShapes(options, "rtt_cobs", &cobs_logger, drain, bytes);
+  }
+
+  {
+    const std::string path =
+        "/tmp/postform_bench_" + std::to_string(getpid()) + ".log";
+    const auto bytes = [&] {
+      struct stat file_stat {};
+      stat(path.c_str(), &file_stat);
+      return static_cast<uint64_t>(file_stat.st_size);
+    };
+    Postform::FileLogger logger{path};
+    runShapes(
+        options, "file", &logger, [] {}, bytes);
+    unlink(path.c_str());
+  }
+
+  return 0;
+}
@@ -41,7 +41,8 @@ LOCAL_CXXFLAGS := \
     $(LOCAL_CFLAGS) \
     $(POSTFORM_CXXFLAGS)
 LOCAL_SRC := \
-    $(POSTFORM_SRC)
+    $(POSTFORM_SRC) \
+    $(LOCAL_DIR)/src/rtt/control_block.cpp
 LOCAL_ARM_ARCHITECTURE := v7-m
 LOCAL_ARM_FPU := nofp
 LOCAL_COMPILER := arm_clang
@@ -62,7 +63,9 @@ LOCAL_CXXFLAGS := \
     $(LOCAL_CFLAGS) \
     $(POSTFORM_CXXFLAGS)
 LOCAL_SRC := \
-    $(POSTFORM_SRC)
+    $(POSTFORM_SRC) \
+    $(LOCAL_DIR)/src/rtt/shm_control_block.cpp \
+    $(LOCAL_DIR)/src/socket_logger.cpp
 LOCAL_ARFLAGS := -rcs
 LOCAL_EXPORTED_DIRS := \
     $(LOCAL_DIR)/inc
@@ -77,8 +80,29 @@ LOCAL_CFLAGS := \
 LOCAL_CXXFLAGS := \
     $(LOCAL_CFLAGS) \
     $(POSTFORM_CXXFLAGS)
+LOCAL_LDFLAGS := -lrt -lpthread
 LOCAL_SRC := \
     $(POSTFORM_SRC) \
-    $(LOCAL_DIR)/test/logger_test.cpp
+    $(LOCAL_DIR)/src/rtt/shm_control_block.cpp \
+    $(LOCAL_DIR)/src/socket_logger.cpp \
+    $(LOCAL_DIR)/test/histogram_test.cpp \
+    $(LOCAL_DIR)/test/logger_test.cpp \
+    $(LOCAL_DIR)/test/rtt_shm_test.cpp \
+    $(LOCAL_DIR)/test/socket_logger_test.cpp \
+    $(LOCAL_DIR)/test/test_platform.cpp
 include $(BUILD_HOST_TEST)
 
+include $(CLEAR_VARS)
+CC := clang
+CXX := clang++
+LOCAL_NAME := postform_bench
+LOCAL_CFLAGS := \
+    $(POSTFORM_CFLAGS)
+LOCAL_CXXFLAGS := \
+    $(LOCAL_CFLAGS) \
+    $(POSTFORM_CXXFLAGS)
+LOCAL_LDFLAGS := -lpthread
+LOCAL_SRC := \
+    $(POSTFORM_SRC) \
+    $(LOCAL_DIR)/bench/postform_bench.cpp
+include $(BUILD_BINARY)
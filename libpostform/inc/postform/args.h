@@ -4,10 +4,21 @@
 #include <postform/types.h>
 
 #include <array>
+#include <cstdint>
+#include <string_view>
 #include <type_traits>
 
 namespace Postform {
 
+/**
+ * @brief Elements of an array argument. The number of elements is the size
+ * of the argument.
+ */
+struct ArrayElements {
+  const void* data;
+  uint8_t element_size;
+};
+
 class Argument {
  public:
   const union {
@@ -16,6 +27,9 @@ class Argument {
     const char* str_ptr;
     const void* void_ptr;
     InternedString interned_string;
+    float float_value;
+    double double_value;
+    ArrayElements array;
   };
 
   const std::size_t size = 0;
@@ -24,8 +38,13 @@ class Argument {
     UNSIGNED_INTEGER,
     SIGNED_INTEGER,
     STRING_POINTER,
+    STRING_VIEW,
+    BYTES,
     VOID_PTR,
-    INTERNED_STRING
+    INTERNED_STRING,
+    FLOATING_POINT,
+    SIGNED_ARRAY,
+    UNSIGNED_ARRAY
   } type;
 };
 
@@ -49,12 +68,28 @@ constexpr Argument make_arg(T value) {
   };
 }
 
+// Enums are sent as their value. The host finds the name of the enumerator in
+// the debug info of the firmware.
+template <class T, std::enable_if_t<std::is_enum_v<T>, bool> = true>
+constexpr Argument make_arg(T value) {
+  return Argument{.signed_long_long = static_cast<long long>(
+                      static_cast<std::underlying_type_t<T>>(value)),
+                  .size = sizeof(T),
+                  .type = Argument::Type::SIGNED_INTEGER};
+}
+
 template <class T,
           std::enable_if_t<std::is_convertible_v<T, const char*>, bool> = true>
 constexpr Argument make_arg(T value) {
   return Argument{.str_ptr = value, .type = Argument::Type::STRING_POINTER};
 }
 
+constexpr Argument make_arg(std::string_view value) {
+  return Argument{.str_ptr = value.data(),
+                  .size = value.size(),
+                  .type = Argument::Type::STRING_VIEW};
+}
+
 template <class T, std::enable_if_t<!std::is_convertible_v<T, const char*> &&
                                         std::is_convertible_v<T, const void*>,
                                     bool> = true>
@@ -62,13 +97,47 @@ constexpr Argument make_arg(T value) {
   return Argument{.void_ptr = value, .type = Argument::Type::VOID_PTR};
 }
 
+constexpr Argument make_arg(float value) {
+  return Argument{.float_value = value,
+                  .size = sizeof(float),
+                  .type = Argument::Type::FLOATING_POINT};
+}
+
+constexpr Argument make_arg(double value) {
+  return Argument{.double_value = value,
+                  .size = sizeof(double),
+                  .type = Argument::Type::FLOATING_POINT};
+}
+
+constexpr Argument make_arg(Bytes value) {
+  return Argument{.void_ptr = value.data,
+                  .size = value.size,
+                  .type = Argument::Type::BYTES};
+}
+
 constexpr Argument make_arg(InternedString value) {
   return Argument{.interned_string = value,
                   .type = Argument::Type::INTERNED_STRING};
 }
 
+template <class T>
+constexpr Argument make_arg(Span<T> value) {
+  return Argument{
+      .array = ArrayElements{value.data, sizeof(T)},
+      .size = value.size,
+      .type = std::is_signed_v<T> ? Argument::Type::SIGNED_ARRAY
+                                  : Argument::Type::UNSIGNED_ARRAY};
+}
+
+template <class T, std::size_t N>
+constexpr Argument make_arg(const std::array<T, N>& value) {
+  return make_arg(Span<T>{value});
+}
+
+// Arguments are taken by reference, as in Logger::log, so that array
+// arguments point to the arrays of the caller instead of to copies of them.
 template <class... T>
-constexpr std::array<Argument, sizeof...(T)> build_args(T... args) {
+constexpr std::array<Argument, sizeof...(T)> build_args(const T&... args) {
   return {make_arg(args)...};
 }
 
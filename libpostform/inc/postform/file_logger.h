@@ -1,6 +1,6 @@
 
-#ifndef POSTFORM_RTT_LOGGER_H_
-#define POSTFORM_RTT_LOGGER_H_
+#ifndef POSTFORM_FILE_LOGGER_H_
+#define POSTFORM_FILE_LOGGER_H_
 
 #include <atomic>
 #include <string>
@@ -60,4 +60,4 @@ class FileLogger : public Logger<FileLogger, FileWriter> {
 
 }  // namespace Postform
 
-#endif  // POSTFORM_RTT_LOGGER_H_
+#endif  // POSTFORM_FILE_LOGGER_H_
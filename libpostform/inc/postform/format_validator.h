@@ -4,6 +4,7 @@
 
 #include <array>
 #include <cstdint>
+#include <string_view>
 #include <type_traits>
 
 #include "postform/macros.h"
@@ -32,6 +33,14 @@ constexpr static std::array<SizeSpecHandler, 5> integer_size_handlers = {
                     [](std::size_t size) { return size == sizeof(short); }},
 };
 
+// Floats are not promoted to double, so the size spec tells the host how many
+// bytes of IEEE-754 bits to read: `%f` for float and `%lf` for double.
+constexpr static std::array<SizeSpecHandler, 2> float_size_handlers = {
+    SizeSpecHandler{"", [](std::size_t size) { return size == sizeof(float); }},
+    SizeSpecHandler{"l",
+                    [](std::size_t size) { return size == sizeof(double); }},
+};
+
 struct SizeSpecHandlers {
   const SizeSpecHandler* handlers = &default_size_handler;
   uint32_t num = 1;
@@ -48,9 +57,15 @@ template <class T>
     const char* fmt, [[maybe_unused]] T arg, std::size_t* position) {
   // This array needs to be defined inside the template in order to have
   // visibility of T.
-  constexpr std::array<FormatSpecHandler, 8> format_spec_handlers = {
+  using Element = ArrayElementT<T>;
+  constexpr std::array<FormatSpecHandler, 19> format_spec_handlers = {
       FormatSpecHandler{SizeSpecHandlers{}, "s",
                         []() { return std::is_convertible_v<T, const char*>; }},
+      // The precision and the string of `%.*s` come from a single
+      // string_view, which carries both of them.
+      FormatSpecHandler{
+          SizeSpecHandlers{}, ".*s",
+          []() { return std::is_same_v<T, std::string_view>; }},
       FormatSpecHandler{
           SizeSpecHandlers{integer_size_handlers.data(),
                            integer_size_handlers.size()},
@@ -74,6 +89,47 @@ template <class T>
       FormatSpecHandler{
           SizeSpecHandlers{}, "k",
           []() { return std::is_same_v<T, Postform::InternedString>; }},
+      FormatSpecHandler{SizeSpecHandlers{}, "*b",
+                        []() { return std::is_same_v<T, Postform::Bytes>; }},
+      FormatSpecHandler{SizeSpecHandlers{}, "*B",
+                        []() { return std::is_same_v<T, Postform::Bytes>; }},
+      // Elements of arrays are sent as varints, so any size is accepted. Only
+      // unsigned ones can be displayed in octal or hex, as their encoding
+      // depends on their signedness.
+      FormatSpecHandler{SizeSpecHandlers{}, "*d",
+                        []() {
+                          return std::is_integral_v<Element> &&
+                                 std::is_signed_v<Element>;
+                        }},
+      FormatSpecHandler{SizeSpecHandlers{}, "*i",
+                        []() {
+                          return std::is_integral_v<Element> &&
+                                 std::is_signed_v<Element>;
+                        }},
+      FormatSpecHandler{SizeSpecHandlers{}, "*u",
+                        []() {
+                          return std::is_integral_v<Element> &&
+                                 std::is_unsigned_v<Element>;
+                        }},
+      FormatSpecHandler{SizeSpecHandlers{}, "*o",
+                        []() {
+                          return std::is_integral_v<Element> &&
+                                 std::is_unsigned_v<Element>;
+                        }},
+      FormatSpecHandler{SizeSpecHandlers{}, "*x",
+                        []() {
+                          return std::is_integral_v<Element> &&
+                                 std::is_unsigned_v<Element>;
+                        }},
+      FormatSpecHandler{SizeSpecHandlers{float_size_handlers.data(),
+                                         float_size_handlers.size()},
+                        "f", []() { return std::is_floating_point_v<T>; }},
+      FormatSpecHandler{SizeSpecHandlers{float_size_handlers.data(),
+                                         float_size_handlers.size()},
+                        "e", []() { return std::is_floating_point_v<T>; }},
+      FormatSpecHandler{SizeSpecHandlers{float_size_handlers.data(),
+                                         float_size_handlers.size()},
+                        "g", []() { return std::is_floating_point_v<T>; }},
   };
 
   /// Common code for handling all supported format_specifiers
@@ -85,6 +141,16 @@ template <class T>
         continue;
       }
 
+      // `%{Type}` takes an enum. The name of its type is only used by the host
+      // to find its enumerators.
+      if (fmt[i] == '{') {
+        std::size_t end = i + 1;
+        while (fmt[end] != '\0' && fmt[end] != '}') end++;
+        if (fmt[end] != '}' || end == i + 1) return false;
+        if (position != nullptr) *position = end + 1;
+        return std::is_enum_v<T>;
+      }
+
       for (const auto& format_spec_handler : format_spec_handlers) {
         for (uint32_t size_index = 0;
              size_index < format_spec_handler.size_handlers.num; size_index++) {
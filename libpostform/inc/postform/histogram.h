@@ -0,0 +1,107 @@
+
+#ifndef POSTFORM_HISTOGRAM_H_
+#define POSTFORM_HISTOGRAM_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "postform/logger.h"
+#include "postform/types.h"
+
+namespace Postform {
+
+/**
+ * @brief Histogram of 32-bit samples accumulated in RAM.
+ *
+ * Samples are counted in log-linear buckets: values below 2^SUB_BUCKET_BITS
+ * get a bucket each, and every power of two above them is split in
+ * 2^SUB_BUCKET_BITS buckets of the same width. The relative error of a sample
+ * is then below 2^-SUB_BUCKET_BITS (12.5% by default), and the bucket of a
+ * sample is found with a count of leading zeros and a few shifts, without
+ * floating point.
+ *
+ * Recording a sample is lock-free and can be done from interrupt handlers.
+ * The counts are written to a logger as a single record, either on demand
+ * with flush or periodically with poll, and reset afterwards.
+ *
+ * ```
+ * Postform::Histogram<> isr_latency{"isr_latency"_intern_histogram,
+ *                                   TIMESTAMP_FREQUENCY};
+ * isr_latency.record(cycles);
+ * isr_latency.poll(&logger);
+ * ```
+ */
+template <uint8_t SUB_BUCKET_BITS = 3>
+class Histogram {
+  static_assert(SUB_BUCKET_BITS > 0 && SUB_BUCKET_BITS < 8,
+                "Invalid number of sub-bucket bits");
+
+ public:
+  //! Number of buckets needed to hold any 32-bit sample
+  static constexpr std::size_t NUM_BUCKETS = (33U - SUB_BUCKET_BITS)
+                                             << SUB_BUCKET_BITS;
+
+  /**
+   * @brief Creates an empty histogram.
+   * @param name interned name of the histogram, declared with the
+   * _intern_histogram literal.
+   * @param flush_period time between records written by poll, in ticks of
+   * the global timestamp.
+   */
+  explicit Histogram(InternedString name, uint64_t flush_period = 0)
+      : m_name(name), m_flush_period(flush_period) {}
+
+  /**
+   * @brief Returns the bucket of a sample.
+   */
+  static constexpr std::size_t bucketOf(uint32_t value) {
+    if (value < (1U << SUB_BUCKET_BITS)) {
+      return value;
+    }
+    const uint32_t exponent = 31U - __builtin_clz(value);
+    const uint32_t shift = exponent - SUB_BUCKET_BITS;
+    const uint32_t sub_bucket =
+        (value >> shift) & ((1U << SUB_BUCKET_BITS) - 1);
+    return ((shift + 1U) << SUB_BUCKET_BITS) | sub_bucket;
+  }
+
+  /**
+   * @brief Adds a sample to the histogram.
+   */
+  void record(uint32_t value) {
+    m_counts[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Writes the counts of the histogram to the logger and resets them.
+   */
+  template <class Logger>
+  void flush(Logger* logger) {
+    m_last_flush = getGlobalTimestamp();
+    logger->histogram(m_name, SUB_BUCKET_BITS, m_counts, NUM_BUCKETS);
+  }
+
+  /**
+   * @brief Flushes the histogram if the flush period elapsed since the last
+   * time it was flushed.
+   * @return true if the histogram was flushed.
+   */
+  template <class Logger>
+  bool poll(Logger* logger) {
+    if (getGlobalTimestamp() - m_last_flush < m_flush_period) {
+      return false;
+    }
+    flush(logger);
+    return true;
+  }
+
+ private:
+  const InternedString m_name;
+  const uint64_t m_flush_period;
+  uint64_t m_last_flush = 0;
+  std::atomic<uint32_t> m_counts[NUM_BUCKETS] = {};
+};
+
+}  // namespace Postform
+
+#endif  // POSTFORM_HISTOGRAM_H_
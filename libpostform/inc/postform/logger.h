@@ -10,6 +10,7 @@
 #include "postform/args.h"
 #include "postform/format_validator.h"
 #include "postform/types.h"
+#include "postform/utils.h"
 
 namespace Postform {
 
@@ -29,6 +30,16 @@ enum class LogLevel {
   OFF
 };
 
+/**
+ * @brief Kind of a trace event, marking the limits of a span.
+ */
+enum class TraceEvent : uint8_t {
+  //! The span starts
+  BEGIN,
+  //! The span ends
+  END
+};
+
 /**
  * @brief Postform calls this function to obtain the global timestamp.
  * @return the value of the timestamp
@@ -49,6 +60,74 @@ enum class LogLevel {
 extern uint64_t getGlobalTimestamp();
 extern volatile uint32_t dummy;
 
+/**
+ * @brief Counters describing the cost of logging.
+ *
+ * Attach them to a logger with Logger::setStats. They can be read at any
+ * time, written to the logger as gauges with flush or poll, or read by the
+ * host through the debug probe without using any bandwidth when declared
+ * with DECLARE_POSTFORM_STATS.
+ *
+ * Host tools rely on the layout of the counters: seven 32-bit words at the
+ * start of the struct, in declaration order. Tick counts use the global
+ * timestamp and wrap around.
+ */
+struct LoggerStats {
+  //! Records handed to the transport
+  std::atomic<uint32_t> records{0};
+  //! Bytes of the records handed to the transport, before any framing
+  std::atomic<uint32_t> bytes{0};
+  //! Records dropped because the writer was in use or unavailable, e.g. when
+  //! an interrupt handler logs while a thread is writing a record.
+  std::atomic<uint32_t> dropped_busy{0};
+  //! Records dropped by the transport because it was full
+  std::atomic<uint32_t> dropped_full{0};
+  //! Ticks spent waiting for the transport to have room for a record
+  std::atomic<uint32_t> blocked_ticks{0};
+  //! Longest time taken to write a record, in ticks
+  std::atomic<uint32_t> max_record_ticks{0};
+  //! Largest number of bytes pending in the transport buffer
+  std::atomic<uint32_t> buffer_high_water{0};
+
+  /**
+   * @brief Creates zeroed counters.
+   * @param flush_period time between records written by poll, in ticks of
+   * the global timestamp.
+   */
+  explicit LoggerStats(uint64_t flush_period = 0)
+      : m_flush_period(flush_period) {}
+
+  /**
+   * @brief Raises a maximum to the given value if it is larger.
+   */
+  static void updateMax(std::atomic<uint32_t>* maximum, uint32_t value) {
+    uint32_t current = maximum->load(std::memory_order_relaxed);
+    while ((value > current) &&
+           !maximum->compare_exchange_weak(current, value,
+                                           std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * @brief Writes the counters to the logger as gauges named after them,
+   * prefixed by "postform_".
+   */
+  template <class Logger>
+  void flush(Logger* logger);
+
+  /**
+   * @brief Flushes the counters if the flush period elapsed since the last
+   * time they were flushed.
+   * @return true if the counters were flushed.
+   */
+  template <class Logger>
+  bool poll(Logger* logger);
+
+ private:
+  const uint64_t m_flush_period;
+  uint64_t m_last_flush = 0;
+};
+
 /**
  * @brief Base logger class used by Postform.
  *
@@ -59,6 +138,9 @@ extern volatile uint32_t dummy;
  * ```
  * Writer getWriter();
  * ```
+ *
+ * The writer must convert to false when the record can't be written, e.g.
+ * because another record is being written.
  */
 template <class Derived, class Writer>
 class Logger {
@@ -71,7 +153,7 @@ class Logger {
    * @param args arguments to serialize in the log
    */
   template <typename... T>
-  inline void log(LogLevel level, T... args) {
+  inline void log(LogLevel level, const T&... args) {
     if (level < m_level.load(std::memory_order_relaxed)) return;
     const auto arg_array = build_args(args...);
     vlog(arg_array.data(), arg_array.size());
@@ -87,8 +169,109 @@ class Logger {
     m_level.store(level, std::memory_order_relaxed);
   }
 
+  /**
+   * @brief Counts the cost of every record written from now on in stats.
+   * @param stats counters to update, or nullptr to stop counting.
+   *
+   * The counters must outlive the logger or be detached before they are
+   * destroyed.
+   */
+  void setStats(LoggerStats* stats) {
+    m_stats.store(stats, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Returns the counters attached with setStats, if any.
+   */
+  LoggerStats* getStats() const {
+    return m_stats.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief writes a trace event to the transport
+   * @param span interned name of the span. It must be placed in the
+   * ".interned_strings.trace" section, see the POSTFORM_TRACE_* macros.
+   * @param event whether the span begins or ends.
+   *
+   * Trace events are written unless the level of the logger is OFF.
+   */
+  inline void trace(InternedString span, TraceEvent event) {
+    if (m_level.load(std::memory_order_relaxed) == LogLevel::OFF) return;
+    const auto arg_array = build_args(span, static_cast<uint8_t>(event));
+    vlog(arg_array.data(), arg_array.size());
+  }
+
+  /**
+   * @brief writes a counter increment to the transport
+   * @param metric interned name of the counter. See POSTFORM_COUNTER.
+   * @param delta amount added to the counter.
+   *
+   * Metrics are written unless the level of the logger is OFF.
+   */
+  inline void counter(InternedString metric, uint64_t delta) {
+    if (m_level.load(std::memory_order_relaxed) == LogLevel::OFF) return;
+    const auto arg_array = build_args(metric, delta);
+    vlog(arg_array.data(), arg_array.size());
+  }
+
+  /**
+   * @brief writes a gauge sample to the transport
+   * @param metric interned name of the gauge. See POSTFORM_GAUGE.
+   * @param value current value of the gauge.
+   *
+   * Metrics are written unless the level of the logger is OFF.
+   */
+  inline void gauge(InternedString metric, int64_t value) {
+    if (m_level.load(std::memory_order_relaxed) == LogLevel::OFF) return;
+    const auto arg_array = build_args(metric, value);
+    vlog(arg_array.data(), arg_array.size());
+  }
+
+  /**
+   * @brief writes the bucket counts of a histogram to the transport and
+   * resets them.
+   * @param metric interned name of the histogram. See Postform::Histogram.
+   * @param sub_bucket_bits number of bits of the sub-buckets of the histogram.
+   * @param counts counts of each bucket.
+   * @param num_buckets number of buckets.
+   *
+   * Only the buckets with samples are written, as pairs of the distance to
+   * the previous non-empty bucket and the count of the bucket. Samples
+   * recorded while the histogram is written are kept for the next record.
+   * Metrics are written unless the level of the logger is OFF, in which case
+   * the counts are kept.
+   */
+  void histogram(InternedString metric, uint8_t sub_bucket_bits,
+                 std::atomic<uint32_t>* counts, std::size_t num_buckets) {
+    if (m_level.load(std::memory_order_relaxed) == LogLevel::OFF) return;
+    const uint64_t timestamp = getGlobalTimestamp();
+    uint32_t bytes = 0;
+    {
+      Writer writer = static_cast<Derived&>(*this).getWriter();
+      if (!writer) {
+        countDroppedRecord();
+        return;
+      }
+      bytes += writeLeb128(&writer, timestamp);
+      bytes += writeLeb128(&writer, reinterpret_cast<uintptr_t>(metric.str));
+      bytes += writeLeb128(&writer, sub_bucket_bits);
+      std::size_t previous = 0;
+      for (std::size_t i = 0; i < num_buckets; i++) {
+        const uint32_t count =
+            counts[i].exchange(0, std::memory_order_relaxed);
+        if (count != 0) {
+          bytes += writeLeb128(&writer, i - previous);
+          bytes += writeLeb128(&writer, count);
+          previous = i;
+        }
+      }
+    }
+    countRecord(timestamp, bytes);
+  }
+
  private:
   std::atomic<LogLevel> m_level = LogLevel::DEBUG;
+  std::atomic<LoggerStats*> m_stats = nullptr;
 
   /**
    * @brief Creates a log with the supplied arguments.
@@ -97,45 +280,119 @@ class Logger {
    * @param nargs number of arguments to log
    */
   void vlog(const Argument* arguments, std::size_t nargs) {
-    uint64_t timestamp = getGlobalTimestamp();
-
-    Writer writer = static_cast<Derived&>(*this).getWriter();
-    writeLeb128(&writer, timestamp);
-    for (std::size_t i = 0; i < nargs; i++) {
-      switch (arguments[i].type) {
-        case Argument::Type::STRING_POINTER:
-          writer.write(reinterpret_cast<const uint8_t*>(arguments[i].str_ptr),
-                       strlen(arguments[i].str_ptr) + 1);
-          break;
-        case Argument::Type::UNSIGNED_INTEGER: {
-          writeLeb128(&writer, arguments[i].unsigned_long_long);
-          break;
-        }
-        case Argument::Type::SIGNED_INTEGER: {
-          writeLeb128(&writer, arguments[i].signed_long_long);
-          break;
-        }
-        case Argument::Type::INTERNED_STRING: {
-          auto ptr =
-              reinterpret_cast<uintptr_t>(arguments[i].interned_string.str);
-          writeLeb128(&writer, ptr);
-          break;
-        }
-        case Argument::Type::VOID_PTR: {
-          auto ptr = reinterpret_cast<uintptr_t>(arguments[i].void_ptr);
-          writeLeb128(&writer, ptr);
-          break;
+    const uint64_t timestamp = getGlobalTimestamp();
+    uint32_t bytes = 0;
+    {
+      Writer writer = static_cast<Derived&>(*this).getWriter();
+      if (!writer) {
+        countDroppedRecord();
+        return;
+      }
+      bytes += writeLeb128(&writer, timestamp);
+      for (std::size_t i = 0; i < nargs; i++) {
+        switch (arguments[i].type) {
+          case Argument::Type::STRING_POINTER: {
+            const uint32_t size = strlen(arguments[i].str_ptr) + 1;
+            writer.write(
+                reinterpret_cast<const uint8_t*>(arguments[i].str_ptr), size);
+            bytes += size;
+            break;
+          }
+          case Argument::Type::STRING_VIEW: {
+            // The length goes first, so neither side has to look for the end
+            bytes += writeLeb128(&writer, arguments[i].size);
+            writer.write(reinterpret_cast<const uint8_t*>(arguments[i].str_ptr),
+                         arguments[i].size);
+            bytes += arguments[i].size;
+            break;
+          }
+          case Argument::Type::BYTES: {
+            bytes += writeLeb128(&writer, arguments[i].size);
+            writer.write(static_cast<const uint8_t*>(arguments[i].void_ptr),
+                         arguments[i].size);
+            bytes += arguments[i].size;
+            break;
+          }
+          case Argument::Type::UNSIGNED_INTEGER: {
+            bytes += writeLeb128(&writer, arguments[i].unsigned_long_long);
+            break;
+          }
+          case Argument::Type::SIGNED_INTEGER: {
+            bytes += writeLeb128(&writer, arguments[i].signed_long_long);
+            break;
+          }
+          case Argument::Type::INTERNED_STRING: {
+            auto ptr =
+                reinterpret_cast<uintptr_t>(arguments[i].interned_string.str);
+            bytes += writeLeb128(&writer, ptr);
+            break;
+          }
+          case Argument::Type::VOID_PTR: {
+            auto ptr = reinterpret_cast<uintptr_t>(arguments[i].void_ptr);
+            bytes += writeLeb128(&writer, ptr);
+            break;
+          }
+          case Argument::Type::SIGNED_ARRAY:
+          case Argument::Type::UNSIGNED_ARRAY: {
+            bytes += writeArray(&writer, arguments[i]);
+            break;
+          }
+          case Argument::Type::FLOATING_POINT: {
+            if (arguments[i].size == sizeof(float)) {
+              uint32_t bits;
+              memcpy(&bits, &arguments[i].float_value, sizeof(bits));
+              bytes += writeLittleEndian(&writer, bits);
+            } else {
+              uint64_t bits;
+              memcpy(&bits, &arguments[i].double_value, sizeof(bits));
+              bytes += writeLittleEndian(&writer, bits);
+            }
+            break;
+          }
         }
       }
     }
+    countRecord(timestamp, bytes);
+  }
+
+  /**
+   * @brief Counts a record that was handed to the transport.
+   * @param timestamp timestamp of the record, taken before writing it.
+   * @param bytes size of the record.
+   */
+  void countRecord(uint64_t timestamp, uint32_t bytes) {
+    LoggerStats* stats = m_stats.load(std::memory_order_relaxed);
+    if (stats == nullptr) return;
+    stats->records.fetch_add(1, std::memory_order_relaxed);
+    stats->bytes.fetch_add(bytes, std::memory_order_relaxed);
+    LoggerStats::updateMax(&stats->max_record_ticks,
+                           getGlobalTimestamp() - timestamp);
+  }
+
+  void countDroppedRecord() {
+    LoggerStats* stats = m_stats.load(std::memory_order_relaxed);
+    if (stats == nullptr) return;
+    stats->dropped_busy.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  template <class T, std::enable_if_t<std::is_integral_v<T>, bool> = true>
+  uint32_t writeLeb128(Writer* writer, T value) {
+    constexpr std::size_t MAX_BUF_SIZE = (sizeof(T) * 8 + 6) / 7;
+    uint8_t buffer[MAX_BUF_SIZE];
+    const uint32_t number_of_bytes = encodeLeb128(value, buffer);
+    writer->write(buffer, number_of_bytes);
+    return number_of_bytes;
   }
 
+  /**
+   * @brief Encodes a value as LEB128 into buffer, which must fit
+   * (sizeof(T) * 8 + 6) / 7 bytes.
+   * @return the number of bytes of the encoded value.
+   */
   template <class T,
             std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T>,
                              bool> = true>
-  void writeLeb128(Writer* writer, T value) {
-    constexpr std::size_t MAX_BUF_SIZE = (sizeof(T) * 8 + 6) / 7;
-    uint8_t buffer[MAX_BUF_SIZE];
+  static uint32_t encodeLeb128(T value, uint8_t* buffer) {
     uint32_t number_of_bytes = 0;
 
     do {
@@ -147,16 +404,14 @@ class Logger {
       number_of_bytes++;
     } while (value);
 
-    writer->write(buffer, number_of_bytes);
+    return number_of_bytes;
   }
 
   template <class T,
             std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>,
                              bool> = true>
-  void writeLeb128(Writer* writer, T value) {
-    constexpr std::size_t MAX_BUF_SIZE = (sizeof(T) * 8 + 6) / 7;
+  static uint32_t encodeLeb128(T value, uint8_t* buffer) {
     const bool negative = value < 0;
-    uint8_t buffer[MAX_BUF_SIZE];
     uint32_t number_of_bytes = 0;
 
     bool done = false;
@@ -176,12 +431,127 @@ class Logger {
       number_of_bytes++;
     } while (!done);
 
-    writer->write(buffer, number_of_bytes);
+    return number_of_bytes;
+  }
+
+  /**
+   * @brief Writes the number of elements of an array argument followed by
+   * its elements as varints.
+   *
+   * Elements are widened to 64 bits, so that arrays of every type share the
+   * same code, and packed into a buffer to write them in a few chunks.
+   */
+  uint32_t writeArray(Writer* writer, const Argument& argument) {
+    constexpr std::size_t MAX_VARINT_SIZE = 10;
+    uint8_t buffer[8 * MAX_VARINT_SIZE];
+    std::size_t used = 0;
+    uint32_t bytes = writeLeb128(writer, argument.size);
+    const auto* data = static_cast<const uint8_t*>(argument.array.data);
+    const uint8_t element_size = argument.array.element_size;
+    const bool is_signed = argument.type == Argument::Type::SIGNED_ARRAY;
+    for (std::size_t i = 0; i < argument.size; i++) {
+      if (used + MAX_VARINT_SIZE > sizeof(buffer)) {
+        writer->write(buffer, used);
+        bytes += used;
+        used = 0;
+      }
+      const uint8_t* element = &data[i * element_size];
+      if (is_signed) {
+        used += encodeLeb128(loadSigned(element, element_size), &buffer[used]);
+      } else {
+        used +=
+            encodeLeb128(loadUnsigned(element, element_size), &buffer[used]);
+      }
+    }
+    writer->write(buffer, used);
+    return bytes + used;
+  }
+
+  static uint64_t loadUnsigned(const uint8_t* element, uint8_t size) {
+    switch (size) {
+      case 1:
+        return *element;
+      case 2: {
+        uint16_t value;
+        memcpy(&value, element, sizeof(value));
+        return value;
+      }
+      case 4: {
+        uint32_t value;
+        memcpy(&value, element, sizeof(value));
+        return value;
+      }
+      default: {
+        uint64_t value;
+        memcpy(&value, element, sizeof(value));
+        return value;
+      }
+    }
+  }
+
+  static int64_t loadSigned(const uint8_t* element, uint8_t size) {
+    switch (size) {
+      case 1:
+        return static_cast<int8_t>(*element);
+      case 2: {
+        int16_t value;
+        memcpy(&value, element, sizeof(value));
+        return value;
+      }
+      case 4: {
+        int32_t value;
+        memcpy(&value, element, sizeof(value));
+        return value;
+      }
+      default: {
+        int64_t value;
+        memcpy(&value, element, sizeof(value));
+        return value;
+      }
+    }
+  }
+
+  /**
+   * @brief Writes the raw bits of a floating point argument. They are sent as
+   * they are, leaving the formatting to the host.
+   */
+  template <class T>
+  uint32_t writeLittleEndian(Writer* writer, T value) {
+    uint8_t buffer[sizeof(T)];
+    for (std::size_t i = 0; i < sizeof(T); i++) {
+      buffer[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    writer->write(buffer, sizeof(T));
+    return sizeof(T);
   }
 
   friend class LoggerTest;
 };
 
+/**
+ * @brief Traces a span for the lifetime of the object.
+ *
+ * The span begins when the object is constructed and ends when it is
+ * destroyed. Use it through POSTFORM_TRACE_SCOPE.
+ */
+template <class Logger>
+class TraceScope {
+ public:
+  TraceScope(Logger* logger, InternedString span)
+      : m_logger(logger), m_span(span) {
+    m_logger->trace(m_span, TraceEvent::BEGIN);
+  }
+
+  ~TraceScope() { m_logger->trace(m_span, TraceEvent::END); }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  Logger* const m_logger;
+  const InternedString m_span;
+};
+
 /**
  * @brief Struct template representing an interned debug string.
  *
@@ -262,6 +632,56 @@ struct InternedUserString {
 template <char... N>
 constexpr char InternedUserString<N...>::string[];
 
+/**
+ * @brief Struct template representing the interned name of a trace span.
+ *
+ * Instantiates a string constant in the ".interned_strings.trace" section.
+ * Spans with the same name share the same string, so the begin and end events
+ * of a span carry the same ID. This section is not used in runtime, only used
+ * as debug information for Postform
+ */
+template <char... N>
+struct InternedTraceString {
+  __attribute__((
+      section(".interned_strings.trace"))) static constexpr char string[]{N...};
+};
+
+template <char... N>
+constexpr char InternedTraceString<N...>::string[];
+
+/**
+ * @brief Struct template representing the interned name of a metric.
+ *
+ * Instantiates a string constant in the ".interned_strings.metric" section.
+ * The string is the kind of the metric ('c' for counters, 'g' for gauges and
+ * 'h' for histograms), followed by '@' and the name of the metric. This
+ * section is not used in runtime, only used as debug information for Postform
+ */
+template <char... N>
+struct InternedMetricString {
+  __attribute__((section(
+      ".interned_strings.metric"))) static constexpr char string[]{N...};
+};
+
+template <char... N>
+constexpr char InternedMetricString<N...>::string[];
+
+/**
+ * @brief Describes the hit counter of a log call site.
+ *
+ * Every LOG_* macro counts how many times it is reached, even when its level
+ * is filtered out. The counter is zero-initialized in the
+ * ".bss.postform_counters" section, and its description is placed in the
+ * ".postform_counters" section. This section is not used in runtime, only used
+ * by the host to find the counter of each call site in a memory dump.
+ */
+struct CallSiteCounter {
+  //! Number of times the call site was reached
+  std::atomic<uint32_t>* hits;
+  //! Interned format string of the call site
+  const char* format;
+};
+
 }  // namespace Postform
 
 /**
@@ -324,13 +744,106 @@ constexpr Postform::InternedString operator""_intern() {
       Postform::InternedUserString<chars..., '\0'>::string};
 }
 
-#define __POSTFORM_LOG(level, intern_mode, logger, fmt, ...)    \
-  {                                                             \
-    POSTFORM_ASSERT_FORMAT(fmt, ##__VA_ARGS__);                 \
-    (logger)->log(level,                                        \
-                  __FILE__ "@" __POSTFORM_EXPAND_AND_STRINGIFY( \
-                      __LINE__) "@" fmt##intern_mode,           \
-                  ##__VA_ARGS__);                               \
+/**
+ * @brief variadic template user defined literal to declare the interned name
+ * of a trace span.
+ *
+ * This is currently only supported by clang.
+ */
+template <typename T, T... chars>
+constexpr Postform::InternedString operator""_intern_trace() {
+  return Postform::InternedString{
+      Postform::InternedTraceString<chars..., '\0'>::string};
+}
+
+/**
+ * @brief variadic template user defined literal to declare the interned name
+ * of a counter.
+ *
+ * This is currently only supported by clang.
+ */
+template <typename T, T... chars>
+constexpr Postform::InternedString operator""_intern_counter() {
+  return Postform::InternedString{
+      Postform::InternedMetricString<'c', '@', chars..., '\0'>::string};
+}
+
+/**
+ * @brief variadic template user defined literal to declare the interned name
+ * of a gauge.
+ *
+ * This is currently only supported by clang.
+ */
+template <typename T, T... chars>
+constexpr Postform::InternedString operator""_intern_gauge() {
+  return Postform::InternedString{
+      Postform::InternedMetricString<'g', '@', chars..., '\0'>::string};
+}
+
+/**
+ * @brief variadic template user defined literal to declare the interned name
+ * of a histogram.
+ *
+ * This is currently only supported by clang.
+ */
+template <typename T, T... chars>
+constexpr Postform::InternedString operator""_intern_histogram() {
+  return Postform::InternedString{
+      Postform::InternedMetricString<'h', '@', chars..., '\0'>::string};
+}
+
+namespace Postform {
+
+template <class Logger>
+void LoggerStats::flush(Logger* logger) {
+  m_last_flush = getGlobalTimestamp();
+  const auto load = [](const std::atomic<uint32_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+  };
+  logger->gauge("postform_records"_intern_gauge, load(records));
+  logger->gauge("postform_bytes"_intern_gauge, load(bytes));
+  logger->gauge("postform_dropped_busy"_intern_gauge, load(dropped_busy));
+  logger->gauge("postform_dropped_full"_intern_gauge, load(dropped_full));
+  logger->gauge("postform_blocked_ticks"_intern_gauge, load(blocked_ticks));
+  logger->gauge("postform_max_record_ticks"_intern_gauge,
+                load(max_record_ticks));
+  logger->gauge("postform_buffer_high_water"_intern_gauge,
+                load(buffer_high_water));
+}
+
+template <class Logger>
+bool LoggerStats::poll(Logger* logger) {
+  if (getGlobalTimestamp() - m_last_flush < m_flush_period) {
+    return false;
+  }
+  flush(logger);
+  return true;
+}
+
+}  // namespace Postform
+
+#if defined(POSTFORM_NO_CALL_SITE_COUNTERS)
+#define __POSTFORM_COUNT_HIT(format)
+#else
+#define __POSTFORM_COUNT_HIT(format)                               \
+  {                                                                \
+    __attribute__((section(".bss.postform_counters")))             \
+    static std::atomic<uint32_t> __postform_hits{0};               \
+    __attribute__((section(".postform_counters"), used))           \
+    static constexpr Postform::CallSiteCounter __postform_counter{ \
+        &__postform_hits, (format).str};                           \
+    __postform_hits.fetch_add(1, std::memory_order_relaxed);       \
+  }
+#endif
+
+#define __POSTFORM_LOG(level, intern_mode, logger, fmt, ...) \
+  {                                                          \
+    POSTFORM_ASSERT_FORMAT(fmt, ##__VA_ARGS__);              \
+    constexpr Postform::InternedString __postform_format =   \
+        __FILE__ "@" __POSTFORM_EXPAND_AND_STRINGIFY(        \
+            __LINE__) "@" fmt##intern_mode;                  \
+    __POSTFORM_COUNT_HIT(__postform_format);                 \
+    (logger)->log(level, __postform_format, ##__VA_ARGS__);  \
   }
 
 /**
@@ -358,4 +871,44 @@ constexpr Postform::InternedString operator""_intern() {
   __POSTFORM_LOG(Postform::LogLevel::ERROR, _intern_error, logger, fmt, \
                  ##__VA_ARGS__)
 
+/**
+ * @brief Macro marking the beginning of a trace span
+ */
+#define POSTFORM_TRACE_BEGIN(logger, name) \
+  (logger)->trace(name##_intern_trace, Postform::TraceEvent::BEGIN)
+/**
+ * @brief Macro marking the end of a trace span
+ */
+#define POSTFORM_TRACE_END(logger, name) \
+  (logger)->trace(name##_intern_trace, Postform::TraceEvent::END)
+/**
+ * @brief Macro tracing a span until the end of the current scope
+ */
+#define POSTFORM_TRACE_SCOPE(logger, name)                               \
+  Postform::TraceScope POSTFORM_CAT(__postform_trace_scope_, __LINE__) { \
+    (logger), name##_intern_trace                                        \
+  }
+
+/**
+ * @brief Macro adding delta to a counter metric
+ */
+#define POSTFORM_COUNTER(logger, name, delta) \
+  (logger)->counter(name##_intern_counter, (delta))
+/**
+ * @brief Macro sampling the value of a gauge metric
+ */
+#define POSTFORM_GAUGE(logger, name, value) \
+  (logger)->gauge(name##_intern_gauge, (value))
+
+/**
+ * @brief Declares the logger stats of your application
+ *
+ * The stats are placed in the `_postform_stats` symbol, where postform_rtt
+ * reads them through the debug probe. Attach them to the logger with
+ * `logger.setStats(&_postform_stats)`.
+ */
+#define DECLARE_POSTFORM_STATS(flush_period) \
+  CLINKAGE __attribute__((used))             \
+  Postform::LoggerStats _postform_stats { (flush_period) }
+
 #endif  // POSTFORM_LOGGER_H_
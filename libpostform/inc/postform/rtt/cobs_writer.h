@@ -8,6 +8,8 @@
 #include "postform/rtt/rtt.h"
 
 namespace Postform {
+struct LoggerStats;
+
 namespace Rtt {
 class Manager;
 
@@ -29,23 +31,38 @@ class CobsWriter {
  private:
   Manager* m_manager = nullptr;
   Channel* m_channel = nullptr;
+  LoggerStats* m_stats = nullptr;
   uint32_t m_write_ptr = 0;
   uint32_t m_marker_ptr = 0;
-
-  CobsWriter(Manager* rtt, Channel* channel);
-
-  inline void blockUntilNotFull() {
-    if (m_channel->flags.load(std::memory_order_relaxed) !=
-        Rtt::Flags::BLOCK_IF_FULL) {
-      return;
+  //! Set when the channel filled up in NO_BLOCK_TRIM mode. The rest of the
+  //! record is discarded and it is never published.
+  bool m_dropped = false;
+
+  CobsWriter(Manager* rtt, Channel* channel, LoggerStats* stats);
+  void waitForReader(uint32_t next_write_ptr);
+  void updateHighWater();
+
+  /**
+   * @brief Makes sure the next byte can be written without overwriting
+   * unread data.
+   * @return false if the record has been dropped because the channel is full
+   * and doesn't block.
+   */
+  inline bool makeRoom() {
+    if (m_dropped) {
+      return false;
     }
     const uint32_t next_write_ptr = nextWritePtr();
-    if (m_channel->read.load(std::memory_order_acquire) == next_write_ptr) {
-      m_channel->write.store(m_marker_ptr, std::memory_order_release);
-      while (m_channel->read.load(std::memory_order_relaxed) ==
-             next_write_ptr) {
-      }
+    if (m_channel->read.load(std::memory_order_acquire) != next_write_ptr) {
+      return true;
+    }
+    if (m_channel->flags.load(std::memory_order_relaxed) ==
+        Rtt::Flags::BLOCK_IF_FULL) {
+      waitForReader(next_write_ptr);
+      return true;
     }
+    m_dropped = true;
+    return false;
   }
 
   inline uint8_t markerDistance() {
@@ -3,6 +3,7 @@
 #define POSTFORM_RTT_RTT_H_
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 
@@ -11,13 +12,22 @@ namespace Rtt {
 
 enum class Flags : uint32_t { BLOCK_IF_FULL = 2, NO_BLOCK_TRIM = 1 };
 
+#if defined(__linux__)
+// On the host the control block lives in shared memory and the reader runs on
+// another core. Keeping each index in its own cache line avoids false sharing.
+constexpr std::size_t INDEX_ALIGNMENT = 64;
+#else
+// On target the layout must match the one expected by the RTT tooling.
+constexpr std::size_t INDEX_ALIGNMENT = alignof(std::uint32_t);
+#endif
+
 struct Channel {
   const char* const name{nullptr};
   std::uint8_t* const buffer = nullptr;
   const std::uint32_t size{0};
-  std::atomic<std::uint32_t> write{0};
-  std::atomic<std::uint32_t> read{0};
-  std::atomic<Flags> flags{Flags::NO_BLOCK_TRIM};
+  alignas(INDEX_ALIGNMENT) std::atomic<std::uint32_t> write{0};
+  alignas(INDEX_ALIGNMENT) std::atomic<std::uint32_t> read{0};
+  alignas(INDEX_ALIGNMENT) std::atomic<Flags> flags{Flags::NO_BLOCK_TRIM};
 
   Channel(const char* name, std::uint8_t* buffer, std::uint32_t size)
       : name(name), buffer(buffer), size(size) {}
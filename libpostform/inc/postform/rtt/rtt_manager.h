@@ -11,6 +11,16 @@
 
 namespace Postform {
 namespace Rtt {
+
+/**
+ * @brief Returns the control block used by the RTT manager.
+ *
+ * On target this is the `_SEGGER_RTT` symbol found by the debug probe. Host
+ * builds place it in a POSIX shared-memory segment instead (see
+ * `postform/rtt/shm_segment.h`).
+ */
+ControlBlock& getControlBlock();
+
 class Manager {
  public:
   static Manager& getInstance() {
@@ -19,7 +29,14 @@ class Manager {
   }
 
   RawWriter getRawWriter();
-  CobsWriter getCobsWriter();
+
+  /**
+   * @brief Returns a writer for the up channel, or an invalid one if another
+   * writer is in use.
+   * @param stats counters updated with the time the writer waits for the
+   * host and the buffer high-water mark, if not null.
+   */
+  CobsWriter getCobsWriter(LoggerStats* stats = nullptr);
 
  private:
   std::atomic<bool> m_taken{false};
@@ -0,0 +1,78 @@
+
+#ifndef POSTFORM_RTT_SHM_SEGMENT_H_
+#define POSTFORM_RTT_SHM_SEGMENT_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "postform/rtt/rtt.h"
+
+namespace Postform {
+namespace Rtt {
+
+/**
+ * @brief Describes the layout of the RTT shared-memory segment.
+ *
+ * The control block contains pointers that are only valid in the process that
+ * created it, so readers attaching to the segment locate the up channel
+ * through the offsets stored here, relative to the start of the segment.
+ *
+ * The magic number is written last, once the rest of the segment has been
+ * initialized.
+ */
+struct ShmDescriptor {
+  constexpr static std::uint32_t MAGIC = 0x54524650;  // "PFRT"
+
+  std::atomic<std::uint32_t> magic{0};
+  std::uint32_t segment_size{0};
+  std::uint32_t up_buffer_offset{0};
+  std::uint32_t up_buffer_size{0};
+  std::uint32_t up_write_offset{0};
+  std::uint32_t up_read_offset{0};
+  std::uint32_t up_flags_offset{0};
+};
+
+/**
+ * @brief Shared-memory segment holding the RTT control block on the host.
+ */
+struct ShmSegment {
+  constexpr static std::uint32_t UP_BUFFER_SIZE = 64 * 1024;
+  constexpr static std::uint32_t DOWN_BUFFER_SIZE = 16;
+
+  ShmDescriptor descriptor;
+  ControlBlock control_block;
+  std::uint8_t up_buffer[UP_BUFFER_SIZE];
+  std::uint8_t down_buffer[DOWN_BUFFER_SIZE];
+
+  ShmSegment()
+      : control_block(up_buffer, UP_BUFFER_SIZE, down_buffer,
+                      DOWN_BUFFER_SIZE) {
+    descriptor.segment_size = sizeof(ShmSegment);
+    descriptor.up_buffer_offset = offsetOf(up_buffer);
+    descriptor.up_buffer_size = UP_BUFFER_SIZE;
+    descriptor.up_write_offset = offsetOf(&control_block.up_channel.write);
+    descriptor.up_read_offset = offsetOf(&control_block.up_channel.read);
+    descriptor.up_flags_offset = offsetOf(&control_block.up_channel.flags);
+    descriptor.magic.store(ShmDescriptor::MAGIC, std::memory_order_release);
+  }
+
+  ShmSegment(const ShmSegment&) = delete;
+  ShmSegment& operator=(const ShmSegment&) = delete;
+
+ private:
+  std::uint32_t offsetOf(const void* member) const {
+    return static_cast<const std::uint8_t*>(member) -
+           reinterpret_cast<const std::uint8_t*>(this);
+  }
+};
+
+/**
+ * @brief Name of the shared-memory segment used when the
+ * POSTFORM_RTT_SHM_NAME environment variable is not set.
+ */
+constexpr static char DEFAULT_SHM_NAME[] = "/postform_rtt";
+
+}  // namespace Rtt
+}  // namespace Postform
+
+#endif  // POSTFORM_RTT_SHM_SEGMENT_H_
@@ -15,7 +15,7 @@ class RttLogger : public Logger<RttLogger, Rtt::CobsWriter> {
  private:
   Rtt::CobsWriter getWriter() {
     auto& manager = Rtt::Manager::getInstance();
-    return manager.getCobsWriter();
+    return manager.getCobsWriter(getStats());
   }
 
   friend Logger<RttLogger, Rtt::CobsWriter>;
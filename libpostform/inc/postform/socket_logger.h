@@ -0,0 +1,118 @@
+
+#ifndef POSTFORM_SOCKET_LOGGER_H_
+#define POSTFORM_SOCKET_LOGGER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "postform/logger.h"
+
+namespace Postform {
+
+class SocketLogger;
+
+/**
+ * @brief Writer used by the SocketLogger.
+ *
+ * Serializes the record directly into the batch of the logger. Records use
+ * the same framing as the FileWriter: the size of the record as a native
+ * u32, followed by the record itself.
+ */
+class SocketWriter {
+ public:
+  SocketWriter() = default;
+
+  void write(const uint8_t* data, uint32_t size);
+  void commit();
+
+  SocketWriter(const SocketWriter&) = delete;
+  SocketWriter& operator=(const SocketWriter&) = delete;
+
+  SocketWriter(SocketWriter&&);
+  SocketWriter& operator=(SocketWriter&&);
+  ~SocketWriter() { commit(); }
+
+  operator bool() { return m_logger != nullptr; }
+
+ private:
+  SocketLogger* m_logger = nullptr;
+  std::size_t m_record_start = 0;
+
+  SocketWriter(SocketLogger* logger, std::size_t record_start)
+      : m_logger(logger), m_record_start(record_start) {}
+  friend class SocketLogger;
+};
+
+/**
+ * @brief Streams logs to a collector process over a Unix-domain or TCP
+ * socket.
+ *
+ * The address is either `unix:<path>` or `tcp:<ipv4 address>:<port>`.
+ * Records are batched and sent once the batch reaches SEND_THRESHOLD bytes,
+ * or when flush() is called. Call flush() whenever logs need to reach the
+ * collector without waiting for more records.
+ *
+ * If the connection cannot be established all logs are dropped.
+ *
+ * When stats are attached, records dropped in DROP_IF_FULL mode are counted
+ * as dropped_full, the batched bytes pending to be sent as the buffer
+ * high-water mark and the time spent in blocking sends as blocked time.
+ */
+class SocketLogger : public Logger<SocketLogger, SocketWriter> {
+ public:
+  enum class Mode {
+    //! Waits for the collector to accept the data.
+    BLOCK_IF_FULL,
+    //! Drops records while the collector is slow, counting them.
+    DROP_IF_FULL
+  };
+
+  //! Batch size that triggers a send.
+  constexpr static std::size_t SEND_THRESHOLD = 64 * 1024;
+  //! Maximum amount of unsent data before records are dropped.
+  constexpr static std::size_t MAX_PENDING = 1024 * 1024;
+
+  explicit SocketLogger(const std::string& address,
+                        Mode mode = Mode::BLOCK_IF_FULL);
+  ~SocketLogger();
+
+  SocketLogger(const SocketLogger&) = delete;
+  SocketLogger& operator=(const SocketLogger&) = delete;
+
+  /**
+   * @brief Sends all batched records.
+   *
+   * In DROP_IF_FULL mode this only sends what the socket accepts without
+   * blocking.
+   */
+  void flush();
+
+  /**
+   * @brief Returns the number of records dropped so far, either because the
+   * collector was slow or because another writer was in use.
+   */
+  uint64_t getDroppedRecords() const {
+    return m_dropped.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic_bool m_taken{false};
+  std::atomic<uint64_t> m_dropped{0};
+  int m_fd = -1;
+  Mode m_mode;
+  std::vector<uint8_t> m_batch;
+  std::size_t m_sent = 0;
+
+  SocketWriter getWriter();
+  void commit(std::size_t record_start);
+  void send();
+
+  friend Logger<SocketLogger, SocketWriter>;
+  friend class SocketWriter;
+};
+
+}  // namespace Postform
+
+#endif  // POSTFORM_SOCKET_LOGGER_H_
@@ -2,6 +2,10 @@
 #ifndef POSTFORM_TYPES_H_
 #define POSTFORM_TYPES_H_
 
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
 namespace Postform {
 
 /**
@@ -14,6 +18,77 @@ struct InternedString {
   const char* str;
 };
 
+/**
+ * @brief A binary buffer, logged with `%*b` as hex bytes or with `%*B` as a
+ * hexdump.
+ *
+ * The length is sent first, followed by the contents of the buffer in a single
+ * write.
+ */
+struct Bytes {
+  constexpr Bytes() = default;
+  constexpr Bytes(const void* buffer, std::size_t length)
+      : data(buffer), size(length) {}
+  template <class T, std::size_t N>
+  constexpr explicit Bytes(const T (&array)[N])
+      : data(array), size(sizeof(array)) {}
+
+  const void* data = nullptr;
+  std::size_t size = 0;
+};
+
+/**
+ * @brief A view of an array of integers, logged with `%*d`, `%*i`, `%*u`,
+ * `%*o` or `%*x` as a list.
+ *
+ * The number of elements is sent first, followed by every element as a
+ * varint, so the size of the elements doesn't need to be in the format
+ * string. `std::array`s of integers can be logged directly.
+ */
+template <class T>
+struct Span {
+  static_assert(std::is_integral_v<T>, "Only arrays of integers are supported");
+
+  constexpr Span() = default;
+  constexpr Span(const T* elements, std::size_t count)
+      : data(elements), size(count) {}
+  template <std::size_t N>
+  constexpr Span(const T (&array)[N]) : data(array), size(N) {}
+  template <std::size_t N>
+  constexpr Span(const std::array<T, N>& array)
+      : data(array.data()), size(N) {}
+
+  const T* data = nullptr;
+  std::size_t size = 0;
+};
+
+template <class T, std::size_t N>
+Span(const T (&)[N]) -> Span<T>;
+template <class T, std::size_t N>
+Span(const std::array<T, N>&) -> Span<T>;
+
+/**
+ * @brief Type of the elements of an array argument, or void if T is not an
+ * array argument.
+ */
+template <class T>
+struct ArrayElement {
+  using type = void;
+};
+
+template <class T>
+struct ArrayElement<Span<T>> {
+  using type = T;
+};
+
+template <class T, std::size_t N>
+struct ArrayElement<std::array<T, N>> {
+  using type = std::enable_if_t<std::is_integral_v<T>, T>;
+};
+
+template <class T>
+using ArrayElementT = typename ArrayElement<std::decay_t<T>>::type;
+
 }  // namespace Postform
 
 #endif  // POSTFORM_TYPES_H_
@@ -18,6 +18,42 @@ static_assert(POSTFORM_VALIDATE_FORMAT("%x", 12));
 
 static_assert(POSTFORM_VALIDATE_FORMAT("%d", -123));
 
+static_assert(POSTFORM_VALIDATE_FORMAT("%f %e %g", 1.0f, 2.0f, 3.0f));
+static_assert(POSTFORM_VALIDATE_FORMAT("%lf %le %lg", 1.0, 2.0, 3.0));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%f", 1.0));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%lf", 1.0f));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%f", 1));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%d", 1.0f));
+
+static_assert(POSTFORM_VALIDATE_FORMAT("%.*s", std::string_view{"view"}));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%s", std::string_view{"view"}));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%.*s", "not a view"));
+
+static_assert(POSTFORM_VALIDATE_FORMAT("%*b %*B", Postform::Bytes(),
+                                       Postform::Bytes()));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%*b", "not bytes"));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%p", Postform::Bytes()));
+
+static_assert(POSTFORM_VALIDATE_FORMAT("%*d %*u %*x", Postform::Span<int16_t>(),
+                                       Postform::Span<uint8_t>(),
+                                       Postform::Span<uint64_t>()));
+using SignedArray = std::array<int, 8>;
+using UnsignedArray = std::array<unsigned, 2>;
+static_assert(POSTFORM_VALIDATE_FORMAT("%*i", SignedArray()));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%*u", Postform::Span<int>()));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%*d", UnsignedArray()));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%*x", Postform::Span<int>()));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%*u", 1u));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%u", Postform::Span<unsigned>()));
+
+enum class State : uint8_t { kIdle };
+enum Mode { kRun = -1 };
+static_assert(POSTFORM_VALIDATE_FORMAT("%{State} %{Mode}", State::kIdle, kRun));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%{State}", 0));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%d", State::kIdle));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%{}", State::kIdle));
+static_assert(!POSTFORM_VALIDATE_FORMAT("%{State", State::kIdle));
+
 // Compile-time tests for the POSTFORM_ASSERT_FORMAT
 POSTFORM_ASSERT_FORMAT("%u %u", 2u, 1u);
 POSTFORM_ASSERT_FORMAT("%s", "random_str");
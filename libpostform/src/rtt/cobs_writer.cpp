@@ -3,18 +3,22 @@
 
 #include <atomic>
 
+#include "postform/logger.h"
 #include "postform/rtt/rtt_manager.h"
 
 namespace Postform {
 
-Rtt::CobsWriter::CobsWriter(Rtt::Manager* manager, Rtt::Channel* channel)
+Rtt::CobsWriter::CobsWriter(Rtt::Manager* manager, Rtt::Channel* channel,
+                            LoggerStats* stats)
     : m_manager(manager),
       m_channel(channel),
+      m_stats(stats),
       m_write_ptr(channel->write.load(std::memory_order_relaxed)),
       m_marker_ptr(m_write_ptr) {
-  blockUntilNotFull();
-  m_channel->buffer[m_write_ptr] = 0;
-  m_write_ptr = nextWritePtr();
+  if (makeRoom()) {
+    m_channel->buffer[m_write_ptr] = 0;
+    m_write_ptr = nextWritePtr();
+  }
 }
 
 Rtt::CobsWriter::~CobsWriter() { commit(); }
@@ -22,13 +26,17 @@ Rtt::CobsWriter::~CobsWriter() { commit(); }
 Rtt::CobsWriter::CobsWriter(CobsWriter&& other) {
   m_manager = other.m_manager;
   m_channel = other.m_channel;
+  m_stats = other.m_stats;
   m_write_ptr = other.m_write_ptr;
   m_marker_ptr = other.m_marker_ptr;
+  m_dropped = other.m_dropped;
 
   other.m_manager = nullptr;
   other.m_channel = nullptr;
+  other.m_stats = nullptr;
   other.m_write_ptr = 0;
   other.m_marker_ptr = 0;
+  other.m_dropped = false;
 }
 
 Rtt::CobsWriter& Rtt::CobsWriter::operator=(CobsWriter&& other) {
@@ -37,13 +45,17 @@ Rtt::CobsWriter& Rtt::CobsWriter::operator=(CobsWriter&& other) {
 
     m_manager = other.m_manager;
     m_channel = other.m_channel;
+    m_stats = other.m_stats;
     m_write_ptr = other.m_write_ptr;
     m_marker_ptr = other.m_marker_ptr;
+    m_dropped = other.m_dropped;
 
     other.m_manager = nullptr;
     other.m_channel = nullptr;
+    other.m_stats = nullptr;
     other.m_write_ptr = 0;
     other.m_marker_ptr = 0;
+    other.m_dropped = false;
   }
   return *this;
 }
@@ -54,7 +66,9 @@ void Rtt::CobsWriter::write(const uint8_t* data, uint32_t size) {
   }
 
   for (uint32_t i = 0; i < size; i++) {
-    blockUntilNotFull();
+    if (!makeRoom()) {
+      return;
+    }
     if (data[i] == 0) {
       updateMarker();
     } else {
@@ -63,7 +77,9 @@ void Rtt::CobsWriter::write(const uint8_t* data, uint32_t size) {
 
       // Check if we need to insert a virtual zero.
       if (markerDistance() == 0xFF) {
-        blockUntilNotFull();
+        if (!makeRoom()) {
+          return;
+        }
         updateMarker();
       }
     }
@@ -72,14 +88,41 @@ void Rtt::CobsWriter::write(const uint8_t* data, uint32_t size) {
 
 void Rtt::CobsWriter::commit() {
   if (*this) {
-    // Update the write pointer and mark the writer as done
-    blockUntilNotFull();
-    updateMarker();
-
-    m_channel->write.store(m_write_ptr, std::memory_order_release);
+    // Update the write pointer and mark the writer as done. A dropped record
+    // leaves it at the end of the last record.
+    if (makeRoom()) {
+      updateMarker();
+      m_channel->write.store(m_write_ptr, std::memory_order_release);
+      if (m_stats != nullptr) {
+        updateHighWater();
+      }
+    } else if (m_stats != nullptr) {
+      m_stats->dropped_full.fetch_add(1, std::memory_order_relaxed);
+    }
     m_manager->releaseWriter();
     m_manager = nullptr;
   }
 }
 
+void Rtt::CobsWriter::waitForReader(uint32_t next_write_ptr) {
+  // Publish what has been written so far, the reader can't make room
+  // otherwise.
+  m_channel->write.store(m_marker_ptr, std::memory_order_release);
+  const uint64_t start = (m_stats != nullptr) ? getGlobalTimestamp() : 0;
+  while (m_channel->read.load(std::memory_order_relaxed) == next_write_ptr) {
+  }
+  if (m_stats != nullptr) {
+    m_stats->blocked_ticks.fetch_add(getGlobalTimestamp() - start,
+                                     std::memory_order_relaxed);
+  }
+}
+
+void Rtt::CobsWriter::updateHighWater() {
+  const uint32_t read = m_channel->read.load(std::memory_order_relaxed);
+  const uint32_t pending = (m_write_ptr >= read)
+                               ? m_write_ptr - read
+                               : m_channel->size - read + m_write_ptr;
+  LoggerStats::updateMax(&m_stats->buffer_high_water, pending);
+}
+
 }  // namespace Postform
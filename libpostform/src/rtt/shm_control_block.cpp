@@ -0,0 +1,64 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "postform/rtt/rtt_manager.h"
+#include "postform/rtt/shm_segment.h"
+
+namespace Postform {
+
+namespace {
+
+const char* s_shm_name = Rtt::DEFAULT_SHM_NAME;
+
+void unlinkSegment() { shm_unlink(s_shm_name); }
+
+Rtt::ShmSegment* mapSegment() {
+  const char* name = getenv("POSTFORM_RTT_SHM_NAME");
+  if (name != nullptr) {
+    s_shm_name = name;
+  }
+
+  // Start from a fresh segment so that readers never attach to a stale one
+  // left behind by a previous run.
+  shm_unlink(s_shm_name);
+  int fd = shm_open(s_shm_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    perror("Postform: shm_open");
+    return nullptr;
+  }
+  atexit(unlinkSegment);
+
+  void* memory = MAP_FAILED;
+  if (ftruncate(fd, sizeof(Rtt::ShmSegment)) == 0) {
+    memory = mmap(nullptr, sizeof(Rtt::ShmSegment), PROT_READ | PROT_WRITE,
+                  MAP_SHARED, fd, 0);
+  }
+  close(fd);
+
+  if (memory == MAP_FAILED) {
+    perror("Postform: mapping the RTT segment");
+    return nullptr;
+  }
+  return new (memory) Rtt::ShmSegment;
+}
+
+}  // namespace
+
+Rtt::ControlBlock& Rtt::getControlBlock() {
+  // If the segment cannot be mapped logs still go through a private control
+  // block, they just can't be read by anyone.
+  static ShmSegment* s_segment = mapSegment();
+  if (s_segment == nullptr) {
+    static ShmSegment s_fallback_segment;
+    return s_fallback_segment.control_block;
+  }
+  return s_segment->control_block;
+}
+
+}  // namespace Postform
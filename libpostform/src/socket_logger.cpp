@@ -0,0 +1,204 @@
+#include "postform/socket_logger.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace Postform {
+
+namespace {
+
+constexpr char UNIX_PREFIX[] = "unix:";
+constexpr char TCP_PREFIX[] = "tcp:";
+
+bool startsWith(const std::string& str, const char* prefix) {
+  return str.compare(0, strlen(prefix), prefix) == 0;
+}
+
+int connectUnix(const std::string& path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+      0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int connectTcp(const std::string& host_and_port) {
+  const auto separator = host_and_port.rfind(':');
+  if (separator == std::string::npos) {
+    return -1;
+  }
+  const std::string host = host_and_port.substr(0, separator);
+  const std::string port = host_and_port.substr(separator + 1);
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(atoi(port.c_str())));
+  if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+    return -1;
+  }
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+      0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace
+
+void SocketWriter::write(const uint8_t* data, uint32_t size) {
+  if (*this) {
+    auto& batch = m_logger->m_batch;
+    batch.insert(batch.end(), data, data + size);
+  }
+}
+
+void SocketWriter::commit() {
+  if (m_logger) {
+    m_logger->commit(m_record_start);
+    m_logger = nullptr;
+  }
+}
+
+SocketWriter::SocketWriter(SocketWriter&& other) {
+  m_logger = other.m_logger;
+  m_record_start = other.m_record_start;
+  other.m_logger = nullptr;
+}
+
+SocketWriter& SocketWriter::operator=(SocketWriter&& other) {
+  if (this != &other) {
+    commit();
+    m_logger = other.m_logger;
+    m_record_start = other.m_record_start;
+    other.m_logger = nullptr;
+  }
+  return *this;
+}
+
+SocketLogger::SocketLogger(const std::string& address, Mode mode)
+    : m_mode(mode) {
+  if (startsWith(address, UNIX_PREFIX)) {
+    m_fd = connectUnix(address.substr(strlen(UNIX_PREFIX)));
+  } else if (startsWith(address, TCP_PREFIX)) {
+    m_fd = connectTcp(address.substr(strlen(TCP_PREFIX)));
+  }
+
+  if (m_fd < 0) {
+    fprintf(stderr, "Postform: unable to connect to %s\n", address.c_str());
+  }
+  m_batch.reserve(MAX_PENDING + SEND_THRESHOLD);
+}
+
+SocketLogger::~SocketLogger() {
+  // Deliver everything that is still batched, even in DROP_IF_FULL mode.
+  m_mode = Mode::BLOCK_IF_FULL;
+  flush();
+  if (m_fd >= 0) {
+    close(m_fd);
+  }
+}
+
+void SocketLogger::flush() {
+  while (m_taken.exchange(true, std::memory_order_acquire)) {
+  }
+  send();
+  m_taken.store(false, std::memory_order_release);
+}
+
+SocketWriter SocketLogger::getWriter() {
+  if (m_fd < 0 || m_taken.exchange(true, std::memory_order_acquire)) {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return SocketWriter{};
+  }
+
+  const std::size_t record_start = m_batch.size();
+  m_batch.resize(record_start + sizeof(uint32_t));
+  return SocketWriter{this, record_start};
+}
+
+void SocketLogger::commit(std::size_t record_start) {
+  LoggerStats* stats = getStats();
+  const std::size_t pending = m_batch.size() - m_sent;
+  if ((m_mode == Mode::DROP_IF_FULL) && (pending > MAX_PENDING)) {
+    m_batch.resize(record_start);
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    if (stats != nullptr) {
+      stats->dropped_full.fetch_add(1, std::memory_order_relaxed);
+    }
+  } else {
+    const uint32_t size = m_batch.size() - record_start - sizeof(uint32_t);
+    memcpy(&m_batch[record_start], &size, sizeof(size));
+  }
+
+  if (stats != nullptr) {
+    LoggerStats::updateMax(&stats->buffer_high_water,
+                           m_batch.size() - m_sent);
+  }
+  if (m_batch.size() - m_sent >= SEND_THRESHOLD) {
+    // Only a blocking send makes the record wait for the collector.
+    const bool blocking = (stats != nullptr) && (m_mode == Mode::BLOCK_IF_FULL);
+    const uint64_t start = blocking ? getGlobalTimestamp() : 0;
+    send();
+    if (blocking) {
+      stats->blocked_ticks.fetch_add(getGlobalTimestamp() - start,
+                                     std::memory_order_relaxed);
+    }
+  }
+  m_taken.store(false, std::memory_order_release);
+}
+
+void SocketLogger::send() {
+  const int flags =
+      MSG_NOSIGNAL | ((m_mode == Mode::DROP_IF_FULL) ? MSG_DONTWAIT : 0);
+  while ((m_fd >= 0) && (m_sent < m_batch.size())) {
+    const ssize_t sent =
+        ::send(m_fd, &m_batch[m_sent], m_batch.size() - m_sent, flags);
+    if (sent >= 0) {
+      m_sent += sent;
+    } else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+      break;
+    } else if (errno != EINTR) {
+      // The collector is gone, nothing else can be delivered.
+      close(m_fd);
+      m_fd = -1;
+      m_batch.clear();
+      m_sent = 0;
+    }
+  }
+
+  if (m_sent == m_batch.size()) {
+    m_batch.clear();
+    m_sent = 0;
+  } else if (m_sent >= SEND_THRESHOLD) {
+    m_batch.erase(m_batch.begin(), m_batch.begin() + m_sent);
+    m_sent = 0;
+  }
+}
+
+}  // namespace Postform
@@ -0,0 +1,57 @@
+#include "postform/histogram.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "mock_logger.h"
+
+using ::testing::ElementsAreArray;
+
+namespace Postform {
+
+TEST(HistogramTest, BucketsAreLogLinear) {
+  using Histogram = Postform::Histogram<3>;
+  // One bucket per value below 8
+  EXPECT_EQ(Histogram::bucketOf(0), 0U);
+  EXPECT_EQ(Histogram::bucketOf(7), 7U);
+  // Then 8 buckets per power of two
+  EXPECT_EQ(Histogram::bucketOf(8), 8U);
+  EXPECT_EQ(Histogram::bucketOf(15), 15U);
+  EXPECT_EQ(Histogram::bucketOf(16), 16U);
+  EXPECT_EQ(Histogram::bucketOf(17), 16U);
+  EXPECT_EQ(Histogram::bucketOf(18), 17U);
+  EXPECT_EQ(Histogram::bucketOf(255), 47U);
+  EXPECT_EQ(Histogram::bucketOf(UINT32_MAX), Histogram::NUM_BUCKETS - 1);
+}
+
+TEST(HistogramTest, FlushWritesNonEmptyBucketsAndResets) {
+  RecordingLogger logger;
+  Histogram<3> histogram{"latency"_intern_histogram};
+  histogram.record(3);
+  histogram.record(3);
+  histogram.record(255);
+  histogram.flush(&logger);
+  histogram.flush(&logger);
+
+  ASSERT_EQ(logger.records.size(), 2U);
+  const auto& record = logger.records[0];
+  // Timestamp and metric ID come first
+  const std::vector<uint8_t> counts(record.end() - 5, record.end());
+  // Sub-bucket bits, then bucket 3 with 2 samples and bucket 47 with 1
+  EXPECT_THAT(counts, ElementsAreArray({3, 3, 2, 44, 1}));
+  EXPECT_EQ(logger.records[1].back(), 3U);
+}
+
+TEST(HistogramTest, PollWaitsForTheFlushPeriod) {
+  RecordingLogger logger;
+  Histogram<> histogram{"latency"_intern_histogram, 10};
+  // The global timestamp of the tests is always 0
+  EXPECT_FALSE(histogram.poll(&logger));
+  EXPECT_TRUE(logger.records.empty());
+
+  Histogram<> unthrottled{"latency"_intern_histogram};
+  EXPECT_TRUE(unthrottled.poll(&logger));
+  EXPECT_EQ(logger.records.size(), 1U);
+}
+
+}  // namespace Postform
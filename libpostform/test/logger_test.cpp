@@ -68,4 +68,182 @@ INSTANTIATE_TEST_SUITE_P(
            Leb128Params{std::variant<int64_t, uint64_t>(int64_t{-255}),
                         std::vector<uint8_t>{0x81, 0x7E}}));
 
+TEST(TraceTest, ScopeEmitsBeginAndEndOfTheSameSpan) {
+  RecordingLogger logger;
+  {
+    POSTFORM_TRACE_SCOPE(&logger, "outer");
+    POSTFORM_TRACE_BEGIN(&logger, "inner");
+    POSTFORM_TRACE_END(&logger, "inner");
+  }
+
+  ASSERT_EQ(logger.records.size(), 4U);
+  // Timestamp, span ID and event
+  const auto span_id = [&](size_t index) {
+    const auto& record = logger.records[index];
+    return std::vector<uint8_t>(record.begin() + 1, record.end() - 1);
+  };
+  EXPECT_EQ(span_id(0), span_id(3));
+  EXPECT_EQ(span_id(1), span_id(2));
+  EXPECT_NE(span_id(0), span_id(1));
+  EXPECT_EQ(logger.records[0].back(), 0U);
+  EXPECT_EQ(logger.records[1].back(), 0U);
+  EXPECT_EQ(logger.records[2].back(), 1U);
+  EXPECT_EQ(logger.records[3].back(), 1U);
+}
+
+TEST(TraceTest, NoEventsWhenLoggerIsOff) {
+  RecordingLogger logger;
+  logger.setLevel(LogLevel::OFF);
+  { POSTFORM_TRACE_SCOPE(&logger, "span"); }
+  EXPECT_TRUE(logger.records.empty());
+}
+
+TEST(MetricTest, RecordsCarryTheValueAsVarint) {
+  RecordingLogger logger;
+  POSTFORM_COUNTER(&logger, "rx_bytes", 300U);
+  POSTFORM_GAUGE(&logger, "temperature", -2);
+  POSTFORM_COUNTER(&logger, "rx_bytes", 1U);
+
+  ASSERT_EQ(logger.records.size(), 3U);
+  // Timestamp, metric ID and value
+  const auto metric_id = [&](size_t index, size_t value_size) {
+    const auto& record = logger.records[index];
+    return std::vector<uint8_t>(record.begin() + 1, record.end() - value_size);
+  };
+  EXPECT_EQ(metric_id(0, 2), metric_id(2, 1));
+  EXPECT_NE(metric_id(0, 2), metric_id(1, 1));
+  EXPECT_THAT(std::vector<uint8_t>(logger.records[0].end() - 2,
+                                   logger.records[0].end()),
+              ElementsAreArray({0xAC, 0x02}));
+  EXPECT_EQ(logger.records[1].back(), 0x7E);
+  EXPECT_EQ(logger.records[2].back(), 0x01);
+}
+
+TEST(FloatTest, RecordsCarryTheRawLittleEndianBits) {
+  RecordingLogger logger;
+  LOG_INFO(&logger, "%f", 1.5f);
+  LOG_INFO(&logger, "%lg", -2.0);
+
+  ASSERT_EQ(logger.records.size(), 2U);
+  EXPECT_THAT(std::vector<uint8_t>(logger.records[0].end() - 4,
+                                   logger.records[0].end()),
+              ElementsAreArray({0x00, 0x00, 0xC0, 0x3F}));
+  EXPECT_THAT(std::vector<uint8_t>(logger.records[1].end() - 8,
+                                   logger.records[1].end()),
+              ElementsAreArray({0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                0xC0}));
+}
+
+TEST(StringViewTest, RecordsCarryTheLengthAndNoTerminator) {
+  RecordingLogger logger;
+  const char buffer[] = "Hello world";
+  LOG_INFO(&logger, "%.*s", std::string_view(buffer, 5));
+
+  ASSERT_EQ(logger.records.size(), 1U);
+  EXPECT_THAT(std::vector<uint8_t>(logger.records[0].end() - 6,
+                                   logger.records[0].end()),
+              ElementsAreArray({0x05, 0x48, 0x65, 0x6C, 0x6C, 0x6F}));
+}
+
+TEST(BytesTest, RecordsCarryTheLengthAndTheWholeBuffer) {
+  RecordingLogger logger;
+  const uint8_t packet[64] = {0xDE, 0xAD, 0xBE, 0xEF};
+  LOG_DEBUG(&logger, "Packet: %*b", Postform::Bytes(packet));
+
+  ASSERT_EQ(logger.records.size(), 1U);
+  const auto& record = logger.records[0];
+  // Timestamp, format ID, length and the buffer
+  EXPECT_LE(record.size(), 2U + sizeof(void*) + 1U + sizeof(packet));
+  EXPECT_THAT(std::vector<uint8_t>(record.end() - sizeof(packet) - 1,
+                                   record.end() - sizeof(packet) + 4),
+              ElementsAreArray({0x40, 0xDE, 0xAD, 0xBE, 0xEF}));
+  EXPECT_EQ(record.back(), 0U);
+}
+
+TEST(ArrayTest, RecordsCarryTheCountAndPackedVarints) {
+  RecordingLogger logger;
+  const std::array<int16_t, 3> samples = {-1, 300, -256};
+  LOG_INFO(&logger, "Samples: %*d", samples);
+  const uint32_t values[] = {1, 0xFFFFFFFF};
+  LOG_INFO(&logger, "Values: %*u", Postform::Span(values));
+
+  ASSERT_EQ(logger.records.size(), 2U);
+  EXPECT_THAT(std::vector<uint8_t>(logger.records[0].end() - 6,
+                                   logger.records[0].end()),
+              ElementsAreArray({0x03, 0x7F, 0xAC, 0x02, 0x80, 0x7E}));
+  EXPECT_THAT(std::vector<uint8_t>(logger.records[1].end() - 7,
+                                   logger.records[1].end()),
+              ElementsAreArray({0x02, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F}));
+}
+
+TEST(ArrayTest, LongArraysAreWrittenInChunks) {
+  RecordingLogger logger;
+  std::array<uint64_t, 100> values;
+  values.fill(0xFFFFFFFFFFFFFFFF);
+  LOG_INFO(&logger, "%*x", values);
+
+  ASSERT_EQ(logger.records.size(), 1U);
+  const auto& record = logger.records[0];
+  // Count of one byte, and 10 bytes per value
+  EXPECT_EQ(record.end()[-1001], 100U);
+  EXPECT_EQ(record.back(), 0x01);
+  // The count, then 12 chunks of 8 values and the remaining 4 values
+  std::vector<size_t> expected_writes(12, 80U);
+  expected_writes.insert(expected_writes.begin(), 1U);
+  expected_writes.push_back(40U);
+  ASSERT_GE(logger.writes.size(), expected_writes.size());
+  EXPECT_THAT(std::vector<size_t>(logger.writes.end() - expected_writes.size(),
+                                  logger.writes.end()),
+              ElementsAreArray(expected_writes));
+}
+
+TEST(EnumTest, RecordsCarryTheValueAsASignedVarint) {
+  enum class Direction : int8_t { kReverse = -1, kForward = 100 };
+  RecordingLogger logger;
+  LOG_INFO(&logger, "%{Direction} %{Direction}", Direction::kReverse,
+           Direction::kForward);
+
+  ASSERT_EQ(logger.records.size(), 1U);
+  EXPECT_THAT(std::vector<uint8_t>(logger.records[0].end() - 3,
+                                   logger.records[0].end()),
+              ElementsAreArray({0x7F, 0xE4, 0x00}));
+}
+
+TEST(StatsTest, CountsRecordsBytesAndDrops) {
+  RecordingLogger logger;
+  LoggerStats stats;
+  logger.log(LogLevel::INFO, 5U);
+  logger.setStats(&stats);
+  logger.log(LogLevel::INFO, 300U);
+  POSTFORM_GAUGE(&logger, "temperature", -2);
+  logger.busy = true;
+  logger.log(LogLevel::INFO, 5U);
+  logger.busy = false;
+  logger.setStats(nullptr);
+  logger.log(LogLevel::INFO, 5U);
+
+  ASSERT_EQ(logger.records.size(), 4U);
+  EXPECT_EQ(stats.records.load(), 2U);
+  EXPECT_EQ(stats.bytes.load(),
+            logger.records[1].size() + logger.records[2].size());
+  EXPECT_EQ(stats.dropped_busy.load(), 1U);
+  EXPECT_EQ(stats.dropped_full.load(), 0U);
+}
+
+TEST(StatsTest, FlushWritesCountersAsGauges) {
+  RecordingLogger logger;
+  LoggerStats stats{10};
+  logger.setStats(&stats);
+  logger.log(LogLevel::INFO, 5U);
+  stats.flush(&logger);
+
+  // The log and one gauge per counter
+  ASSERT_EQ(logger.records.size(), 8U);
+  // The records count, written as a gauge of value 1
+  EXPECT_EQ(logger.records[1].back(), 1U);
+  // The global timestamp of the tests is always 0
+  EXPECT_FALSE(stats.poll(&logger));
+  EXPECT_EQ(logger.records.size(), 8U);
+}
+
 }  // namespace Postform
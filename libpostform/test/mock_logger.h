@@ -1,13 +1,57 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include "postform/logger.h"
 
 class MockWriter {
  public:
   MOCK_METHOD(void, write, (const uint8_t*, size_t), ());
+
+  operator bool() { return true; }
 };
 
 class MockLogger : public Postform::Logger<MockLogger, MockWriter> {
   MockWriter getWriter() { return MockWriter{}; }
 };
+
+class RecordingWriter {
+ public:
+  RecordingWriter(std::vector<std::vector<uint8_t>>* records,
+                  std::vector<size_t>* writes)
+      : m_records(records), m_writes(writes) {
+    if (*this) {
+      m_records->emplace_back();
+    }
+  }
+
+  void write(const uint8_t* data, size_t size) {
+    if (*this) {
+      m_records->back().insert(m_records->back().end(), data, data + size);
+      m_writes->push_back(size);
+    }
+  }
+
+  operator bool() { return m_records != nullptr; }
+
+ private:
+  std::vector<std::vector<uint8_t>>* m_records;
+  std::vector<size_t>* m_writes;
+};
+
+class RecordingLogger
+    : public Postform::Logger<RecordingLogger, RecordingWriter> {
+ public:
+  std::vector<std::vector<uint8_t>> records;
+  //! Size of every call to write, across all records
+  std::vector<size_t> writes;
+  bool busy = false;
+
+ private:
+  RecordingWriter getWriter() {
+    return RecordingWriter{busy ? nullptr : &records, &writes};
+  }
+
+  friend Postform::Logger<RecordingLogger, RecordingWriter>;
+};
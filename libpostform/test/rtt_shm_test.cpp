@@ -0,0 +1,110 @@
+#include <fcntl.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "postform/logger.h"
+#include "postform/rtt/rtt_manager.h"
+#include "postform/rtt/shm_segment.h"
+
+using ::testing::ElementsAreArray;
+using ::testing::Ge;
+
+namespace Postform {
+
+TEST(RttShmTest, DescriptorMatchesLayout) {
+  auto segment = std::make_unique<Rtt::ShmSegment>();
+  const auto* base = reinterpret_cast<const uint8_t*>(segment.get());
+  const auto& descriptor = segment->descriptor;
+  const auto& up_channel = segment->control_block.up_channel;
+
+  EXPECT_EQ(descriptor.magic.load(), Rtt::ShmDescriptor::MAGIC);
+  EXPECT_EQ(descriptor.segment_size, sizeof(Rtt::ShmSegment));
+  EXPECT_EQ(base + descriptor.up_buffer_offset, up_channel.buffer);
+  EXPECT_EQ(descriptor.up_buffer_size, up_channel.size);
+  EXPECT_EQ(base + descriptor.up_write_offset,
+            reinterpret_cast<const uint8_t*>(&up_channel.write));
+  EXPECT_EQ(base + descriptor.up_read_offset,
+            reinterpret_cast<const uint8_t*>(&up_channel.read));
+  EXPECT_EQ(base + descriptor.up_flags_offset,
+            reinterpret_cast<const uint8_t*>(&up_channel.flags));
+
+  // The indices must not share a cache line
+  EXPECT_THAT(descriptor.up_read_offset - descriptor.up_write_offset, Ge(64U));
+  EXPECT_THAT(descriptor.up_flags_offset - descriptor.up_read_offset, Ge(64U));
+}
+
+TEST(RttShmTest, CobsFrameIsVisibleInSegment) {
+  const std::string name =
+      "/postform_rtt_test_" + std::to_string(static_cast<int>(getpid()));
+  setenv("POSTFORM_RTT_SHM_NAME", name.c_str(), 1);
+
+  LoggerStats stats;
+  {
+    auto writer = Rtt::Manager::getInstance().getCobsWriter(&stats);
+    ASSERT_TRUE(static_cast<bool>(writer));
+    const uint8_t data[] = {1, 0, 2};
+    writer.write(data, sizeof(data));
+  }
+
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  ASSERT_GE(fd, 0);
+  void* memory = mmap(nullptr, sizeof(Rtt::ShmSegment), PROT_READ, MAP_SHARED,
+                      fd, 0);
+  close(fd);
+  shm_unlink(name.c_str());
+  ASSERT_NE(memory, MAP_FAILED);
+
+  const auto* base = static_cast<const uint8_t*>(memory);
+  const auto* descriptor = static_cast<const Rtt::ShmDescriptor*>(memory);
+  ASSERT_EQ(descriptor->magic.load(), Rtt::ShmDescriptor::MAGIC);
+
+  uint32_t write_ptr;
+  memcpy(&write_ptr, base + descriptor->up_write_offset, sizeof(write_ptr));
+  const uint8_t* buffer = base + descriptor->up_buffer_offset;
+  const std::vector<uint8_t> frame{buffer, buffer + write_ptr};
+  EXPECT_THAT(frame, ElementsAreArray({2, 1, 2, 2, 0}));
+  // Nothing was read, the whole frame is pending
+  EXPECT_EQ(stats.buffer_high_water.load(), write_ptr);
+
+  munmap(memory, sizeof(Rtt::ShmSegment));
+}
+
+TEST(RttShmTest, FullChannelDropsRecordWithoutOverwriting) {
+  auto& channel = Rtt::getControlBlock().up_channel;
+  ASSERT_EQ(channel.flags.load(), Rtt::Flags::NO_BLOCK_TRIM);
+  // No reader, and only 64 free bytes left in the channel
+  const uint32_t write = channel.write.load();
+  const uint32_t read = (write + 65) % channel.size;
+  channel.read.store(read);
+  channel.buffer[read] = 0xA5;
+
+  LoggerStats stats;
+  {
+    auto writer = Rtt::Manager::getInstance().getCobsWriter(&stats);
+    ASSERT_TRUE(static_cast<bool>(writer));
+    const std::vector<uint8_t> record(200, 0x11);
+    writer.write(record.data(), record.size());
+  }
+  EXPECT_EQ(stats.dropped_full.load(), 1U);
+  EXPECT_EQ(channel.write.load(), write);
+  EXPECT_EQ(channel.buffer[read], 0xA5);
+
+  {
+    auto writer = Rtt::Manager::getInstance().getCobsWriter(&stats);
+    const uint8_t data[] = {1, 0, 2};
+    writer.write(data, sizeof(data));
+  }
+  EXPECT_EQ(stats.dropped_full.load(), 1U);
+  EXPECT_EQ(channel.write.load(), (write + 5) % channel.size);
+
+  channel.read.store(channel.write.load());
+}
+
+}  // namespace Postform
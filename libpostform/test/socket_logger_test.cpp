@@ -0,0 +1,99 @@
+#include "postform/socket_logger.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using ::testing::ElementsAreArray;
+using ::testing::Gt;
+
+namespace Postform {
+
+class SocketLoggerTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    m_path = "/tmp/postform_socket_test_" + std::to_string(getpid());
+    unlink(m_path.c_str());
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, m_path.c_str(), sizeof(address.sun_path) - 1);
+    m_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(m_listener, 0);
+    ASSERT_EQ(bind(m_listener, reinterpret_cast<sockaddr*>(&address),
+                   sizeof(address)),
+              0);
+    ASSERT_EQ(listen(m_listener, 1), 0);
+  }
+
+  void TearDown() override {
+    if (m_connection >= 0) close(m_connection);
+    close(m_listener);
+    unlink(m_path.c_str());
+  }
+
+  std::unique_ptr<SocketLogger> connect(SocketLogger::Mode mode) {
+    auto logger = std::make_unique<SocketLogger>("unix:" + m_path, mode);
+    m_connection = accept(m_listener, nullptr, nullptr);
+    return logger;
+  }
+
+  std::vector<uint8_t> readAll() {
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    ssize_t count;
+    while ((count = read(m_connection, buffer, sizeof(buffer))) > 0) {
+      data.insert(data.end(), buffer, buffer + count);
+    }
+    return data;
+  }
+
+ private:
+  std::string m_path;
+  int m_listener = -1;
+  int m_connection = -1;
+};
+
+TEST_F(SocketLoggerTest, RecordsUseFileWriterFraming) {
+  auto logger = connect(SocketLogger::Mode::BLOCK_IF_FULL);
+  logger->log(LogLevel::INFO, 5U);
+  logger->log(LogLevel::INFO, 300U);
+  logger.reset();
+
+  const std::vector<uint8_t> expected{2, 0, 0, 0, 0, 5,
+                                      3, 0, 0, 0, 0, 0xAC, 0x02};
+  EXPECT_THAT(readAll(), ElementsAreArray(expected));
+}
+
+TEST_F(SocketLoggerTest, DropsRecordsWhenCollectorIsSlow) {
+  constexpr uint32_t NUM_RECORDS = 1000000;
+  auto logger = connect(SocketLogger::Mode::DROP_IF_FULL);
+  for (uint32_t i = 0; i < NUM_RECORDS; i++) {
+    logger->log(LogLevel::INFO, 5U);
+  }
+  const uint64_t dropped = logger->getDroppedRecords();
+  EXPECT_THAT(dropped, Gt(0U));
+
+  std::vector<uint8_t> data;
+  std::thread collector{[&]() { data = readAll(); }};
+  logger.reset();
+  collector.join();
+
+  // Every record that made it is complete.
+  const uint8_t frame[] = {2, 0, 0, 0, 0, 5};
+  ASSERT_EQ(data.size() % sizeof(frame), 0U);
+  for (std::size_t i = 0; i < data.size(); i += sizeof(frame)) {
+    ASSERT_EQ(memcmp(&data[i], frame, sizeof(frame)), 0);
+  }
+  EXPECT_EQ(data.size() / sizeof(frame) + dropped, NUM_RECORDS);
+}
+
+}  // namespace Postform
@@ -0,0 +1,10 @@
+#include "postform/logger.h"
+
+// Platform hooks the library expects the application to provide, shared by
+// all the tests.
+
+namespace Postform {
+
+uint64_t getGlobalTimestamp() { return 0; }
+
+}  // namespace Postform
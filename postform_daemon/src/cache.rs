@@ -0,0 +1,147 @@
+use postform_decoder::{build_id, ElfMetadata, Error};
+use std::collections::HashMap;
+use std::fs;
+use std::hash::Hash;
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, Mutex};
+use std::time::SystemTime;
+
+/// Bounded map that evicts the least recently used entry when full.
+pub struct Lru<K, V> {
+    capacity: usize,
+    tick: u64,
+    entries: HashMap<K, (V, u64)>,
+}
+
+impl<K: Eq + Hash + Clone, V: Clone> Lru<K, V> {
+    /// Creates an empty cache holding at most `capacity` entries.
+    pub fn new(capacity: usize) -> Self {
+        Self {
+            capacity: std::cmp::max(capacity, 1),
+            tick: 0,
+            entries: HashMap::new(),
+        }
+    }
+
+    /// Returns the value for the key, marking it as the most recently used.
+    pub fn get(&mut self, key: &K) -> Option<V> {
+        self.tick += 1;
+        let tick = self.tick;
+        self.entries.get_mut(key).map(|(value, last_used)| {
+            *last_used = tick;
+            value.clone()
+        })
+    }
+
+    /// Inserts a value, returning the one already cached for the key if there was one.
+    pub fn insert(&mut self, key: K, value: V) -> V {
+        if let Some(existing) = self.get(&key) {
+            return existing;
+        }
+
+        if self.entries.len() >= self.capacity {
+            let oldest = self
+                .entries
+                .iter()
+                .min_by_key(|(_, (_, last_used))| *last_used)
+                .map(|(key, _)| key.clone());
+            if let Some(oldest) = oldest {
+                self.entries.remove(&oldest);
+            }
+        }
+        self.entries.insert(key, (value.clone(), self.tick));
+        value
+    }
+
+    /// Number of entries in the cache.
+    pub fn len(&self) -> usize {
+        self.entries.len()
+    }
+
+    /// Returns true if the cache holds no entries.
+    pub fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
+}
+
+/// Cache of `ElfMetadata` shared by all the streams of the daemon.
+///
+/// Metadata is keyed by the build it belongs to, so streams from copies of the same firmware
+/// share it no matter where their ELF files live. It is only loaded the first time a stream
+/// of that build needs it.
+pub struct MetadataCache {
+    metadata: Mutex<Lru<String, Arc<ElfMetadata>>>,
+    /// Build of each ELF file seen, along with its modification time when it was read.
+    builds: Mutex<HashMap<PathBuf, (SystemTime, String)>>,
+}
+
+impl MetadataCache {
+    /// Creates a cache that keeps the metadata of at most `capacity` builds.
+    pub fn new(capacity: usize) -> Self {
+        Self {
+            metadata: Mutex::new(Lru::new(capacity)),
+            builds: Mutex::new(HashMap::new()),
+        }
+    }
+
+    /// Returns the metadata of the given ELF file, loading it if its build is not cached.
+    pub fn get(&self, elf_path: &Path) -> Result<Arc<ElfMetadata>, Error> {
+        let modified = fs::metadata(elf_path)?.modified()?;
+        let known_build = match self.builds.lock().unwrap().get(elf_path) {
+            Some((time, build)) if *time == modified => Some(build.clone()),
+            _ => None,
+        };
+        if let Some(build) = &known_build {
+            if let Some(metadata) = self.metadata.lock().unwrap().get(build) {
+                return Ok(metadata);
+            }
+        }
+
+        let elf_data = fs::read(elf_path)?;
+        let build = match known_build {
+            Some(build) => build,
+            None => {
+                let build = build_id(&elf_data)?;
+                self.builds
+                    .lock()
+                    .unwrap()
+                    .insert(elf_path.to_owned(), (modified, build.clone()));
+                if let Some(metadata) = self.metadata.lock().unwrap().get(&build) {
+                    return Ok(metadata);
+                }
+                build
+            }
+        };
+
+        // Parsing happens without holding the lock, streams of other builds are not delayed.
+        eprintln!("Loading metadata for build {}", build);
+        let metadata = Arc::new(ElfMetadata::from_elf_data(&elf_data)?);
+        Ok(self.metadata.lock().unwrap().insert(build, metadata))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_lru_evicts_least_recently_used() {
+        let mut lru = Lru::new(2);
+        lru.insert("a", 1);
+        lru.insert("b", 2);
+        assert_eq!(lru.get(&"a"), Some(1));
+        lru.insert("c", 3);
+        assert_eq!(lru.len(), 2);
+        assert_eq!(lru.get(&"b"), None);
+        assert_eq!(lru.get(&"a"), Some(1));
+        assert_eq!(lru.get(&"c"), Some(3));
+    }
+
+    #[test]
+    fn test_lru_keeps_existing_value() {
+        let mut lru = Lru::new(2);
+        assert_eq!(lru.insert("a", 1), 1);
+        assert_eq!(lru.insert("a", 2), 1);
+        assert_eq!(lru.len(), 1);
+    }
+}
@@ -0,0 +1,3 @@
+pub mod cache;
+pub mod pool;
+pub mod source;
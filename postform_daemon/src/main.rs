@@ -0,0 +1,73 @@
+use color_eyre::eyre::Result;
+use postform_daemon::{
+    cache::MetadataCache,
+    pool::WorkerPool,
+    source::{Ingestor, SourceSpec},
+};
+use postform_decoder::POSTFORM_VERSION;
+use std::sync::Arc;
+use std::thread;
+use structopt::StructOpt;
+
+fn print_version() {
+    // version from Cargo.toml e.g. "0.1.4"
+    println!("{} {}", env!("CARGO_PKG_NAME"), env!("CARGO_PKG_VERSION"));
+    println!("supported Postform version: {}", POSTFORM_VERSION);
+}
+
+#[derive(Debug, StructOpt)]
+#[structopt()]
+struct Opts {
+    /// Sources of log streams, as ELF=LOCATION. LOCATION is one of `file:<path>` for a
+    /// `FileLogger` log, `capture:<path>` for a `postform_rtt --capture` file, or
+    /// `unix:<path>` and `tcp:<ip>:<port>` to accept `SocketLogger` connections.
+    #[structopt(name = "SOURCE", required_unless_one(&["version"]))]
+    sources: Vec<SourceSpec>,
+
+    /// Maximum number of firmware builds whose metadata is kept in memory.
+    #[structopt(long, default_value = "16")]
+    cache_size: usize,
+
+    /// Number of threads decoding logs.
+    #[structopt(long, default_value = "4")]
+    workers: usize,
+
+    #[structopt(long, short = "V")]
+    version: bool,
+}
+
+fn main() -> Result<()> {
+    color_eyre::install()?;
+
+    let opts = Opts::from_args();
+
+    if opts.version {
+        print_version();
+        return Ok(());
+    }
+
+    let pool = Arc::new(WorkerPool::new(opts.workers));
+    let ingestor = Ingestor::new(Arc::new(MetadataCache::new(opts.cache_size)), pool.clone());
+    let sources: Vec<_> = opts
+        .sources
+        .into_iter()
+        .map(|source| {
+            let ingestor = ingestor.clone();
+            thread::spawn(move || {
+                if let Err(e) = ingestor.run(&source) {
+                    eprintln!("[{}] {}", source.name, e);
+                }
+            })
+        })
+        .collect();
+    drop(ingestor);
+
+    // Only returns once every source is done, which never happens while listening.
+    for source in sources {
+        source.join().expect("Source thread panicked");
+    }
+    if let Ok(pool) = Arc::try_unwrap(pool) {
+        pool.join();
+    }
+    Ok(())
+}
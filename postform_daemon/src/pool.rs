@@ -0,0 +1,73 @@
+use postform_decoder::ElfMetadata;
+use postform_persist::{for_each_record, format_log, Framing};
+use std::io::{self, Write};
+use std::sync::{
+    mpsc::{self, Receiver, SyncSender},
+    Arc,
+};
+use std::thread::{self, JoinHandle};
+
+/// Number of pending jobs each worker can hold before streams block.
+const JOB_QUEUE_DEPTH: usize = 64;
+
+/// A run of complete records from a single stream.
+pub struct Job {
+    /// Prefix added to every line of output of the stream.
+    pub label: Arc<str>,
+    pub elf_metadata: Arc<ElfMetadata>,
+    pub framing: Framing,
+    pub data: Vec<u8>,
+}
+
+/// Pool of threads decoding and printing the records of all streams.
+///
+/// Every stream is always dispatched to the same worker, so its logs keep their order while
+/// different streams are decoded in parallel.
+pub struct WorkerPool {
+    senders: Vec<SyncSender<Job>>,
+    workers: Vec<JoinHandle<()>>,
+}
+
+impl WorkerPool {
+    /// Spawns a pool with the given number of worker threads.
+    pub fn new(num_workers: usize) -> Self {
+        let (senders, workers) = (0..std::cmp::max(num_workers, 1))
+            .map(|_| {
+                let (sender, receiver) = mpsc::sync_channel(JOB_QUEUE_DEPTH);
+                (sender, thread::spawn(move || run_worker(receiver)))
+            })
+            .unzip();
+        Self { senders, workers }
+    }
+
+    /// Returns the queue for the jobs of the given stream.
+    pub fn sender(&self, stream_id: usize) -> SyncSender<Job> {
+        self.senders[stream_id % self.senders.len()].clone()
+    }
+
+    /// Waits for the workers to finish all the queued jobs.
+    pub fn join(self) {
+        drop(self.senders);
+        for worker in self.workers {
+            worker.join().expect("Worker thread panicked");
+        }
+    }
+}
+
+fn run_worker(receiver: Receiver<Job>) {
+    let mut output = String::new();
+    for job in receiver {
+        for_each_record(&job.data, job.framing, |record| {
+            for line in format_log(&job.elf_metadata, record).lines() {
+                output.push('[');
+                output.push_str(&job.label);
+                output.push_str("] ");
+                output.push_str(line);
+                output.push('\n');
+            }
+        });
+        // A single write per job keeps the lines of a record together.
+        let _ = io::stdout().lock().write_all(output.as_bytes());
+        output.clear();
+    }
+}
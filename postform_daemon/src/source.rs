@@ -0,0 +1,185 @@
+use crate::cache::MetadataCache;
+use crate::pool::{Job, WorkerPool};
+use color_eyre::eyre::Result;
+use postform_persist::{bind_unix_listener, complete_records_len, Framing, ListenAddress};
+use std::fs::File;
+use std::io::{self, Read};
+use std::net::TcpListener;
+use std::path::PathBuf;
+use std::str::FromStr;
+use std::sync::{
+    atomic::{AtomicUsize, Ordering},
+    Arc,
+};
+use std::thread;
+
+/// Size of a single read from a stream.
+const READ_CHUNK_SIZE: usize = 64 * 1024;
+
+/// Where the records of a source come from.
+#[derive(Clone, Debug)]
+pub enum Location {
+    /// Log written by a `FileLogger`, written as `file:<path>`.
+    File(PathBuf),
+    /// Raw RTT capture from `postform_rtt --capture`, written as `capture:<path>`.
+    Capture(PathBuf),
+    /// Connections from `SocketLogger`s, written as `unix:<path>` or `tcp:<ip>:<port>`.
+    Listen(ListenAddress),
+}
+
+/// A source of streams along with the firmware that produced them, written as `ELF=LOCATION`.
+#[derive(Clone, Debug)]
+pub struct SourceSpec {
+    pub elf: PathBuf,
+    pub location: Location,
+    /// Location as given by the user, used to label the output.
+    pub name: String,
+}
+
+/// Error parsing a `SourceSpec`
+#[derive(Debug, thiserror::Error)]
+#[error(
+    "Invalid source {0}, expected ELF=LOCATION with LOCATION one of file:<path>, \
+     capture:<path>, unix:<path> or tcp:<ip>:<port>"
+)]
+pub struct InvalidSource(String);
+
+impl FromStr for SourceSpec {
+    type Err = InvalidSource;
+
+    fn from_str(spec: &str) -> Result<Self, Self::Err> {
+        let invalid = || InvalidSource(spec.to_owned());
+        let mut parts = spec.splitn(2, '=');
+        let elf = parts
+            .next()
+            .filter(|elf| !elf.is_empty())
+            .ok_or_else(invalid)?;
+        let name = parts.next().ok_or_else(invalid)?;
+
+        let location = if let Some(path) = name.strip_prefix("file:") {
+            Location::File(PathBuf::from(path))
+        } else if let Some(path) = name.strip_prefix("capture:") {
+            Location::Capture(PathBuf::from(path))
+        } else {
+            Location::Listen(name.parse().map_err(|_| invalid())?)
+        };
+        Ok(Self {
+            elf: PathBuf::from(elf),
+            location,
+            name: name.to_owned(),
+        })
+    }
+}
+
+/// Shared state needed to ingest streams.
+#[derive(Clone)]
+pub struct Ingestor {
+    cache: Arc<MetadataCache>,
+    pool: Arc<WorkerPool>,
+    next_stream_id: Arc<AtomicUsize>,
+}
+
+impl Ingestor {
+    pub fn new(cache: Arc<MetadataCache>, pool: Arc<WorkerPool>) -> Self {
+        Self {
+            cache,
+            pool,
+            next_stream_id: Arc::new(AtomicUsize::new(0)),
+        }
+    }
+
+    /// Ingests all the streams of the source. For listening sources this only returns on error.
+    pub fn run(&self, source: &SourceSpec) -> Result<()> {
+        match &source.location {
+            Location::File(path) => self.ingest(
+                source,
+                &source.name,
+                File::open(path)?,
+                Framing::LengthPrefixed,
+            ),
+            Location::Capture(path) => {
+                self.ingest(source, &source.name, File::open(path)?, Framing::Cobs)
+            }
+            Location::Listen(ListenAddress::Unix(path)) => {
+                self.serve(source, bind_unix_listener(path)?.incoming())
+            }
+            Location::Listen(ListenAddress::Tcp(socket_addr)) => {
+                self.serve(source, TcpListener::bind(socket_addr)?.incoming())
+            }
+        }
+    }
+
+    /// Ingests every accepted connection on its own thread.
+    fn serve<S: Read + Send + 'static>(
+        &self,
+        source: &SourceSpec,
+        incoming: impl Iterator<Item = io::Result<S>>,
+    ) -> Result<()> {
+        for (connection, stream) in incoming.enumerate() {
+            let stream = stream?;
+            let (ingestor, source) = (self.clone(), source.clone());
+            let label = format!("{}#{}", source.name, connection);
+            thread::spawn(move || {
+                let result = ingestor.ingest(&source, &label, stream, Framing::LengthPrefixed);
+                if let Err(e) = result {
+                    eprintln!("[{}] {}", label, e);
+                }
+            });
+        }
+        Ok(())
+    }
+
+    /// Reads the stream and hands runs of complete records to the worker pool.
+    ///
+    /// The metadata of the firmware is only requested once the first data arrives.
+    fn ingest(
+        &self,
+        source: &SourceSpec,
+        label: &str,
+        mut stream: impl Read,
+        framing: Framing,
+    ) -> Result<()> {
+        let sender = self
+            .pool
+            .sender(self.next_stream_id.fetch_add(1, Ordering::Relaxed));
+        let label: Arc<str> = Arc::from(label);
+        let mut elf_metadata = None;
+        let mut pending = vec![];
+        let mut chunk = vec![0u8; READ_CHUNK_SIZE];
+        let mut bytes = 0u64;
+
+        loop {
+            let count = match stream.read(&mut chunk) {
+                Ok(0) => break,
+                Ok(count) => count,
+                Err(e) if e.kind() == io::ErrorKind::Interrupted => continue,
+                Err(e) => return Err(e.into()),
+            };
+            bytes += count as u64;
+            pending.extend_from_slice(&chunk[..count]);
+
+            let complete_len = complete_records_len(&pending, framing);
+            if complete_len == 0 {
+                continue;
+            }
+            let metadata = match elf_metadata.take() {
+                Some(metadata) => metadata,
+                None => self.cache.get(&source.elf)?,
+            };
+            elf_metadata = Some(Arc::clone(&metadata));
+            let rest = pending.split_off(complete_len);
+            let job = Job {
+                label: Arc::clone(&label),
+                elf_metadata: metadata,
+                framing,
+                data: std::mem::replace(&mut pending, rest),
+            };
+            if sender.send(job).is_err() {
+                break;
+            }
+        }
+
+        eprintln!("[{}] Stream closed after {} bytes", label, bytes);
+        Ok(())
+    }
+}
@@ -0,0 +1,327 @@
+//! Benchmarks of the decoder, run with `cargo bench -p postform_decoder`.
+//!
+//! The firmware is an ELF file generated on the fly, with a call site per family of format
+//! specifiers. A log recorded by a `FileLogger` can be benchmarked as well by setting
+//! `POSTFORM_BENCH_ELF` and `POSTFORM_BENCH_LOG`.
+
+use criterion::{black_box, criterion_group, criterion_main, Criterion, Throughput};
+use postform_decoder::{Decoder, ElfMetadata, POSTFORM_VERSION};
+use std::convert::TryInto;
+use std::path::PathBuf;
+
+/// Call sites of the generated firmware: name of the benchmark, format string and encoded
+/// arguments of its records. `%k` arguments are filled in once the interned string is placed.
+fn call_sites() -> Vec<(&'static str, &'static str, Vec<u8>)> {
+    let mut signed = vec![];
+    let mut unsigned = vec![];
+    for _ in 0..4 {
+        write_signed(&mut signed, -123_456_789);
+        write_unsigned(&mut unsigned, 0x1234_5678);
+    }
+    let short_string = [b"0123456789abcdef".as_ref(), b"\0"].concat();
+    let long_string = [vec![b'a'; 1024], vec![0]].concat();
+    let mut long_string_view = vec![];
+    write_unsigned(&mut long_string_view, 1024);
+    long_string_view.extend_from_slice(&[b'a'; 1024]);
+    vec![
+        ("no_args", "Starting the main loop", vec![]),
+        ("signed", "%d %d %d %d", signed),
+        ("unsigned", "%u %u %u %u", unsigned.clone()),
+        ("hex", "%x %x %x %x", unsigned.clone()),
+        ("octal", "%o %o %o %o", unsigned),
+        ("pointer", "%p", vec![0x80, 0x80, 0x80, 0x80, 0x02]),
+        ("string", "%s", short_string),
+        ("long_string", "%s", long_string),
+        ("long_string_view", "%.*s", long_string_view),
+        ("interned_string", "%k", vec![]),
+    ]
+}
+
+/// Interned string sent by the `%k` call site.
+const LONG_INTERNED_STRING_LEN: usize = 1024;
+
+/// Generated firmware and the records of its call sites.
+struct Fixture {
+    elf: Vec<u8>,
+    /// Name of the benchmark and record of each call site.
+    records: Vec<(&'static str, Vec<u8>)>,
+}
+
+impl Fixture {
+    /// Generates a firmware with the benchmarked call sites, `extra_call_sites` more of them and
+    /// `extra_symbols` unrelated symbols, as found in a large firmware.
+    fn new(extra_call_sites: usize, extra_symbols: usize) -> Self {
+        let mut strings = vec![];
+        let mut format_ids = vec![];
+        for (_, format, _) in &call_sites() {
+            format_ids.push(strings.len());
+            strings.extend_from_slice(format!("bench.cpp@10@{}\0", format).as_bytes());
+        }
+        for line in 0..extra_call_sites {
+            strings.extend_from_slice(format!("extra.cpp@{}@Value: %u\0", line).as_bytes());
+        }
+        let info_end = strings.len();
+        let interned_string = strings.len();
+        strings.extend(std::iter::repeat(b'k').take(LONG_INTERNED_STRING_LEN));
+        strings.push(0);
+
+        // Firmware symbols come before the markers of the levels, which are looked up by name
+        let mut symbols: Vec<(String, usize)> = (0..extra_symbols)
+            .map(|index| (format!("_ZN8Firmware8functionEj{}", index), 0))
+            .collect();
+        for level in &["Debug", "Warning", "Error", "Trace", "Metric"] {
+            symbols.push((format!("__Interned{}Start", level), info_end));
+            symbols.push((format!("__Interned{}End", level), info_end));
+        }
+        symbols.push(("__InternedInfoStart".to_owned(), 0));
+        symbols.push(("__InternedInfoEnd".to_owned(), info_end));
+
+        let records = call_sites()
+            .into_iter()
+            .zip(format_ids)
+            .map(|((name, _, mut arguments), format_id)| {
+                if name == "interned_string" {
+                    write_unsigned(&mut arguments, interned_string as u64);
+                }
+                let mut record = vec![];
+                write_unsigned(&mut record, 123_456_789);
+                write_unsigned(&mut record, format_id as u64);
+                record.extend(arguments);
+                (name, record)
+            })
+            .collect();
+
+        Self {
+            elf: build_elf(&strings, &symbols),
+            records,
+        }
+    }
+
+    fn elf_metadata(&self) -> ElfMetadata {
+        ElfMetadata::from_elf_data(&self.elf).unwrap()
+    }
+
+    /// Writes the firmware to a temporary file and returns its path.
+    fn write_elf(&self, name: &str) -> PathBuf {
+        let path = std::env::temp_dir().join(format!(
+            "postform_bench_{}_{}.elf",
+            name,
+            std::process::id()
+        ));
+        std::fs::write(&path, &self.elf).unwrap();
+        path
+    }
+}
+
+fn write_unsigned(buffer: &mut Vec<u8>, mut value: u64) {
+    loop {
+        let byte = (value & 0x7F) as u8;
+        value >>= 7;
+        if value == 0 {
+            buffer.push(byte);
+            return;
+        }
+        buffer.push(byte | 0x80);
+    }
+}
+
+fn write_signed(buffer: &mut Vec<u8>, mut value: i64) {
+    loop {
+        let byte = (value & 0x7F) as u8;
+        value >>= 7;
+        if (value == 0 && byte & 0x40 == 0) || (value == -1 && byte & 0x40 != 0) {
+            buffer.push(byte);
+            return;
+        }
+        buffer.push(byte | 0x80);
+    }
+}
+
+/// Builds a 64-bit little endian ELF file with the sections and symbols read by ElfMetadata.
+fn build_elf(interned_strings: &[u8], symbols: &[(String, usize)]) -> Vec<u8> {
+    const HEADER_SIZE: usize = 64;
+    const SECTION_HEADER_SIZE: usize = 64;
+    const SYMBOL_SIZE: usize = 24;
+    const SHT_PROGBITS: u32 = 1;
+    const SHT_SYMTAB: u32 = 2;
+    const SHT_STRTAB: u32 = 3;
+    const STB_GLOBAL: u8 = 1 << 4;
+
+    let mut strtab = vec![0u8];
+    let mut symtab = vec![0u8; SYMBOL_SIZE];
+    for (name, value) in symbols {
+        symtab.extend_from_slice(&(strtab.len() as u32).to_le_bytes());
+        symtab.push(STB_GLOBAL);
+        symtab.push(0);
+        // Defined in .interned_strings
+        symtab.extend_from_slice(&1u16.to_le_bytes());
+        symtab.extend_from_slice(&(*value as u64).to_le_bytes());
+        symtab.extend_from_slice(&0u64.to_le_bytes());
+        strtab.extend_from_slice(name.as_bytes());
+        strtab.push(0);
+    }
+    let version = [POSTFORM_VERSION.as_bytes(), b"\0"].concat();
+    let config = 1_000_000u32.to_le_bytes().to_vec();
+
+    // Name, type, link, info, entry size and contents of every section but the null one
+    let mut sections: Vec<(&str, u32, u32, u32, u64, &[u8])> = vec![
+        (".interned_strings", SHT_PROGBITS, 0, 0, 0, interned_strings),
+        (".postform_config", SHT_PROGBITS, 0, 0, 0, &config),
+        (".postform_version", SHT_PROGBITS, 0, 0, 0, &version),
+        (".symtab", SHT_SYMTAB, 5, 1, SYMBOL_SIZE as u64, &symtab),
+        (".strtab", SHT_STRTAB, 0, 0, 0, &strtab),
+    ];
+    let mut shstrtab = vec![0u8];
+    let mut names = vec![];
+    for (name, ..) in &sections {
+        names.push(shstrtab.len() as u32);
+        shstrtab.extend_from_slice(name.as_bytes());
+        shstrtab.push(0);
+    }
+    names.push(shstrtab.len() as u32);
+    shstrtab.extend_from_slice(b".shstrtab\0");
+    sections.push((".shstrtab", SHT_STRTAB, 0, 0, 0, &shstrtab));
+
+    let mut data = vec![];
+    let mut offsets = vec![];
+    for (.., contents) in &sections {
+        while (HEADER_SIZE + data.len()) % 8 != 0 {
+            data.push(0);
+        }
+        offsets.push(HEADER_SIZE + data.len());
+        data.extend_from_slice(contents);
+    }
+    while (HEADER_SIZE + data.len()) % 8 != 0 {
+        data.push(0);
+    }
+    let section_headers_offset = HEADER_SIZE + data.len();
+
+    let mut elf = vec![0x7F, b'E', b'L', b'F', 2, 1, 1];
+    elf.resize(16, 0);
+    elf.extend_from_slice(&2u16.to_le_bytes()); // ET_EXEC
+    elf.extend_from_slice(&62u16.to_le_bytes()); // EM_X86_64
+    elf.extend_from_slice(&1u32.to_le_bytes());
+    elf.extend_from_slice(&0u64.to_le_bytes()); // Entry point
+    elf.extend_from_slice(&0u64.to_le_bytes()); // Program headers
+    elf.extend_from_slice(&(section_headers_offset as u64).to_le_bytes());
+    elf.extend_from_slice(&0u32.to_le_bytes());
+    elf.extend_from_slice(&(HEADER_SIZE as u16).to_le_bytes());
+    elf.extend_from_slice(&0u16.to_le_bytes());
+    elf.extend_from_slice(&0u16.to_le_bytes());
+    elf.extend_from_slice(&(SECTION_HEADER_SIZE as u16).to_le_bytes());
+    elf.extend_from_slice(&(sections.len() as u16 + 1).to_le_bytes());
+    elf.extend_from_slice(&(sections.len() as u16).to_le_bytes());
+    elf.extend(data);
+
+    elf.resize(elf.len() + SECTION_HEADER_SIZE, 0);
+    for (index, (_, section_type, link, info, entry_size, contents)) in sections.iter().enumerate()
+    {
+        elf.extend_from_slice(&names[index].to_le_bytes());
+        elf.extend_from_slice(&section_type.to_le_bytes());
+        elf.extend_from_slice(&0u64.to_le_bytes()); // Flags
+        elf.extend_from_slice(&0u64.to_le_bytes()); // Address
+        elf.extend_from_slice(&(offsets[index] as u64).to_le_bytes());
+        elf.extend_from_slice(&(contents.len() as u64).to_le_bytes());
+        elf.extend_from_slice(&link.to_le_bytes());
+        elf.extend_from_slice(&info.to_le_bytes());
+        elf.extend_from_slice(&1u64.to_le_bytes()); // Alignment
+        elf.extend_from_slice(&entry_size.to_le_bytes());
+    }
+    elf
+}
+
+/// Splits a log written by a `FileLogger` into its records.
+fn length_prefixed_records(mut data: &[u8]) -> Vec<&[u8]> {
+    let mut records = vec![];
+    while data.len() >= 4 {
+        let size = u32::from_le_bytes(data[..4].try_into().unwrap()) as usize;
+        if data.len() - 4 < size {
+            break;
+        }
+        records.push(&data[4..4 + size]);
+        data = &data[4 + size..];
+    }
+    records
+}
+
+/// Decodes every record of a stream, returning the number of bytes of the decoded messages.
+fn decode_stream(elf_metadata: &ElfMetadata, records: &[&[u8]]) -> usize {
+    let mut decoder = Decoder::new(elf_metadata);
+    records
+        .iter()
+        .filter_map(|record| decoder.decode(record).ok())
+        .map(|log| log.message.len())
+        .sum()
+}
+
+fn bench_elf_metadata(c: &mut Criterion) {
+    let mut group = c.benchmark_group("from_elf_file");
+    for (name, fixture) in &[
+        ("small", Fixture::new(0, 0)),
+        ("large", Fixture::new(5_000, 50_000)),
+    ] {
+        let path = fixture.write_elf(name);
+        group.throughput(Throughput::Bytes(fixture.elf.len() as u64));
+        group.bench_function(*name, |b| {
+            b.iter(|| ElfMetadata::from_elf_file(black_box(&path)).unwrap())
+        });
+        std::fs::remove_file(path).unwrap();
+    }
+    group.finish();
+}
+
+fn bench_decode(c: &mut Criterion) {
+    let fixture = Fixture::new(0, 0);
+    let elf_metadata = fixture.elf_metadata();
+    let mut group = c.benchmark_group("decode");
+    for (name, record) in &fixture.records {
+        group.throughput(Throughput::Elements(1));
+        group.bench_function(*name, |b| {
+            let mut decoder = Decoder::new(&elf_metadata);
+            b.iter(|| decoder.decode(black_box(record)).unwrap())
+        });
+    }
+    group.finish();
+}
+
+fn bench_stream(c: &mut Criterion) {
+    // A mix of all the call sites, weighted towards the short records that dominate real logs
+    let fixture = Fixture::new(0, 0);
+    let elf_metadata = fixture.elf_metadata();
+    let mut records: Vec<&[u8]> = vec![];
+    for index in 0..10_000 {
+        let (name, record) = &fixture.records[index % fixture.records.len()];
+        if !name.starts_with("long") || index % 10 == 0 {
+            records.push(record);
+        }
+    }
+    bench_records(c, "stream/generated", &elf_metadata, &records);
+
+    let elf = std::env::var_os("POSTFORM_BENCH_ELF");
+    let log = std::env::var_os("POSTFORM_BENCH_LOG");
+    if let (Some(elf), Some(log)) = (elf, log) {
+        let elf_metadata = ElfMetadata::from_elf_file(&PathBuf::from(elf)).unwrap();
+        let data = std::fs::read(log).unwrap();
+        let records = length_prefixed_records(&data);
+        bench_records(c, "stream/recorded", &elf_metadata, &records);
+    }
+}
+
+/// Benchmarks the decoding of the records, measuring the throughput both in records and in
+/// bytes.
+fn bench_records(c: &mut Criterion, name: &str, elf_metadata: &ElfMetadata, records: &[&[u8]]) {
+    let bytes: usize = records.iter().map(|record| record.len()).sum();
+    let mut group = c.benchmark_group(name);
+    group.throughput(Throughput::Elements(records.len() as u64));
+    group.bench_function("records", |b| {
+        b.iter(|| decode_stream(elf_metadata, black_box(records)))
+    });
+    group.throughput(Throughput::Bytes(bytes as u64));
+    group.bench_function("bytes", |b| {
+        b.iter(|| decode_stream(elf_metadata, black_box(records)))
+    });
+    group.finish();
+}
+
+criterion_group!(benches, bench_elf_metadata, bench_decode, bench_stream);
+criterion_main!(benches);
@@ -0,0 +1,293 @@
+use crate::{parse_format_spec, CallSite, Conversion, ElfMetadata, Error};
+use byteorder::{ByteOrder, LittleEndian};
+use std::collections::HashMap;
+use std::fmt::Write;
+
+/// Hit counter of a log call site, as described by its entry in the `.postform_counters`
+/// section.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct CounterSite {
+    /// Address of the 32-bit counter in the memory of the target.
+    pub counter_address: u64,
+    /// Identifier of the format string of the call site.
+    pub format_id: usize,
+}
+
+/// Parses the entries of the `.postform_counters` section: the address of the counter followed
+/// by the address of the format string, as pointers of the target.
+pub(crate) fn parse_counter_sites(section: &[u8], pointer_size: usize) -> Vec<CounterSite> {
+    section
+        .chunks_exact(2 * pointer_size)
+        .map(|entry| CounterSite {
+            counter_address: LittleEndian::read_uint(&entry[..pointer_size], pointer_size),
+            format_id: LittleEndian::read_uint(&entry[pointer_size..], pointer_size) as usize,
+        })
+        .collect()
+}
+
+/// Copy of a region of the memory of the target, e.g. read through a debug probe or dumped
+/// with `dump binary memory` in GDB.
+pub struct MemoryImage {
+    /// Address of the first byte of the image.
+    pub base: u64,
+    pub data: Vec<u8>,
+}
+
+impl MemoryImage {
+    fn read_u32(&self, address: u64) -> Option<u32> {
+        let offset = address.checked_sub(self.base)? as usize;
+        let bytes = self.data.get(offset..offset.checked_add(4)?)?;
+        Some(LittleEndian::read_u32(bytes))
+    }
+}
+
+/// Size assumed for the timestamp of a record, that of a 32-bit tick count.
+const ESTIMATED_TIMESTAMP_SIZE: u64 = 5;
+
+/// Estimates the size of a record of the call site: its timestamp, its format ID and one byte
+/// per argument, which is the size of small integers and empty strings. Larger arguments make
+/// the actual size bigger.
+pub fn estimated_record_size(call_site: &CallSite) -> u64 {
+    let mut format_id_size = 1;
+    let mut format_id = call_site.format_id >> 7;
+    while format_id != 0 {
+        format_id_size += 1;
+        format_id >>= 7;
+    }
+
+    let mut arguments = 0;
+    let mut format = call_site.format.as_str();
+    while let Some(position) = format.find('%') {
+        format = &format[position..];
+        match parse_format_spec(format) {
+            Some((format_spec_len, conversion)) => {
+                if !matches!(conversion, Conversion::Percent) {
+                    arguments += 1;
+                }
+                format = &format[format_spec_len..];
+            }
+            None => format = &format[1..],
+        }
+    }
+    ESTIMATED_TIMESTAMP_SIZE + format_id_size + arguments
+}
+
+/// Number of times a log call site was reached.
+#[derive(Debug)]
+pub struct CallSiteHits {
+    pub call_site: CallSite,
+    pub hits: u64,
+    /// Bytes the call site would have sent if none of its logs were filtered out, estimated
+    /// with estimated_record_size.
+    pub estimated_bytes: u64,
+}
+
+impl ElfMetadata {
+    /// Returns the range of addresses holding the hit counters of the call sites, or None if
+    /// the firmware has no counters.
+    pub fn counters_range(&self) -> Option<(u64, u64)> {
+        let start = self.counter_sites.iter().map(|s| s.counter_address).min()?;
+        let end = self.counter_sites.iter().map(|s| s.counter_address).max()? + 4;
+        Some((start, end))
+    }
+
+    /// Reads the hit counters of all log call sites from a memory image covering
+    /// counters_range.
+    ///
+    /// Every instance of a call site in a template or an inline function has its own counter,
+    /// their hits are added up.
+    pub fn call_site_hits(&self, memory: &MemoryImage) -> Result<Vec<CallSiteHits>, Error> {
+        let mut hits_by_format_id: HashMap<usize, u64> = HashMap::new();
+        for counter in &self.counter_sites {
+            let value = memory
+                .read_u32(counter.counter_address)
+                .ok_or(Error::MissingCounter(counter.counter_address))?;
+            *hits_by_format_id.entry(counter.format_id).or_default() += value as u64;
+        }
+        Ok(self
+            .call_sites()
+            .into_iter()
+            .filter_map(|call_site| {
+                let hits = *hits_by_format_id.get(&call_site.format_id)?;
+                Some(CallSiteHits {
+                    estimated_bytes: hits * estimated_record_size(&call_site),
+                    hits,
+                    call_site,
+                })
+            })
+            .collect())
+    }
+}
+
+/// Formats the call sites ranked by hits and by estimated bytes, showing the first `top` of
+/// each ranking.
+pub fn format_report(hits: &mut [CallSiteHits], top: usize) -> String {
+    let total_hits: u64 = hits.iter().map(|h| h.hits).sum();
+    let total_bytes: u64 = hits.iter().map(|h| h.estimated_bytes).sum();
+    let share = |value: u64, total: u64| {
+        if total == 0 {
+            0f64
+        } else {
+            value as f64 * 100f64 / total as f64
+        }
+    };
+
+    let mut report = String::new();
+    for &by_bytes in &[false, true] {
+        if by_bytes {
+            hits.sort_by(|a, b| b.estimated_bytes.cmp(&a.estimated_bytes));
+            report.push_str("\nCall sites by estimated bytes:\n");
+        } else {
+            hits.sort_by(|a, b| b.hits.cmp(&a.hits));
+            writeln!(
+                report,
+                "{} hits, about {} bytes, in {} call sites",
+                total_hits,
+                total_bytes,
+                hits.len()
+            )
+            .unwrap();
+            report.push_str("\nCall sites by hits:\n");
+        }
+        writeln!(
+            report,
+            "{:>10} {:>6} {:>12} {:>6}  {:<7}  site",
+            "hits", "%", "bytes", "%", "level"
+        )
+        .unwrap();
+        for site in hits.iter().take(top) {
+            writeln!(
+                report,
+                "{:>10} {:>5.1}% {:>12} {:>5.1}%  {:<7}  {}:{} \"{}\"",
+                site.hits,
+                share(site.hits, total_hits),
+                site.estimated_bytes,
+                share(site.estimated_bytes, total_bytes),
+                site.call_site.level.to_string(),
+                site.call_site.file_name,
+                site.call_site.line_number,
+                site.call_site.format
+            )
+            .unwrap();
+        }
+    }
+    report
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{LogLevel, LogSection};
+
+    fn call_site(format_id: usize, format: &str) -> CallSite {
+        CallSite {
+            format_id,
+            level: LogLevel::Info,
+            file_name: "main.cpp".to_owned(),
+            line_number: 10,
+            format: format.to_owned(),
+        }
+    }
+
+    #[test]
+    fn test_parse_counter_sites() {
+        let section = [0x10, 0, 0, 0x20, 45, 0, 0, 0, 0x14, 0, 0, 0x20, 0, 1, 0, 0];
+        assert_eq!(
+            parse_counter_sites(&section, 4),
+            vec![
+                CounterSite {
+                    counter_address: 0x2000_0010,
+                    format_id: 45
+                },
+                CounterSite {
+                    counter_address: 0x2000_0014,
+                    format_id: 256
+                },
+            ]
+        );
+    }
+
+    #[test]
+    fn test_estimated_record_size() {
+        assert_eq!(estimated_record_size(&call_site(10, "no arguments")), 6);
+        assert_eq!(
+            estimated_record_size(&call_site(300, "%d%% of %s at %p")),
+            10
+        );
+    }
+
+    #[test]
+    fn test_call_site_hits() {
+        let elf_metadata = ElfMetadata {
+            timestamp_freq: 1f64,
+            strings: b"main.cpp@10@Starting %s\0main.cpp@12@Low battery: %u\0".to_vec(),
+            log_sections: vec![LogSection {
+                level: LogLevel::Info,
+                start: 0,
+                end: 52,
+            }],
+            // The second call site is instantiated twice
+            counter_sites: vec![
+                CounterSite {
+                    counter_address: 0x100,
+                    format_id: 0,
+                },
+                CounterSite {
+                    counter_address: 0x104,
+                    format_id: 24,
+                },
+                CounterSite {
+                    counter_address: 0x10C,
+                    format_id: 24,
+                },
+            ],
+            enum_types: Default::default(),
+        };
+        assert_eq!(elf_metadata.counters_range(), Some((0x100, 0x110)));
+
+        let memory = MemoryImage {
+            base: 0x100,
+            data: vec![1, 0, 0, 0, 2, 1, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF, 3, 0, 0, 0],
+        };
+        let hits = elf_metadata.call_site_hits(&memory).unwrap();
+        assert_eq!(hits.len(), 2);
+        assert_eq!(hits[0].hits, 1);
+        assert_eq!(hits[0].estimated_bytes, 7);
+        assert_eq!(hits[1].call_site.line_number, 12);
+        assert_eq!(hits[1].hits, 261);
+
+        let memory = MemoryImage {
+            base: 0x104,
+            data: memory.data[4..].to_vec(),
+        };
+        assert!(matches!(
+            elf_metadata.call_site_hits(&memory),
+            Err(Error::MissingCounter(0x100))
+        ));
+    }
+
+    #[test]
+    fn test_report_ranks_sites() {
+        let mut hits = vec![
+            CallSiteHits {
+                call_site: call_site(0, "rare"),
+                hits: 1,
+                estimated_bytes: 100,
+            },
+            CallSiteHits {
+                call_site: call_site(5, "frequent"),
+                hits: 3,
+                estimated_bytes: 18,
+            },
+        ];
+        let report = format_report(&mut hits, 1);
+        let lines: Vec<&str> = report.lines().collect();
+        assert_eq!(lines[0], "4 hits, about 118 bytes, in 2 call sites");
+        assert_eq!(lines[2], "Call sites by hits:");
+        assert!(lines[4].ends_with("main.cpp:10 \"frequent\""));
+        assert!(lines[4].contains(" 75.0% "));
+        assert_eq!(lines[6], "Call sites by estimated bytes:");
+        assert!(lines[8].ends_with("main.cpp:10 \"rare\""));
+        assert_eq!(lines.len(), 9);
+    }
+}
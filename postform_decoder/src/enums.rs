@@ -0,0 +1,194 @@
+//! Names of the enumerators of the firmware, read from its DWARF debug info.
+
+use gimli::{AttributeValue, EndianSlice, Reader, RunTimeEndian, SectionId};
+use object::read::{File as ElfFile, Object, ObjectSection};
+use std::collections::HashMap;
+
+/// Enumerators of every enum type of the firmware, indexed by the name of the type.
+///
+/// Types are named as in C++, with the namespaces and classes that enclose them, e.g.
+/// `net::Link::State`. They can also be found by their name alone as long as it is unique.
+#[derive(Clone, Debug, Default, PartialEq)]
+pub struct EnumTypes {
+    types: HashMap<String, HashMap<i64, String>>,
+}
+
+impl EnumTypes {
+    /// Reads the enum types described in the `.debug_info` section of the ELF file. Firmware
+    /// built without debug info has no enum types.
+    pub(crate) fn from_elf_file(elf_file: &ElfFile) -> Result<Self, gimli::Error> {
+        let endian = if elf_file.is_little_endian() {
+            RunTimeEndian::Little
+        } else {
+            RunTimeEndian::Big
+        };
+        let section = |id: SectionId| {
+            let data = elf_file
+                .section_by_name(id.name())
+                .and_then(|section| section.data().ok())
+                .unwrap_or(&[]);
+            EndianSlice::new(data, endian)
+        };
+
+        // Units also parse their line program, and may refer to strings and addresses through
+        // the offset tables of DWARF 5.
+        let mut dwarf = gimli::Dwarf::default();
+        dwarf.debug_abbrev = section(SectionId::DebugAbbrev).into();
+        dwarf.debug_addr = section(SectionId::DebugAddr).into();
+        dwarf.debug_info = section(SectionId::DebugInfo).into();
+        dwarf.debug_line = section(SectionId::DebugLine).into();
+        dwarf.debug_line_str = section(SectionId::DebugLineStr).into();
+        dwarf.debug_str = section(SectionId::DebugStr).into();
+        dwarf.debug_str_offsets = section(SectionId::DebugStrOffsets).into();
+
+        let mut enum_types = EnumTypes::default();
+        let mut units = dwarf.units();
+        while let Some(header) = units.next()? {
+            let unit = gimli::Unit::new(&dwarf, header)?;
+            enum_types.read_unit(&dwarf, &unit)?;
+        }
+        enum_types.add_unqualified_names();
+        Ok(enum_types)
+    }
+
+    fn read_unit<R: Reader>(
+        &mut self,
+        dwarf: &gimli::Dwarf<R>,
+        unit: &gimli::Unit<R>,
+    ) -> Result<(), gimli::Error> {
+        let name = |entry: &gimli::DebuggingInformationEntry<R>| -> Result<_, gimli::Error> {
+            Ok(match entry.attr_value(gimli::DW_AT_name)? {
+                Some(value) => Some(
+                    dwarf
+                        .attr_string(unit, value)?
+                        .to_string_lossy()?
+                        .into_owned(),
+                ),
+                None => None,
+            })
+        };
+
+        // Names of the entries enclosing the current one, by depth. Entries that don't name a
+        // scope, like functions, are left out of the names of the types they hold.
+        let mut scopes: Vec<Option<String>> = vec![];
+        // Depth and qualified name of the last enum type found
+        let mut current_enum: Option<(usize, String)> = None;
+        let mut depth = 0isize;
+        let mut entries = unit.entries();
+        while let Some((delta_depth, entry)) = entries.next_dfs()? {
+            depth += delta_depth;
+            let depth = depth as usize;
+            scopes.truncate(depth);
+
+            let scope = match entry.tag() {
+                gimli::DW_TAG_enumerator => {
+                    let value = entry.attr_value(gimli::DW_AT_const_value)?;
+                    match (&current_enum, value.and_then(const_value)) {
+                        (Some((enum_depth, type_name)), Some(value)) if enum_depth + 1 == depth => {
+                            if let Some(name) = name(entry)? {
+                                self.insert(type_name, value, name);
+                            }
+                        }
+                        _ => {}
+                    }
+                    None
+                }
+                gimli::DW_TAG_enumeration_type => {
+                    let type_name = name(entry)?;
+                    current_enum = type_name.as_ref().map(|type_name| {
+                        let mut qualified: Vec<&str> =
+                            scopes.iter().filter_map(Option::as_deref).collect();
+                        qualified.push(type_name);
+                        (depth, qualified.join("::"))
+                    });
+                    type_name
+                }
+                gimli::DW_TAG_namespace
+                | gimli::DW_TAG_class_type
+                | gimli::DW_TAG_structure_type
+                | gimli::DW_TAG_union_type => name(entry)?,
+                _ => None,
+            };
+            scopes.push(scope);
+        }
+        Ok(())
+    }
+
+    fn insert(&mut self, type_name: &str, value: i64, name: String) {
+        self.types
+            .entry(type_name.to_owned())
+            .or_default()
+            .insert(value, name);
+    }
+
+    /// Makes the types reachable by their name without enclosing scopes when no other type
+    /// shares it.
+    fn add_unqualified_names(&mut self) {
+        let mut unqualified: HashMap<&str, Option<&String>> = HashMap::new();
+        for qualified in self.types.keys() {
+            if let Some((_, name)) = qualified.rsplit_once("::") {
+                unqualified
+                    .entry(name)
+                    .and_modify(|unique| *unique = None)
+                    .or_insert(Some(qualified));
+            }
+        }
+        let aliases: Vec<(String, HashMap<i64, String>)> = unqualified
+            .into_iter()
+            .filter(|(name, _)| !self.types.contains_key(*name))
+            .filter_map(|(name, qualified)| Some((name.to_owned(), self.types[qualified?].clone())))
+            .collect();
+        self.types.extend(aliases);
+    }
+
+    /// Name of the enumerator of the type with the given value, if there is one.
+    pub fn enumerator_name(&self, type_name: &str, value: i64) -> Option<&str> {
+        self.types.get(type_name)?.get(&value).map(String::as_str)
+    }
+}
+
+/// Value of an enumerator. Enumerators of unsigned types with values that don't fit in an i64
+/// wrap around, as they do when sent by the firmware.
+fn const_value<R: Reader>(value: AttributeValue<R>) -> Option<i64> {
+    match value {
+        AttributeValue::Sdata(value) => Some(value),
+        AttributeValue::Udata(value) => Some(value as i64),
+        AttributeValue::Data1(value) => Some(value as i64),
+        AttributeValue::Data2(value) => Some(value as i64),
+        AttributeValue::Data4(value) => Some(value as i64),
+        AttributeValue::Data8(value) => Some(value as i64),
+        _ => None,
+    }
+}
+
+#[cfg(test)]
+pub(crate) mod tests {
+    use super::*;
+
+    pub(crate) fn create_enum_types() -> EnumTypes {
+        let mut enum_types = EnumTypes::default();
+        enum_types.insert("net::Link::State", 0, "kDown".to_owned());
+        enum_types.insert("net::Link::State", -1, "kError".to_owned());
+        enum_types.insert("usb::State", 0, "kDetached".to_owned());
+        enum_types.insert("app::Mode", 2, "kRun".to_owned());
+        enum_types.insert("Mode", 1, "kGlobal".to_owned());
+        enum_types.add_unqualified_names();
+        enum_types
+    }
+
+    #[test]
+    fn test_enumerator_names() {
+        let enum_types = create_enum_types();
+        assert_eq!(
+            enum_types.enumerator_name("net::Link::State", -1),
+            Some("kError")
+        );
+        assert_eq!(enum_types.enumerator_name("Link::State", -1), None);
+        assert_eq!(enum_types.enumerator_name("net::Link::State", 1), None);
+        // Unqualified names are ambiguous or already taken by another type
+        assert_eq!(enum_types.enumerator_name("State", 0), None);
+        assert_eq!(enum_types.enumerator_name("Mode", 2), None);
+        assert_eq!(enum_types.enumerator_name("Mode", 1), Some("kGlobal"));
+        assert_eq!(enum_types.enumerator_name("app::Mode", 2), Some("kRun"));
+    }
+}
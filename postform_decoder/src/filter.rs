@@ -0,0 +1,246 @@
+use crate::{decode_format_id, CallSite, ElfMetadata, LogLevel};
+use std::collections::HashSet;
+
+/// Selects logs by the properties of their call site.
+///
+/// Level, file, line and format string are all known from the format ID of a log, so the filter
+/// is resolved once against the call sites of the firmware. Logs are then selected by their
+/// format ID alone, without decoding or formatting any of their arguments.
+#[derive(Debug, Default)]
+pub struct Filter {
+    /// Minimum level of the selected logs.
+    pub min_level: Option<LogLevel>,
+    /// Text contained in the file name of the call site.
+    pub file: Option<String>,
+    /// Line number of the call site.
+    pub line: Option<u32>,
+    /// Text contained in the format string.
+    pub text: Option<String>,
+}
+
+impl Filter {
+    /// Returns true if the filter selects every log.
+    pub fn is_empty(&self) -> bool {
+        self.min_level.is_none()
+            && self.file.is_none()
+            && self.line.is_none()
+            && self.text.is_none()
+    }
+
+    fn selects(&self, call_site: &CallSite) -> bool {
+        self.min_level
+            .map_or(true, |level| call_site.level >= level)
+            && self
+                .file
+                .as_ref()
+                .map_or(true, |file| call_site.file_name.contains(file.as_str()))
+            && self.line.map_or(true, |line| call_site.line_number == line)
+            && self
+                .text
+                .as_ref()
+                .map_or(true, |text| call_site.format.contains(text.as_str()))
+    }
+
+    /// Resolves the filter into the set of format IDs it selects.
+    pub fn resolve(&self, elf_metadata: &ElfMetadata) -> FormatIdSet {
+        FormatIdSet {
+            ids: elf_metadata
+                .call_sites()
+                .iter()
+                .filter(|call_site| self.selects(call_site))
+                .map(|call_site| call_site.format_id)
+                .collect(),
+        }
+    }
+}
+
+/// Set of format IDs selected by a `Filter`.
+#[derive(Debug)]
+pub struct FormatIdSet {
+    ids: HashSet<usize>,
+}
+
+impl FormatIdSet {
+    /// Number of call sites in the set.
+    pub fn len(&self) -> usize {
+        self.ids.len()
+    }
+
+    /// Returns true if no call site is selected.
+    pub fn is_empty(&self) -> bool {
+        self.ids.is_empty()
+    }
+
+    /// Checks whether a raw log belongs to the set, reading only its timestamp and format ID.
+    pub fn contains(&self, log: &[u8]) -> bool {
+        decode_format_id(log).map_or(false, |id| self.ids.contains(&id))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{Decoder, LogSection};
+
+    fn create_elf_metadata() -> ElfMetadata {
+        let strings = b"main.cpp@10@Starting %s\0main.cpp@12@Low battery: %u\0\0\
+                        driver.cpp@40@Timeout after %u ms\0"
+            .to_vec();
+        ElfMetadata {
+            timestamp_freq: 1f64,
+            strings,
+            log_sections: vec![
+                LogSection {
+                    level: LogLevel::Info,
+                    start: 0,
+                    end: 24,
+                },
+                LogSection {
+                    level: LogLevel::Warning,
+                    start: 24,
+                    end: 52,
+                },
+                LogSection {
+                    level: LogLevel::Error,
+                    start: 52,
+                    end: 87,
+                },
+            ],
+            counter_sites: vec![],
+            enum_types: Default::default(),
+        }
+    }
+
+    fn ids(filter: Filter) -> Vec<usize> {
+        let elf_metadata = create_elf_metadata();
+        let mut ids: Vec<_> = filter.resolve(&elf_metadata).ids.into_iter().collect();
+        ids.sort_unstable();
+        ids
+    }
+
+    #[test]
+    fn test_call_sites() {
+        let call_sites = create_elf_metadata().call_sites();
+        let ids: Vec<_> = call_sites.iter().map(|site| site.format_id).collect();
+        assert_eq!(ids, vec![0, 24, 53]);
+        assert_eq!(call_sites[2].file_name, "driver.cpp");
+        assert_eq!(call_sites[2].line_number, 40);
+        assert_eq!(call_sites[2].format, "Timeout after %u ms");
+    }
+
+    #[test]
+    fn test_filter_by_level() {
+        let filter = Filter {
+            min_level: Some(LogLevel::Warning),
+            ..Filter::default()
+        };
+        assert_eq!(ids(filter), vec![24, 53]);
+    }
+
+    #[test]
+    fn test_filter_by_file_and_line() {
+        let filter = Filter {
+            file: Some("main".to_owned()),
+            line: Some(12),
+            ..Filter::default()
+        };
+        assert_eq!(ids(filter), vec![24]);
+    }
+
+    #[test]
+    fn test_filter_by_text() {
+        let filter = Filter {
+            text: Some("%u".to_owned()),
+            ..Filter::default()
+        };
+        assert_eq!(ids(filter), vec![24, 53]);
+    }
+
+    #[test]
+    fn test_filter_selects_trace_spans() {
+        let mut elf_metadata = create_elf_metadata();
+        elf_metadata.strings.extend_from_slice(b"radio_tx\0");
+        elf_metadata.log_sections.push(LogSection {
+            level: LogLevel::Trace,
+            start: 87,
+            end: 96,
+        });
+        let trace_level = Filter {
+            min_level: Some(LogLevel::Trace),
+            ..Filter::default()
+        }
+        .resolve(&elf_metadata);
+        // Timestamp 300, span 87 and the begin event
+        assert!(trace_level.contains(&[0xAC, 0x02, 87, 0]));
+        assert!(trace_level.contains(&[0xAC, 0x02, 53, 7]));
+
+        let grep = Filter {
+            text: Some("radio".to_owned()),
+            ..Filter::default()
+        }
+        .resolve(&elf_metadata);
+        assert!(grep.contains(&[0xAC, 0x02, 87, 0]));
+        assert_eq!(grep.len(), 1);
+
+        let debug_level = Filter {
+            min_level: Some(LogLevel::Debug),
+            ..Filter::default()
+        }
+        .resolve(&elf_metadata);
+        assert!(!debug_level.contains(&[0xAC, 0x02, 87, 0]));
+    }
+
+    #[test]
+    fn test_filter_keeps_metric_samples() {
+        let mut elf_metadata = create_elf_metadata();
+        elf_metadata
+            .strings
+            .extend_from_slice(b"c@rx_bytes\0g@temperature\0");
+        elf_metadata.log_sections.push(LogSection {
+            level: LogLevel::Metric,
+            start: 87,
+            end: 112,
+        });
+        // Timestamp and format ID of each record, then the delta or value of the sample
+        let records: [&[u8]; 3] = [&[0x01, 87, 0xAC, 0x02], &[0x02, 98, 0x7E], &[0x03, 53, 7]];
+        // The samples that reach the exporters once the records are filtered
+        let samples = |filter: Filter| -> Vec<String> {
+            let set = filter.resolve(&elf_metadata);
+            records
+                .iter()
+                .filter(|record| set.contains(record))
+                .map(|record| Decoder::new(&elf_metadata).decode(record).unwrap())
+                .filter(|log| log.level == LogLevel::Metric)
+                .map(|log| log.message)
+                .collect()
+        };
+
+        let metric_level = Filter {
+            min_level: Some(LogLevel::Metric),
+            ..Filter::default()
+        };
+        assert_eq!(
+            samples(metric_level),
+            vec!["rx_bytes += 300", "temperature = -2"]
+        );
+        let grep = Filter {
+            text: Some("temperature".to_owned()),
+            ..Filter::default()
+        };
+        assert_eq!(samples(grep), vec!["temperature = -2"]);
+    }
+
+    #[test]
+    fn test_contains_reads_format_id() {
+        let elf_metadata = create_elf_metadata();
+        let set = Filter {
+            min_level: Some(LogLevel::Error),
+            ..Filter::default()
+        }
+        .resolve(&elf_metadata);
+        // Timestamp 300 (2 bytes), format ID 53, argument 7
+        assert!(set.contains(&[0xAC, 0x02, 53, 7]));
+        assert!(!set.contains(&[0xAC, 0x02, 24, 7]));
+        assert!(!set.contains(&[0xAC]));
+    }
+}
@@ -0,0 +1,141 @@
+use crate::Argument;
+use std::collections::BTreeMap;
+use std::fmt::Write;
+
+/// Bucket counts of a histogram recorded by `Postform::Histogram`.
+///
+/// Values below 2^sub_bucket_bits have a bucket each, and every power of two above them is split
+/// in 2^sub_bucket_bits buckets of the same width.
+#[derive(Clone, Debug, PartialEq)]
+pub struct Histogram {
+    sub_bucket_bits: u32,
+    counts: BTreeMap<usize, u64>,
+}
+
+/// Percentiles shown when a histogram is formatted.
+const SUMMARY_PERCENTILES: [(&str, f64); 3] = [("p50", 0.5), ("p90", 0.9), ("p99", 0.99)];
+
+impl Histogram {
+    /// Creates an empty histogram.
+    pub fn new(sub_bucket_bits: u32) -> Self {
+        Self {
+            sub_bucket_bits,
+            counts: BTreeMap::new(),
+        }
+    }
+
+    /// Builds the histogram from the arguments of its log: the number of sub-bucket bits
+    /// followed by pairs of bucket index and count.
+    pub(crate) fn from_arguments(arguments: &[Argument]) -> Option<Self> {
+        let mut values = arguments.iter().map(|argument| match argument {
+            Argument::Unsigned(value) => Some(*value),
+            _ => None,
+        });
+        let mut histogram = Self::new(values.next()?? as u32);
+        while let Some(index) = values.next() {
+            let count = values.next()??;
+            *histogram.counts.entry(index? as usize).or_default() += count;
+        }
+        Some(histogram)
+    }
+
+    /// Returns the smallest and largest values counted in a bucket.
+    pub fn bucket_range(&self, index: usize) -> (u64, u64) {
+        let sub_buckets = 1usize << self.sub_bucket_bits;
+        if index < sub_buckets {
+            return (index as u64, index as u64);
+        }
+        let shift = (index >> self.sub_bucket_bits) - 1;
+        let lower = ((sub_buckets | (index & (sub_buckets - 1))) as u64) << shift;
+        (lower, lower + (1u64 << shift) - 1)
+    }
+
+    /// Total number of samples.
+    pub fn count(&self) -> u64 {
+        self.counts.values().sum()
+    }
+
+    /// Returns the non-empty buckets as their largest value and their count, in increasing
+    /// order.
+    pub fn buckets(&self) -> impl Iterator<Item = (u64, u64)> + '_ {
+        self.counts
+            .iter()
+            .map(move |(&index, &count)| (self.bucket_range(index).1, count))
+    }
+
+    /// Returns an upper bound of the given percentile, between 0 and 1: the largest value of the
+    /// bucket holding it. Returns None if the histogram is empty.
+    pub fn percentile(&self, percentile: f64) -> Option<u64> {
+        let count = self.count();
+        if count == 0 {
+            return None;
+        }
+        let rank = ((percentile * count as f64).ceil() as u64).max(1);
+        let mut seen = 0;
+        self.buckets().find_map(|(upper, bucket_count)| {
+            seen += bucket_count;
+            if seen >= rank {
+                Some(upper)
+            } else {
+                None
+            }
+        })
+    }
+
+    /// Adds the samples of another histogram with the same buckets.
+    pub fn merge(&mut self, other: &Histogram) {
+        for (&index, &count) in &other.counts {
+            *self.counts.entry(index).or_default() += count;
+        }
+    }
+
+    /// Formats the number of samples and the main percentiles of the histogram.
+    pub fn summary(&self) -> String {
+        let mut summary = format!("count={}", self.count());
+        for (label, percentile) in &SUMMARY_PERCENTILES {
+            if let Some(value) = self.percentile(*percentile) {
+                write!(summary, " {}<={}", label, value).unwrap();
+            }
+        }
+        if let Some((max, _)) = self.buckets().last() {
+            write!(summary, " max<={}", max).unwrap();
+        }
+        summary
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_bucket_ranges() {
+        let histogram = Histogram::new(3);
+        assert_eq!(histogram.bucket_range(7), (7, 7));
+        assert_eq!(histogram.bucket_range(8), (8, 8));
+        assert_eq!(histogram.bucket_range(16), (16, 17));
+        assert_eq!(histogram.bucket_range(47), (240, 255));
+        assert_eq!(histogram.bucket_range(239), (0xF000_0000, u32::MAX as u64));
+    }
+
+    #[test]
+    fn test_percentiles() {
+        let histogram = Histogram::from_arguments(&[
+            Argument::Unsigned(3),
+            Argument::Unsigned(3),
+            Argument::Unsigned(90),
+            Argument::Unsigned(47),
+            Argument::Unsigned(10),
+        ])
+        .unwrap();
+        assert_eq!(histogram.count(), 100);
+        assert_eq!(histogram.percentile(0.5), Some(3));
+        assert_eq!(histogram.percentile(0.9), Some(3));
+        assert_eq!(histogram.percentile(0.91), Some(255));
+        assert_eq!(
+            histogram.summary(),
+            "count=100 p50<=3 p90<=3 p99<=255 max<=255"
+        );
+        assert_eq!(Histogram::new(3).percentile(0.5), None);
+    }
+}
@@ -2,6 +2,15 @@ use byteorder::{LittleEndian, ReadBytesExt};
 use object::read::{File as ElfFile, Object, ObjectSection, ObjectSymbol};
 use std::{fs, path::PathBuf};
 
+pub mod counters;
+pub mod enums;
+pub mod filter;
+pub mod histogram;
+
+use counters::CounterSite;
+use enums::EnumTypes;
+use histogram::Histogram;
+
 include!(concat!(env!("OUT_DIR"), "/version.rs"));
 
 /// Error type for Postform Decoder.
@@ -29,6 +38,8 @@ pub enum Error {
     MismatchedPostformVersions(String, String),
     #[error("Log Level not found")]
     LevelNotFound,
+    #[error("Invalid log level: '{0}'")]
+    InvalidLogLevel(String),
     #[error("Invalid format string")]
     InvalidFormatString,
     #[error("Invalid log message")]
@@ -37,11 +48,17 @@ pub enum Error {
     MissingLogArgument,
     #[error("Invalid format specifier: '{0}'")]
     InvalidFormatSpecifier(char),
+    #[error("Counter at 0x{0:x} is not in the memory image")]
+    MissingCounter(u64),
 }
 
 /// Available log levels of Postform.
-#[derive(Copy, Clone, Debug, strum_macros::ToString)]
+#[derive(Copy, Clone, Debug, PartialEq, Eq, PartialOrd, Ord, strum_macros::ToString)]
 pub enum LogLevel {
+    /// Begin and end events of trace spans.
+    Trace,
+    /// Counter and gauge samples.
+    Metric,
     Debug,
     Info,
     Warning,
@@ -74,6 +91,22 @@ impl LogLevel {
     }
 }
 
+impl std::str::FromStr for LogLevel {
+    type Err = Error;
+
+    fn from_str(level: &str) -> Result<Self, Self::Err> {
+        match level.to_lowercase().as_str() {
+            "trace" => Ok(LogLevel::Trace),
+            "metric" => Ok(LogLevel::Metric),
+            "debug" => Ok(LogLevel::Debug),
+            "info" => Ok(LogLevel::Info),
+            "warning" => Ok(LogLevel::Warning),
+            "error" => Ok(LogLevel::Error),
+            _ => Err(Error::InvalidLogLevel(level.to_owned())),
+        }
+    }
+}
+
 struct LogSection {
     level: LogLevel,
     start: usize,
@@ -87,6 +120,71 @@ pub struct Log {
     pub message: String,
     pub file_name: String,
     pub line_number: u32,
+    /// Identifier of the format string of the log.
+    pub format_id: usize,
+    /// Format string, without file name and line number.
+    pub format: String,
+    /// Typed values of the arguments, in order.
+    pub arguments: Vec<Argument>,
+}
+
+/// Event of a trace span.
+#[derive(Copy, Clone, Debug, PartialEq)]
+pub enum TraceEvent {
+    Begin,
+    End,
+}
+
+/// Sample of a metric.
+#[derive(Clone, Debug, PartialEq)]
+pub enum MetricSample {
+    /// Amount added to a counter.
+    Counter(u64),
+    /// Current value of a gauge.
+    Gauge(i64),
+    /// Samples accumulated by a histogram since its previous record.
+    Histogram(Histogram),
+}
+
+impl Log {
+    /// Returns the name and sample of a metric log. Returns None for regular logs.
+    ///
+    /// The `format` of a metric log is its interned string: its kind, 'c' for counters, 'g' for
+    /// gauges or 'h' for histograms, followed by '@' and its name.
+    pub fn metric(&self) -> Option<(&str, MetricSample)> {
+        if self.level != LogLevel::Metric {
+            return None;
+        }
+        let (kind, name) = self.format.split_at(self.format.find('@')?);
+        let sample = match (kind, self.arguments.first()) {
+            ("c", Some(Argument::Unsigned(delta))) => MetricSample::Counter(*delta),
+            ("g", Some(Argument::Signed(value))) => MetricSample::Gauge(*value),
+            ("h", _) => MetricSample::Histogram(Histogram::from_arguments(&self.arguments)?),
+            _ => return None,
+        };
+        Some((&name[1..], sample))
+    }
+
+    /// Returns the event of a trace log, whose `format` is the name of the span. Returns None
+    /// for regular logs.
+    pub fn trace_event(&self) -> Option<TraceEvent> {
+        match (self.level, self.arguments.first()) {
+            (LogLevel::Trace, Some(Argument::Unsigned(0))) => Some(TraceEvent::Begin),
+            (LogLevel::Trace, Some(Argument::Unsigned(1))) => Some(TraceEvent::End),
+            _ => None,
+        }
+    }
+}
+
+/// Log call site of the firmware, recovered from its format string.
+#[derive(Debug)]
+pub struct CallSite {
+    /// Identifier of the format string, as sent in every log of the call site.
+    pub format_id: usize,
+    pub level: LogLevel,
+    pub file_name: String,
+    pub line_number: u32,
+    pub format: String,
 }
 
 /// The ElfMetadata struct encapsulates all log metadata contained in the target ELF file.
@@ -115,25 +213,114 @@ pub struct ElfMetadata {
     timestamp_freq: f64,
     strings: Vec<u8>,
     log_sections: Vec<LogSection>,
+    counter_sites: Vec<CounterSite>,
+    enum_types: EnumTypes,
+}
+
+fn read_postform_version(elf_file: &ElfFile) -> Result<String, Error> {
+    let postform_version = elf_file
+        .section_by_name(".postform_version")
+        .ok_or(Error::MissingPostformVersion)?
+        .data()?;
+
+    Ok(String::from_utf8_lossy(
+        &postform_version[..postform_version
+            .iter()
+            .position(|&c| c == b'\0')
+            .unwrap_or(postform_version.len())],
+    )
+    .to_string())
+}
+
+/// Sections of the ELF file read by the decoder. Builds that differ in any of them decode
+/// differently.
+const DECODED_SECTIONS: [&str; 11] = [
+    ".postform_version",
+    ".postform_config",
+    ".interned_strings",
+    ".postform_counters",
+    ".debug_abbrev",
+    ".debug_addr",
+    ".debug_info",
+    ".debug_line",
+    ".debug_line_str",
+    ".debug_str",
+    ".debug_str_offsets",
+];
+
+/// 64-bit FNV-1a hash. Unlike the hashers of std its output never changes between Rust
+/// releases, so it can identify builds in files that outlive the toolchain.
+struct Fnv1a(u64);
+
+impl Fnv1a {
+    fn new() -> Self {
+        Fnv1a(0xcbf2_9ce4_8422_2325)
+    }
+
+    fn write(&mut self, bytes: &[u8]) {
+        for &byte in bytes {
+            self.0 ^= byte as u64;
+            self.0 = self.0.wrapping_mul(0x0000_0100_0000_01b3);
+        }
+    }
+}
+
+/// Identifies the build of an ELF file without loading its metadata.
+///
+/// Returns the GNU build ID when the firmware was linked with one. Otherwise the
+/// `.postform_version` of the firmware is combined with a hash of every section the decoder
+/// reads and of the bounds of the log levels, so two builds of the same version that decode
+/// differently are never mistaken for each other.
+pub fn build_id(elf_data: &[u8]) -> Result<String, Error> {
+    let elf_file = ElfFile::parse(elf_data)?;
+    if let Some(build_id) = elf_file.build_id()? {
+        return Ok(build_id.iter().map(|b| format!("{:02x}", b)).collect());
+    }
+
+    let postform_version = read_postform_version(&elf_file)?;
+    elf_file
+        .section_by_name(".interned_strings")
+        .ok_or(Error::MissingInternedStrings)?;
+    let mut hasher = Fnv1a::new();
+    for name in &DECODED_SECTIONS {
+        hasher.write(name.as_bytes());
+        match elf_file.section_by_name(name) {
+            Some(section) => {
+                let data = section.data()?;
+                hasher.write(&(data.len() as u64).to_le_bytes());
+                hasher.write(data);
+            }
+            None => hasher.write(&u64::MAX.to_le_bytes()),
+        }
+    }
+    for level in &[
+        LogLevel::Trace,
+        LogLevel::Metric,
+        LogLevel::Debug,
+        LogLevel::Info,
+        LogLevel::Warning,
+        LogLevel::Error,
+    ] {
+        if let Ok((start, end)) = level.find_level_in_elf(&elf_file) {
+            hasher.write(&(start as u64).to_le_bytes());
+            hasher.write(&(end as u64).to_le_bytes());
+        }
+    }
+    Ok(format!("{}-{:016x}", postform_version, hasher.0))
 }
 
 impl ElfMetadata {
     /// Attempts to instantiate the ElfMetadata struct from the provided ELF file.
     pub fn from_elf_file(elf_path: &PathBuf) -> Result<Self, Error> {
         let file_contents = fs::read(elf_path)?;
-        let elf_file = ElfFile::parse(&file_contents[..])?;
+        Self::from_elf_data(&file_contents)
+    }
 
-        let postform_version = elf_file
-            .section_by_name(".postform_version")
-            .ok_or(Error::MissingPostformVersion)?
-            .data()?;
+    /// Attempts to instantiate the ElfMetadata struct from the contents of an ELF file.
+    pub fn from_elf_data(elf_data: &[u8]) -> Result<Self, Error> {
+        let elf_file = ElfFile::parse(elf_data)?;
 
-        let postform_version = String::from_utf8_lossy(
-            &postform_version[..postform_version
-                .iter()
-                .position(|&c| c == b'\0')
-                .unwrap_or(postform_version.len())],
-        );
+        let postform_version = read_postform_version(&elf_file)?;
         if postform_version != POSTFORM_VERSION {
             return Err(Error::MismatchedPostformVersions(
                 postform_version.to_string(),
@@ -168,14 +355,89 @@ impl ElfMetadata {
                 println!("Warning: Level {:?} not found in elf file", level);
             }
         }
+        // Firmware without trace spans or metrics may not define their sections.
+        for level in &[LogLevel::Trace, LogLevel::Metric] {
+            if let Ok((start, end)) = level.find_level_in_elf(&elf_file) {
+                sections.push(LogSection {
+                    level: *level,
+                    start,
+                    end,
+                });
+            }
+        }
+
+        // Firmware built without call site counters has no counters section.
+        let counter_sites = match elf_file.section_by_name(".postform_counters") {
+            Some(section) => {
+                let pointer_size = if elf_file.is_64() { 8 } else { 4 };
+                counters::parse_counter_sites(section.data()?, pointer_size)
+            }
+            None => vec![],
+        };
+
+        // Enum arguments are displayed as numbers if the debug info can't be read.
+        let enum_types = EnumTypes::from_elf_file(&elf_file).unwrap_or_else(|error| {
+            println!(
+                "Warning: Unable to read enum types from the debug info: {}",
+                error
+            );
+            EnumTypes::default()
+        });
 
         Ok(Self {
             timestamp_freq,
             strings: interned_strings.into(),
             log_sections: sections,
+            counter_sites,
+            enum_types,
         })
     }
 
+    /// Frequency of the timestamps of the logs, in ticks per second.
+    pub fn timestamp_frequency(&self) -> f64 {
+        self.timestamp_freq
+    }
+
+    /// Returns all the log call sites found in the firmware. Trace spans and metrics are call
+    /// sites too, with the name of the span or the metric as their format string and no file
+    /// name or line number.
+    pub fn call_sites(&self) -> Vec<CallSite> {
+        let decoder = Decoder::new(self);
+        let mut call_sites = vec![];
+        for section in &self.log_sections {
+            let strings = match self.strings.get(section.start..section.end) {
+                Some(strings) => strings,
+                None => continue,
+            };
+            let mut format_id = section.start;
+            for string in strings.split(|&c| c == b'\0') {
+                let format_string = String::from_utf8_lossy(string).to_string();
+                let parsed = match section.level {
+                    LogLevel::Trace if !format_string.is_empty() => {
+                        Some((String::new(), 0, format_string))
+                    }
+                    // Metrics are named after the kind of metric and the '@' separator
+                    LogLevel::Metric => format_string
+                        .split_once('@')
+                        .map(|(_, name)| (String::new(), 0, name.to_owned())),
+                    LogLevel::Trace => None,
+                    _ => decoder.decode_format_string(format_string).ok(),
+                };
+                if let Some((file_name, line_number, format)) = parsed {
+                    call_sites.push(CallSite {
+                        format_id,
+                        level: section.level,
+                        file_name,
+                        line_number,
+                        format,
+                    });
+                }
+                format_id += string.len() + 1;
+            }
+        }
+        call_sites
+    }
+
     fn get_log_section(&self, str_ptr: usize) -> &LogSection {
         let log_section = self
             .log_sections
@@ -193,7 +455,10 @@ impl ElfMetadata {
     }
 
     fn recover_interned_string(&self, str_ptr: usize) -> Result<String, Error> {
-        let str_buffer = &self.strings[str_ptr..];
+        let str_buffer = self
+            .strings
+            .get(str_ptr..)
+            .ok_or(Error::InvalidFormatString)?;
         let end_of_string = str_buffer
             .iter()
             .position(|&c| c == b'\0')
@@ -202,7 +467,126 @@ impl ElfMetadata {
     }
 }
 
-type FormatSpecHandler = for<'a> fn(&Decoder, &mut String, &'_ mut &'a [u8]) -> Result<(), Error>;
+/// Typed value of a log argument.
+#[derive(Clone, Debug, PartialEq)]
+pub enum Argument {
+    Signed(i64),
+    Unsigned(u64),
+    Pointer(u64),
+    String(String),
+    /// String interned in the firmware, sent as a pointer to it.
+    InternedString(String),
+    /// Float or double, sent as its raw IEEE-754 bits.
+    Float(f64),
+    /// Binary buffer, sent as its length followed by its contents.
+    Bytes(Vec<u8>),
+    /// Array of signed integers, sent as its length followed by a varint per element.
+    SignedArray(Vec<i64>),
+    /// Array of unsigned integers, sent as its length followed by a varint per element.
+    UnsignedArray(Vec<u64>),
+    /// Enum, sent as its value. The name of the enumerator is found in the debug info of the
+    /// firmware.
+    Enum {
+        value: i64,
+        name: Option<String>,
+    },
+}
+
+/// How a format specifier is decoded and displayed.
+#[derive(Copy, Clone, Debug)]
+enum Conversion<'a> {
+    String,
+    /// String preceded by its length, without a terminator.
+    StringView,
+    Signed,
+    Unsigned,
+    Octal,
+    Hex,
+    Pointer,
+    InternedString,
+    /// IEEE-754 float of the given number of bytes.
+    Float(FloatStyle, usize),
+    /// Binary buffer, displayed as hex bytes or, if true, as a hexdump.
+    Bytes(bool),
+    /// Array of integers, whose elements are displayed as the conversion specifies.
+    SignedArray,
+    UnsignedArray,
+    OctalArray,
+    HexArray,
+    Percent,
+    /// Enum of the named type, `%{Type}`, displayed as the name of its enumerator.
+    Enum(&'a str),
+}
+
+/// How a floating point argument is displayed, as printf does.
+#[derive(Copy, Clone, Debug)]
+enum FloatStyle {
+    /// `%f`
+    Fixed,
+    /// `%e`
+    Exponent,
+    /// `%g`
+    General,
+}
+
+const FORMAT_SPEC_TABLE: [(&str, Conversion<'static>); 38] = [
+    ("%s", Conversion::String),
+    ("%.*s", Conversion::StringView),
+    ("%hhd", Conversion::Signed),
+    ("%hd", Conversion::Signed),
+    ("%d", Conversion::Signed),
+    ("%ld", Conversion::Signed),
+    ("%lld", Conversion::Signed),
+    ("%hhu", Conversion::Unsigned),
+    ("%hu", Conversion::Unsigned),
+    ("%u", Conversion::Unsigned),
+    ("%lu", Conversion::Unsigned),
+    ("%llu", Conversion::Unsigned),
+    ("%hho", Conversion::Octal),
+    ("%ho", Conversion::Octal),
+    ("%o", Conversion::Octal),
+    ("%lo", Conversion::Octal),
+    ("%llo", Conversion::Octal),
+    ("%hhx", Conversion::Hex),
+    ("%hx", Conversion::Hex),
+    ("%x", Conversion::Hex),
+    ("%lx", Conversion::Hex),
+    ("%llx", Conversion::Hex),
+    ("%p", Conversion::Pointer),
+    ("%k", Conversion::InternedString),
+    ("%f", Conversion::Float(FloatStyle::Fixed, 4)),
+    ("%lf", Conversion::Float(FloatStyle::Fixed, 8)),
+    ("%e", Conversion::Float(FloatStyle::Exponent, 4)),
+    ("%le", Conversion::Float(FloatStyle::Exponent, 8)),
+    ("%g", Conversion::Float(FloatStyle::General, 4)),
+    ("%lg", Conversion::Float(FloatStyle::General, 8)),
+    ("%*b", Conversion::Bytes(false)),
+    ("%*B", Conversion::Bytes(true)),
+    ("%*d", Conversion::SignedArray),
+    ("%*i", Conversion::SignedArray),
+    ("%*u", Conversion::UnsignedArray),
+    ("%*o", Conversion::OctalArray),
+    ("%*x", Conversion::HexArray),
+    ("%%", Conversion::Percent),
+];
+
+/// Name of the enum type of a `%{Type}` specifier at the start of the format string.
+fn enum_type_name(format: &str) -> Option<&str> {
+    let format = format.strip_prefix("%{")?;
+    format.get(..format.find('}')?)
+}
+
+/// Conversion of the format specifier at the start of the format string, along with the length
+/// of the specifier.
+fn parse_format_spec(format: &str) -> Option<(usize, Conversion<'_>)> {
+    if let Some(type_name) = enum_type_name(format) {
+        return Some((type_name.len() + 3, Conversion::Enum(type_name)));
+    }
+    FORMAT_SPEC_TABLE
+        .iter()
+        .find(|(format_spec, _)| format.starts_with(format_spec))
+        .map(|(format_spec, conversion)| (format_spec.len(), *conversion))
+}
 
 fn decode_unsigned(message: &'_ mut &'_ [u8]) -> Result<u64, Error> {
     leb128::read::unsigned(message).map_err(|_| Error::InvalidLogMessage)
@@ -212,92 +596,286 @@ fn decode_signed(message: &'_ mut &'_ [u8]) -> Result<i64, Error> {
     leb128::read::signed(message).map_err(|_| Error::InvalidLogMessage)
 }
 
-fn format_unsigned<'a>(out_str: &mut String, buffer: &'_ mut &'a [u8]) -> Result<(), Error> {
-    let integer_val = decode_unsigned(buffer)?;
-    let integer_str = format!("{}", integer_val);
-    out_str.push_str(&integer_str);
-    Ok(())
+fn decode_float(buffer: &'_ mut &'_ [u8], size: usize) -> Result<f64, Error> {
+    if buffer.len() < size {
+        return Err(Error::InvalidLogMessage);
+    }
+    let (bits, rest) = buffer.split_at(size);
+    *buffer = rest;
+    let value = if size == 4 {
+        f32::from_le_bytes([bits[0], bits[1], bits[2], bits[3]]) as f64
+    } else {
+        let mut bytes = [0u8; 8];
+        bytes.copy_from_slice(bits);
+        f64::from_le_bytes(bytes)
+    };
+    Ok(value)
 }
 
-fn format_signed<'a>(out_str: &mut String, buffer: &'_ mut &'a [u8]) -> Result<(), Error> {
-    let integer_val = decode_signed(buffer)?;
-    let integer_str = format!("{}", integer_val);
-    out_str.push_str(&integer_str);
-    Ok(())
+/// Formats a value in the exponent notation of printf, with a sign and at least two digits in
+/// the exponent.
+fn format_exponent(value: f64, precision: usize) -> String {
+    let formatted = format!("{:.*e}", precision, value);
+    let (mantissa, exponent) = formatted.split_at(formatted.find('e').unwrap());
+    let exponent: i32 = exponent[1..].parse().unwrap();
+    let sign = if exponent < 0 { '-' } else { '+' };
+    format!("{}e{}{:02}", mantissa, sign, exponent.abs())
 }
 
-fn format_octal<'a>(out_str: &mut String, buffer: &'_ mut &'a [u8]) -> Result<(), Error> {
-    let integer_val = decode_unsigned(buffer)?;
-    let integer_str = format!("{:o}", integer_val);
-    out_str.push_str(&integer_str);
-    Ok(())
+/// Removes the trailing zeros of the fraction, and the decimal point if nothing is left after it.
+fn strip_fraction_zeros(number: &str) -> &str {
+    if number.contains('.') {
+        number.trim_end_matches('0').trim_end_matches('.')
+    } else {
+        number
+    }
 }
 
-fn format_hex<'a>(out_str: &mut String, buffer: &'_ mut &'a [u8]) -> Result<(), Error> {
-    let integer_val = decode_unsigned(buffer)?;
-    let integer_str = format!("{:x}", integer_val);
-    out_str.push_str(&integer_str);
-    Ok(())
+/// Formats a float as printf does with the given style and the default precision of 6.
+fn format_float(style: FloatStyle, value: f64) -> String {
+    const PRECISION: usize = 6;
+    if value.is_nan() {
+        return "nan".to_owned();
+    }
+    if value.is_infinite() {
+        return if value < 0f64 { "-inf" } else { "inf" }.to_owned();
+    }
+    match style {
+        FloatStyle::Fixed => format!("{:.*}", PRECISION, value),
+        FloatStyle::Exponent => format_exponent(value, PRECISION),
+        FloatStyle::General => {
+            // The exponent is the one of the value once rounded to the precision
+            let exponent_notation = format_exponent(value, PRECISION - 1);
+            let exponent: i32 = exponent_notation[exponent_notation.find('e').unwrap() + 1..]
+                .parse()
+                .unwrap();
+            if exponent < -4 || exponent >= PRECISION as i32 {
+                let (mantissa, exponent) =
+                    exponent_notation.split_at(exponent_notation.find('e').unwrap());
+                format!("{}{}", strip_fraction_zeros(mantissa), exponent)
+            } else {
+                let fixed = format!("{:.*}", (PRECISION as i32 - 1 - exponent) as usize, value);
+                strip_fraction_zeros(&fixed).to_owned()
+            }
+        }
+    }
 }
 
-fn format_pointer<'a>(out_str: &mut String, buffer: &'_ mut &'a [u8]) -> Result<(), Error> {
-    let integer_val = decode_unsigned(buffer)?;
-    let integer_str = format!("0x{:x}", integer_val);
-    out_str.push_str(&integer_str);
+fn decode_bytes(buffer: &'_ mut &'_ [u8]) -> Result<Vec<u8>, Error> {
+    let length = decode_unsigned(buffer)? as usize;
+    if buffer.len() < length {
+        return Err(Error::MissingLogArgument);
+    }
+    let (bytes, rest) = buffer.split_at(length);
+    *buffer = rest;
+    Ok(bytes.to_vec())
+}
+
+/// Decodes the length of an array followed by each of its elements.
+fn decode_array<T>(
+    buffer: &'_ mut &'_ [u8],
+    decode_element: fn(&'_ mut &'_ [u8]) -> Result<T, Error>,
+) -> Result<Vec<T>, Error> {
+    let length = decode_unsigned(buffer)? as usize;
+    // Every element takes at least a byte, this avoids huge allocations for corrupted lengths
+    if buffer.len() < length {
+        return Err(Error::MissingLogArgument);
+    }
+    (0..length).map(|_| decode_element(buffer)).collect()
+}
+
+/// Formats the elements of an array as a comma separated list between brackets.
+fn format_list<T>(
+    values: &[T],
+    out_str: &mut String,
+    format_element: impl Fn(&T, &mut String) -> std::fmt::Result,
+) -> std::fmt::Result {
+    out_str.push('[');
+    for (index, value) in values.iter().enumerate() {
+        if index != 0 {
+            out_str.push_str(", ");
+        }
+        format_element(value, out_str)?;
+    }
+    out_str.push(']');
     Ok(())
 }
 
-const FORMAT_SPEC_TABLE: [(&str, FormatSpecHandler); 24] = [
-    ("%s", |_, out_str, buffer| {
-        let nul_range_end = buffer
-            .iter()
-            .position(|&c| c == b'\0')
-            .unwrap_or(buffer.len());
-
-        let res =
-            std::str::from_utf8(&buffer[..nul_range_end]).or(Err(Error::MissingLogArgument))?;
-        *buffer = &buffer[nul_range_end + 1..];
-        out_str.push_str(res);
-        Ok(())
-    }),
-    ("%hhd", |_, out_str, buffer| format_signed(out_str, buffer)),
-    ("%hd", |_, out_str, buffer| format_signed(out_str, buffer)),
-    ("%d", |_, out_str, buffer| format_signed(out_str, buffer)),
-    ("%ld", |_, out_str, buffer| format_signed(out_str, buffer)),
-    ("%lld", |_, out_str, buffer| format_signed(out_str, buffer)),
-    ("%hhu", |_, out_str, buffer| {
-        format_unsigned(out_str, buffer)
-    }),
-    ("%hu", |_, out_str, buffer| format_unsigned(out_str, buffer)),
-    ("%u", |_, out_str, buffer| format_unsigned(out_str, buffer)),
-    ("%lu", |_, out_str, buffer| format_unsigned(out_str, buffer)),
-    ("%llu", |_, out_str, buffer| {
-        format_unsigned(out_str, buffer)
-    }),
-    ("%hho", |_, out_str, buffer| format_octal(out_str, buffer)),
-    ("%ho", |_, out_str, buffer| format_octal(out_str, buffer)),
-    ("%o", |_, out_str, buffer| format_octal(out_str, buffer)),
-    ("%lo", |_, out_str, buffer| format_octal(out_str, buffer)),
-    ("%llo", |_, out_str, buffer| format_octal(out_str, buffer)),
-    ("%hhx", |_, out_str, buffer| format_hex(out_str, buffer)),
-    ("%hx", |_, out_str, buffer| format_hex(out_str, buffer)),
-    ("%x", |_, out_str, buffer| format_hex(out_str, buffer)),
-    ("%lx", |_, out_str, buffer| format_hex(out_str, buffer)),
-    ("%llx", |_, out_str, buffer| format_hex(out_str, buffer)),
-    ("%p", |_, out_str, buffer| format_pointer(out_str, buffer)),
-    ("%k", |decoder, out_str, buffer| {
-        let str_ptr = decode_unsigned(buffer)? as usize;
-        let interned_string = decoder
-            .elf_metadata
-            .recover_interned_string(str_ptr as usize)?;
-        out_str.push_str(&interned_string);
-        Ok(())
-    }),
-    ("%%", |_, out_str, _| {
-        out_str.push('%');
-        Ok(())
-    }),
-];
+/// Formats bytes as lowercase hex digits, two per byte.
+pub fn format_hex(bytes: &[u8]) -> String {
+    use std::fmt::Write;
+    let mut hex = String::with_capacity(bytes.len() * 2);
+    for byte in bytes {
+        let _ = write!(hex, "{:02x}", byte);
+    }
+    hex
+}
+
+/// Formats bytes as `hexdump -C` does: lines of 16 bytes with their offset, their hex value and
+/// their printable characters.
+fn format_hexdump(bytes: &[u8], out_str: &mut String) {
+    use std::fmt::Write;
+    for (line, chunk) in bytes.chunks(16).enumerate() {
+        if line != 0 {
+            out_str.push('\n');
+        }
+        let _ = write!(out_str, "{:08x} ", line * 16);
+        for (index, byte) in chunk.iter().enumerate() {
+            if index == 8 {
+                out_str.push(' ');
+            }
+            let _ = write!(out_str, " {:02x}", byte);
+        }
+        // Align the characters of the last line with the others
+        let missing = 16 - chunk.len();
+        let padding = missing * 3 + if chunk.len() <= 8 { 1 } else { 0 };
+        out_str.extend(std::iter::repeat(' ').take(padding));
+        out_str.push_str("  |");
+        out_str.extend(chunk.iter().map(|&byte| {
+            if byte.is_ascii_graphic() || byte == b' ' {
+                byte as char
+            } else {
+                '.'
+            }
+        }));
+        out_str.push('|');
+    }
+}
+
+fn decode_string_view(buffer: &'_ mut &'_ [u8]) -> Result<String, Error> {
+    let length = decode_unsigned(buffer)? as usize;
+    if buffer.len() < length {
+        return Err(Error::MissingLogArgument);
+    }
+    let (string, rest) = buffer.split_at(length);
+    *buffer = rest;
+    // Views may cut a multibyte character in half
+    Ok(String::from_utf8_lossy(string).into_owned())
+}
+
+fn decode_string(buffer: &'_ mut &'_ [u8]) -> Result<String, Error> {
+    let nul_range_end = buffer
+        .iter()
+        .position(|&c| c == b'\0')
+        .ok_or(Error::MissingLogArgument)?;
+
+    let res = std::str::from_utf8(&buffer[..nul_range_end]).or(Err(Error::MissingLogArgument))?;
+    *buffer = &buffer[nul_range_end + 1..];
+    Ok(res.to_owned())
+}
+
+impl Conversion<'_> {
+    /// Decodes the argument of the conversion, if it has one.
+    fn decode(
+        self,
+        elf_metadata: &ElfMetadata,
+        buffer: &'_ mut &'_ [u8],
+    ) -> Result<Option<Argument>, Error> {
+        let argument = match self {
+            Conversion::String => Argument::String(decode_string(buffer)?),
+            Conversion::StringView => Argument::String(decode_string_view(buffer)?),
+            Conversion::Signed => Argument::Signed(decode_signed(buffer)?),
+            Conversion::Unsigned | Conversion::Octal | Conversion::Hex => {
+                Argument::Unsigned(decode_unsigned(buffer)?)
+            }
+            Conversion::Pointer => Argument::Pointer(decode_unsigned(buffer)?),
+            Conversion::InternedString => {
+                let str_ptr = decode_unsigned(buffer)? as usize;
+                Argument::InternedString(elf_metadata.recover_interned_string(str_ptr)?)
+            }
+            Conversion::Float(_, size) => Argument::Float(decode_float(buffer, size)?),
+            Conversion::Bytes(_) => Argument::Bytes(decode_bytes(buffer)?),
+            Conversion::SignedArray => Argument::SignedArray(decode_array(buffer, decode_signed)?),
+            Conversion::UnsignedArray | Conversion::OctalArray | Conversion::HexArray => {
+                Argument::UnsignedArray(decode_array(buffer, decode_unsigned)?)
+            }
+            Conversion::Percent => return Ok(None),
+            Conversion::Enum(type_name) => {
+                let value = decode_signed(buffer)?;
+                let name = elf_metadata.enum_types.enumerator_name(type_name, value);
+                Argument::Enum {
+                    value,
+                    name: name.map(str::to_owned),
+                }
+            }
+        };
+        Ok(Some(argument))
+    }
+
+    /// Displays the argument as the conversion specifies.
+    fn format(self, argument: Option<&Argument>, out_str: &mut String) {
+        use std::fmt::Write;
+        let _ = match (self, argument) {
+            (Conversion::Octal, Some(Argument::Unsigned(value))) => write!(out_str, "{:o}", value),
+            (Conversion::Hex, Some(Argument::Unsigned(value))) => write!(out_str, "{:x}", value),
+            (
+                _,
+                Some(Argument::Enum {
+                    name: Some(name), ..
+                }),
+            ) => out_str.write_str(name),
+            (Conversion::Enum(type_name), Some(Argument::Enum { value, .. })) => {
+                write!(out_str, "{}({})", type_name, value)
+            }
+            (_, Some(Argument::Signed(value))) | (_, Some(Argument::Enum { value, .. })) => {
+                write!(out_str, "{}", value)
+            }
+            (_, Some(Argument::Unsigned(value))) => write!(out_str, "{}", value),
+            (_, Some(Argument::Pointer(value))) => write!(out_str, "0x{:x}", value),
+            (Conversion::Float(style, _), Some(Argument::Float(value))) => {
+                out_str.write_str(&format_float(style, *value))
+            }
+            (_, Some(Argument::Float(value))) => write!(out_str, "{}", value),
+            (Conversion::OctalArray, Some(Argument::UnsignedArray(values))) => {
+                format_list(values, out_str, |value, out| write!(out, "{:o}", value))
+            }
+            (Conversion::HexArray, Some(Argument::UnsignedArray(values))) => {
+                format_list(values, out_str, |value, out| write!(out, "{:x}", value))
+            }
+            (_, Some(Argument::UnsignedArray(values))) => {
+                format_list(values, out_str, |value, out| write!(out, "{}", value))
+            }
+            (_, Some(Argument::SignedArray(values))) => {
+                format_list(values, out_str, |value, out| write!(out, "{}", value))
+            }
+            (Conversion::Bytes(true), Some(Argument::Bytes(value))) => {
+                format_hexdump(value, out_str);
+                Ok(())
+            }
+            (_, Some(Argument::Bytes(value))) => {
+                for (index, byte) in value.iter().enumerate() {
+                    let separator = if index == 0 { "" } else { " " };
+                    let _ = write!(out_str, "{}{:02x}", separator, byte);
+                }
+                Ok(())
+            }
+            (_, Some(Argument::String(value))) | (_, Some(Argument::InternedString(value))) => {
+                out_str.write_str(value)
+            }
+            (_, None) => out_str.write_char('%'),
+        };
+    }
+}
+
+/// Reads the raw timestamp of a log, in ticks. Returns it along with the rest of the log.
+pub fn decode_timestamp(mut buffer: &[u8]) -> Result<(u64, &[u8]), Error> {
+    let ticks = decode_unsigned(&mut buffer)?;
+    Ok((ticks, buffer))
+}
+
+/// Reads the format ID of a log, skipping its timestamp without decoding anything else.
+pub fn decode_format_id(mut buffer: &[u8]) -> Result<usize, Error> {
+    decode_unsigned(&mut buffer)?;
+    Ok(decode_unsigned(&mut buffer)? as usize)
+}
+
+/// Reads the raw timestamp and the format ID of a log. Returns them along with the encoded
+/// arguments that follow, which are left undecoded.
+pub fn decode_header(buffer: &[u8]) -> Result<(u64, usize, &[u8]), Error> {
+    let (ticks, mut buffer) = decode_timestamp(buffer)?;
+    let format_id = decode_unsigned(&mut buffer)? as usize;
+    Ok((ticks, format_id, buffer))
+}
 
 /// Decodes Postform logs from the ElfMetadata and a buffer.
 pub struct Decoder<'a> {
@@ -320,16 +898,109 @@ impl<'a> Decoder<'a> {
         let str_ptr = decode_unsigned(&mut buffer)? as usize;
 
         let format_string = self.elf_metadata.recover_interned_string(str_ptr)?;
-        let (file_name, line_number, format_str) = self.decode_format_string(format_string)?;
-        let formatted_str = self.format_string(&format_str, buffer)?;
         let log_section = self.elf_metadata.get_log_section(str_ptr);
+        match log_section.level {
+            LogLevel::Trace => {
+                return Self::decode_trace_event(timestamp, str_ptr, format_string, buffer)
+            }
+            LogLevel::Metric => {
+                return Self::decode_metric_sample(timestamp, str_ptr, format_string, buffer)
+            }
+            _ => {}
+        }
+
+        let (file_name, line_number, format) = self.decode_format_string(format_string)?;
+        let (message, arguments) = self.format_arguments(&format, buffer)?;
 
         Ok(Log {
             timestamp,
             level: log_section.level,
-            message: formatted_str,
+            message,
             file_name,
             line_number,
+            format_id: str_ptr,
+            format,
+            arguments,
+        })
+    }
+
+    /// Decodes a trace event. Its interned string is the name of the span, and its only
+    /// argument the kind of event.
+    fn decode_trace_event(
+        timestamp: f64,
+        str_ptr: usize,
+        span: String,
+        mut buffer: &[u8],
+    ) -> Result<Log, Error> {
+        let event = decode_unsigned(&mut buffer)?;
+        let kind = match event {
+            0 => "begin",
+            1 => "end",
+            _ => return Err(Error::InvalidLogMessage),
+        };
+        Ok(Log {
+            timestamp,
+            level: LogLevel::Trace,
+            message: format!("{} {}", span, kind),
+            file_name: String::new(),
+            line_number: 0,
+            format_id: str_ptr,
+            format: span,
+            arguments: vec![Argument::Unsigned(event)],
+        })
+    }
+
+    /// Decodes a metric sample. Its interned string is the kind of metric, 'c' or 'g', and its
+    /// name separated by '@'. Its only argument is the value of the sample.
+    fn decode_metric_sample(
+        timestamp: f64,
+        str_ptr: usize,
+        metric: String,
+        mut buffer: &[u8],
+    ) -> Result<Log, Error> {
+        let (kind, name) = metric.split_at(metric.find('@').unwrap_or(0));
+        let name = name.get(1..).unwrap_or_default();
+        let (message, arguments) = match kind {
+            "c" => {
+                let delta = decode_unsigned(&mut buffer)?;
+                (
+                    format!("{} += {}", name, delta),
+                    vec![Argument::Unsigned(delta)],
+                )
+            }
+            "g" => {
+                let value = decode_signed(&mut buffer)?;
+                (
+                    format!("{} = {}", name, value),
+                    vec![Argument::Signed(value)],
+                )
+            }
+            "h" => {
+                // Bucket indices are sent as the distance to the previous non-empty bucket
+                let sub_bucket_bits = decode_unsigned(&mut buffer)?;
+                let mut arguments = vec![Argument::Unsigned(sub_bucket_bits)];
+                let mut index = 0;
+                while !buffer.is_empty() {
+                    index += decode_unsigned(&mut buffer)?;
+                    let count = decode_unsigned(&mut buffer)?;
+                    arguments.push(Argument::Unsigned(index));
+                    arguments.push(Argument::Unsigned(count));
+                }
+                let histogram =
+                    Histogram::from_arguments(&arguments).ok_or(Error::InvalidLogMessage)?;
+                (format!("{}: {}", name, histogram.summary()), arguments)
+            }
+            _ => return Err(Error::InvalidFormatString),
+        };
+        Ok(Log {
+            timestamp,
+            level: LogLevel::Metric,
+            message,
+            file_name: String::new(),
+            line_number: 0,
+            format_id: str_ptr,
+            format: metric,
+            arguments,
         })
     }
 
@@ -350,35 +1021,43 @@ impl<'a> Decoder<'a> {
         Ok((file_name, line_number, format))
     }
 
-    fn format_string(&self, format: &str, mut arguments: &[u8]) -> Result<String, Error> {
-        let mut format = String::from(format);
+    #[cfg(test)]
+    fn format_string(&self, format: &str, arguments: &[u8]) -> Result<String, Error> {
+        Ok(self.format_arguments(format, arguments)?.0)
+    }
+
+    /// Formats the message, returning it along with the typed values of its arguments.
+    fn format_arguments(
+        &self,
+        format: &str,
+        mut buffer: &[u8],
+    ) -> Result<(String, Vec<Argument>), Error> {
+        let mut format = format;
         let mut formatted_str = String::new();
+        let mut arguments = vec![];
         loop {
             let format_spec_pos = match format.find('%') {
                 Some(pos) => pos,
                 None => {
                     // Insert what's left of the format string and return;
-                    formatted_str.push_str(&format);
-                    return Ok(formatted_str);
+                    formatted_str.push_str(format);
+                    return Ok((formatted_str, arguments));
                 }
             };
 
             // Push characters until the %
-            format
-                .chars()
-                .take(format_spec_pos)
-                .for_each(|c| formatted_str.push(c));
+            formatted_str.push_str(&format[..format_spec_pos]);
             // Advance the format string
-            format = format.chars().skip(format_spec_pos).collect();
-
-            for (format_spec, handler) in &FORMAT_SPEC_TABLE {
-                if format.starts_with(format_spec) {
-                    handler(&self, &mut formatted_str, &mut arguments)?;
-                    // Advance the format string past the format specifier
-                    format = format.chars().skip(format_spec.len()).collect();
-                    break;
-                }
-            }
+            format = &format[format_spec_pos..];
+
+            let (format_spec_len, conversion) = parse_format_spec(format).ok_or_else(|| {
+                Error::InvalidFormatSpecifier(format[1..].chars().next().unwrap_or('%'))
+            })?;
+            let argument = conversion.decode(self.elf_metadata, &mut buffer)?;
+            conversion.format(argument.as_ref(), &mut formatted_str);
+            arguments.extend(argument);
+            // Advance the format string past the format specifier
+            format = &format[format_spec_len..];
         }
     }
 }
@@ -392,6 +1071,8 @@ mod tests {
             timestamp_freq: 1_000f64,
             strings: b"test/my_file.cpp@1234@This is my log message\0test/my_file2.cpp@12343@This is my second log message\0".into_iter().map(|c| c.clone()).collect(),
             log_sections: vec![],
+            counter_sites: vec![],
+            enum_types: EnumTypes::default(),
         }
     }
 
@@ -440,4 +1121,220 @@ mod tests {
         let log = decoder.format_string(format, args).unwrap();
         assert_eq!(log, "This is the log message And another string goes here");
     }
+
+    #[test]
+    fn test_format_arguments_are_typed() {
+        let elf_metadata = create_elf_metadata();
+        let decoder = Decoder::new(&elf_metadata);
+        let format = "%x %d%% %s %p %k";
+        let mut args = vec![];
+        leb128::write::unsigned(&mut args, 255).unwrap();
+        leb128::write::signed(&mut args, -3).unwrap();
+        args.extend_from_slice(b"str\0");
+        leb128::write::unsigned(&mut args, 0x1000).unwrap();
+        leb128::write::unsigned(&mut args, 45).unwrap();
+        let (message, arguments) = decoder.format_arguments(format, &args).unwrap();
+        assert_eq!(
+            message,
+            "ff -3% str 0x1000 test/my_file2.cpp@12343@This is my second log message"
+        );
+        assert_eq!(
+            arguments,
+            vec![
+                Argument::Unsigned(255),
+                Argument::Signed(-3),
+                Argument::String("str".to_owned()),
+                Argument::Pointer(0x1000),
+                Argument::InternedString(
+                    "test/my_file2.cpp@12343@This is my second log message".to_owned()
+                ),
+            ]
+        );
+    }
+
+    #[test]
+    fn test_format_string_view_argument() {
+        let elf_metadata = create_elf_metadata();
+        let decoder = Decoder::new(&elf_metadata);
+        let mut args = vec![5];
+        args.extend_from_slice(b"Hello");
+        args.push(0);
+        let (message, arguments) = decoder.format_arguments("%.*s%.*s!", &args).unwrap();
+        assert_eq!(message, "Hello!");
+        assert_eq!(
+            arguments,
+            vec![
+                Argument::String("Hello".to_owned()),
+                Argument::String(String::new())
+            ]
+        );
+
+        assert!(decoder.format_arguments("%.*s", &args[..5]).is_err());
+    }
+
+    #[test]
+    fn test_format_bytes_arguments() {
+        let elf_metadata = create_elf_metadata();
+        let decoder = Decoder::new(&elf_metadata);
+        let mut args = vec![4, 0xde, 0xad, 0xbe, 0xef, 18];
+        args.extend_from_slice(b"Hello, world!\x00\x01\x02\x7f\xff");
+        let (message, arguments) = decoder.format_arguments("%*b\n%*B", &args).unwrap();
+        assert_eq!(
+            message,
+            "de ad be ef\n\
+             00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 21 00 01 02  |Hello, world!...|\n\
+             00000010  7f ff                                             |..|"
+        );
+        assert_eq!(arguments[0], Argument::Bytes(vec![0xde, 0xad, 0xbe, 0xef]));
+        assert_eq!(format_hex(&[0xde, 0xad, 0x01]), "dead01");
+
+        assert!(decoder.format_arguments("%*b", &args[..4]).is_err());
+    }
+
+    #[test]
+    fn test_format_array_arguments() {
+        let elf_metadata = create_elf_metadata();
+        let decoder = Decoder::new(&elf_metadata);
+        let args = [3, 0x7f, 0xac, 0x02, 0x80, 0x7e, 2, 255, 1, 8, 0, 0];
+        let (message, arguments) = decoder.format_arguments("%*d %*x %*u", &args).unwrap();
+        assert_eq!(message, "[-1, 300, -256] [ff, 8] []");
+        assert_eq!(
+            arguments,
+            vec![
+                Argument::SignedArray(vec![-1, 300, -256]),
+                Argument::UnsignedArray(vec![255, 8]),
+                Argument::UnsignedArray(vec![]),
+            ]
+        );
+
+        assert!(decoder.format_arguments("%*u", &[200, 1, 2]).is_err());
+    }
+
+    #[test]
+    fn test_build_hash_is_fnv1a() {
+        let mut hasher = Fnv1a::new();
+        assert_eq!(hasher.0, 0xcbf29ce484222325);
+        hasher.write(b"a");
+        assert_eq!(hasher.0, 0xaf63dc4c8601ec8c);
+        hasher.write(b"bc");
+        assert_eq!(hasher.0, 0xe71fa2190541574b);
+    }
+
+    #[test]
+    fn test_format_enum_arguments() {
+        let mut elf_metadata = create_elf_metadata();
+        elf_metadata.enum_types = enums::tests::create_enum_types();
+        let decoder = Decoder::new(&elf_metadata);
+        let (message, arguments) = decoder
+            .format_arguments(
+                "link %{net::Link::State}, %{app::Mode} %d",
+                &[0x7f, 0x05, 0x01],
+            )
+            .unwrap();
+        assert_eq!(message, "link kError, app::Mode(5) 1");
+        assert_eq!(
+            arguments,
+            vec![
+                Argument::Enum {
+                    value: -1,
+                    name: Some("kError".to_owned())
+                },
+                Argument::Enum {
+                    value: 5,
+                    name: None
+                },
+                Argument::Signed(1),
+            ]
+        );
+
+        assert!(decoder.format_arguments("%{Mode", &[0x01]).is_err());
+    }
+
+    #[test]
+    fn test_format_float_arguments() {
+        let elf_metadata = create_elf_metadata();
+        let decoder = Decoder::new(&elf_metadata);
+        let format = "%f %le %g";
+        let mut args = vec![];
+        args.extend_from_slice(&1.5f32.to_le_bytes());
+        args.extend_from_slice(&(-12345.678f64).to_le_bytes());
+        args.extend_from_slice(&0.0001f32.to_le_bytes());
+        let (message, arguments) = decoder.format_arguments(format, &args).unwrap();
+        assert_eq!(message, "1.500000 -1.234568e+04 0.0001");
+        assert_eq!(arguments[0], Argument::Float(1.5));
+        assert_eq!(arguments[1], Argument::Float(-12345.678));
+
+        assert!(decoder.format_arguments("%lf", &args[..4]).is_err());
+
+        let general = |value| format_float(FloatStyle::General, value);
+        assert_eq!(general(100000.0), "100000");
+        assert_eq!(general(1000000.0), "1e+06");
+        assert_eq!(general(999999.5), "1e+06");
+        assert_eq!(general(0.00001234), "1.234e-05");
+        assert_eq!(general(0.0), "0");
+        assert_eq!(general(-2.5), "-2.5");
+        assert_eq!(format_float(FloatStyle::Exponent, 0.0), "0.000000e+00");
+        assert_eq!(format_float(FloatStyle::Fixed, f64::NAN), "nan");
+        assert_eq!(format_float(FloatStyle::Fixed, f64::NEG_INFINITY), "-inf");
+    }
+
+    #[test]
+    fn test_decode_trace_event() {
+        let mut elf_metadata = create_elf_metadata();
+        elf_metadata.strings.extend_from_slice(b"my_span\0");
+        elf_metadata.log_sections.push(LogSection {
+            level: LogLevel::Trace,
+            start: 99,
+            end: 107,
+        });
+        let mut decoder = Decoder::new(&elf_metadata);
+
+        // Timestamp 2000 ticks, span ID 99, end event
+        let log = decoder.decode(&[0xD0, 0x0F, 99, 1]).unwrap();
+        assert_eq!(log.level, LogLevel::Trace);
+        assert_eq!(log.timestamp, 2f64);
+        assert_eq!(log.format, "my_span");
+        assert_eq!(log.message, "my_span end");
+        assert_eq!(log.trace_event(), Some(TraceEvent::End));
+
+        assert!(decoder.decode(&[0, 99, 2]).is_err());
+    }
+
+    #[test]
+    fn test_decode_metric_sample() {
+        let mut elf_metadata = create_elf_metadata();
+        elf_metadata
+            .strings
+            .extend_from_slice(b"c@rx_bytes\0g@temperature\0h@latency\0");
+        elf_metadata.log_sections.push(LogSection {
+            level: LogLevel::Metric,
+            start: 99,
+            end: 134,
+        });
+        let mut decoder = Decoder::new(&elf_metadata);
+
+        let log = decoder.decode(&[0, 99, 0xAC, 0x02]).unwrap();
+        assert_eq!(log.message, "rx_bytes += 300");
+        assert_eq!(log.metric(), Some(("rx_bytes", MetricSample::Counter(300))));
+
+        let log = decoder.decode(&[0, 110, 0x7E]).unwrap();
+        assert_eq!(log.metric(), Some(("temperature", MetricSample::Gauge(-2))));
+        assert_eq!(log.trace_event(), None);
+
+        // Bucket 3 with 2 samples and bucket 47 with 1
+        let log = decoder.decode(&[0, 124, 3, 3, 2, 44, 1]).unwrap();
+        assert_eq!(
+            log.message,
+            "latency: count=3 p50<=3 p90<=255 p99<=255 max<=255"
+        );
+        match log.metric() {
+            Some(("latency", MetricSample::Histogram(histogram))) => {
+                assert_eq!(
+                    histogram.buckets().collect::<Vec<_>>(),
+                    vec![(3, 2), (255, 1)]
+                )
+            }
+            metric => panic!("Unexpected metric {:?}", metric),
+        }
+    }
 }
@@ -0,0 +1,218 @@
+//! Throughput regression harness of the logging pipeline.
+//!
+//! Runs the `format_load` load generator to write a log, decodes it with `postform_persist` and
+//! compares the throughput of both steps against a stored baseline. Rates and memory usage vary
+//! with the load of the machine, so `--fatal` can restrict the failures to the metrics that
+//! don't, like the bytes per record.
+
+use color_eyre::eyre::{eyre, Result};
+use postform_persist::throughput::{format_comparison, updated_baseline, Metric};
+use serde_json::{json, Value};
+use std::fs;
+use std::os::unix::process::ExitStatusExt;
+use std::path::{Path, PathBuf};
+use std::process::{Command, ExitStatus, Stdio};
+use std::time::{Duration, Instant};
+use structopt::StructOpt;
+
+/// Records written when neither the options nor the baseline specify it.
+const DEFAULT_RECORDS: u64 = 2_000_000;
+
+#[derive(Debug, StructOpt)]
+#[structopt(name = "postform_throughput")]
+struct Opts {
+    /// Path to the `format_load` load generator. Its ELF file is also used to decode the log.
+    #[structopt(long, parse(from_os_str))]
+    load: PathBuf,
+
+    /// Path to `postform_persist`. Defaults to the one next to this binary.
+    #[structopt(long, parse(from_os_str))]
+    persist: Option<PathBuf>,
+
+    /// JSON file with the expected value and the relative tolerance of every metric.
+    #[structopt(long, parse(from_os_str))]
+    baseline: PathBuf,
+
+    /// Number of records to write. Defaults to the one stored in the baseline.
+    #[structopt(long)]
+    records: Option<u64>,
+
+    /// Number of runs. The best throughput and the largest memory usage are kept.
+    #[structopt(long, default_value = "3")]
+    runs: u32,
+
+    /// Directory where the log is written.
+    #[structopt(long, parse(from_os_str))]
+    work_dir: Option<PathBuf>,
+
+    /// Write the measured metrics to the baseline instead of comparing them.
+    #[structopt(long)]
+    update: bool,
+
+    /// Only fail when this metric regresses. Can be given several times. Regressions of the
+    /// other metrics are reported as warnings. Defaults to failing on every metric.
+    #[structopt(long)]
+    fatal: Vec<String>,
+}
+
+/// Measurements of a single run.
+struct Run {
+    encode_time: Duration,
+    records: u64,
+    log_bytes: u64,
+    decode_time: Duration,
+    decode_peak_rss_kib: u64,
+}
+
+/// Runs a command to completion, returning how long it took and its peak resident set size in
+/// KiB.
+fn run_measured(command: &mut Command) -> Result<(Duration, u64, ExitStatus)> {
+    let start = Instant::now();
+    let child = command.spawn()?;
+    let mut status = 0;
+    let mut usage: libc::rusage = unsafe { std::mem::zeroed() };
+    // Waiting with wait4 gives the resource usage of this child alone
+    if unsafe { libc::wait4(child.id() as libc::pid_t, &mut status, 0, &mut usage) } < 0 {
+        return Err(std::io::Error::last_os_error().into());
+    }
+    Ok((
+        start.elapsed(),
+        usage.ru_maxrss as u64,
+        ExitStatus::from_raw(status),
+    ))
+}
+
+fn run_pipeline(load: &Path, persist: &Path, log_path: &Path, records: u64) -> Result<Run> {
+    // The FileLogger appends to an existing file
+    let _ = fs::remove_file(log_path);
+
+    let start = Instant::now();
+    let output = Command::new(load)
+        .arg(log_path)
+        .arg(records.to_string())
+        .stderr(Stdio::inherit())
+        .output()?;
+    let encode_time = start.elapsed();
+    if !output.status.success() {
+        return Err(eyre!("{} failed: {}", load.display(), output.status));
+    }
+    let records = String::from_utf8_lossy(&output.stdout).trim().parse()?;
+    let log_bytes = fs::metadata(log_path)?.len();
+
+    let (decode_time, decode_peak_rss_kib, status) = run_measured(
+        Command::new(persist)
+            .arg(load)
+            .arg(log_path)
+            .stdout(Stdio::null()),
+    )?;
+    if !status.success() {
+        return Err(eyre!("{} failed: {}", persist.display(), status));
+    }
+    fs::remove_file(log_path)?;
+
+    Ok(Run {
+        encode_time,
+        records,
+        log_bytes,
+        decode_time,
+        decode_peak_rss_kib,
+    })
+}
+
+fn main() -> Result<()> {
+    color_eyre::install()?;
+    let opts = Opts::from_args();
+
+    let baseline: Value = match fs::read_to_string(&opts.baseline) {
+        Ok(contents) => serde_json::from_str(&contents)?,
+        Err(_) if opts.update => json!({}),
+        Err(error) => return Err(error.into()),
+    };
+    let requested_records = opts
+        .records
+        .or_else(|| baseline["records"].as_u64())
+        .unwrap_or(DEFAULT_RECORDS);
+    let persist = match opts.persist {
+        Some(persist) => persist,
+        None => std::env::current_exe()?.with_file_name("postform_persist"),
+    };
+    let log_path = opts
+        .work_dir
+        .unwrap_or_else(std::env::temp_dir)
+        .join(format!("postform_throughput_{}.log", std::process::id()));
+
+    let mut runs = vec![];
+    for _ in 0..opts.runs.max(1) {
+        runs.push(run_pipeline(
+            &opts.load,
+            &persist,
+            &log_path,
+            requested_records,
+        )?);
+    }
+    // A few more records than requested may be written, the rates use the actual count
+    let records = runs[0].records as f64;
+    let encode_time = runs.iter().map(|run| run.encode_time).min().unwrap();
+    let decode_time = runs.iter().map(|run| run.decode_time).min().unwrap();
+    let decode_peak_rss_kib = runs
+        .iter()
+        .map(|run| run.decode_peak_rss_kib)
+        .max()
+        .unwrap();
+    let metrics = [
+        Metric {
+            name: "encode_records_per_s",
+            value: records / encode_time.as_secs_f64(),
+            higher_is_better: true,
+        },
+        Metric {
+            name: "bytes_per_record",
+            value: runs[0].log_bytes as f64 / records,
+            higher_is_better: false,
+        },
+        Metric {
+            name: "decode_records_per_s",
+            value: records / decode_time.as_secs_f64(),
+            higher_is_better: true,
+        },
+        Metric {
+            name: "decode_peak_rss_kib",
+            value: decode_peak_rss_kib as f64,
+            higher_is_better: false,
+        },
+    ];
+
+    if let Some(unknown) = opts
+        .fatal
+        .iter()
+        .find(|name| !metrics.iter().any(|metric| metric.name == name.as_str()))
+    {
+        return Err(eyre!("Unknown metric '{}'", unknown));
+    }
+
+    println!("{} records in {} runs", records, runs.len());
+    if opts.update {
+        let mut updated = updated_baseline(&metrics, &baseline);
+        updated["records"] = json!(requested_records);
+        fs::write(
+            &opts.baseline,
+            serde_json::to_string_pretty(&updated)? + "\n",
+        )?;
+        println!("Baseline written to {}", opts.baseline.display());
+        return Ok(());
+    }
+
+    let (report, regressed) = format_comparison(&metrics, &baseline);
+    print!("{}", report);
+    let fatal_metrics = &opts.fatal;
+    let (fatal, warnings): (Vec<&str>, Vec<&str>) = regressed.into_iter().partition(|name| {
+        fatal_metrics.is_empty() || fatal_metrics.iter().any(|fatal| fatal == name)
+    });
+    for name in warnings {
+        eprintln!("warning: {} regressed, ignored as it is not fatal", name);
+    }
+    if !fatal.is_empty() {
+        return Err(eyre!("The pipeline regressed: {}", fatal.join(", ")));
+    }
+    Ok(())
+}
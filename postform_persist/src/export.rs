@@ -0,0 +1,933 @@
+use postform_decoder::histogram::Histogram;
+use postform_decoder::{format_hex, Argument, Log, MetricSample, TraceEvent};
+use std::collections::BTreeMap;
+use std::io::{self, Write};
+use std::str::FromStr;
+
+/// Maximum number of arguments of a log, as limited by the Postform macros.
+const MAX_ARGUMENTS: usize = 14;
+
+/// Magic number at the start of a columnar export.
+pub const COLUMNAR_MAGIC: &[u8; 8] = b"PFCOL001";
+
+/// Structured formats logs can be exported to.
+#[derive(Copy, Clone, Debug, PartialEq)]
+pub enum ExportFormat {
+    /// One JSON object per log and line.
+    JsonLines,
+    /// One row per log, with a column per argument.
+    Csv,
+    /// Binary columns grouped by format ID, see `ColumnarExporter`.
+    Columnar,
+    /// Chrome `trace_event` JSON, with trace spans as duration events and logs as instant
+    /// events.
+    ChromeTrace,
+    /// Folded stacks of trace spans for flame graphs, see `FoldedStacksExporter`.
+    FoldedStacks,
+    /// Time series of the metrics, see `MetricsCsvExporter`.
+    MetricsCsv,
+    /// Prometheus text snapshot of the final value of the metrics.
+    Prometheus,
+}
+
+/// Error parsing an `ExportFormat`
+#[derive(Debug, thiserror::Error)]
+#[error(
+    "Invalid export format {0}, expected jsonl, csv, columnar, chrome-trace, folded, \
+     metrics-csv or prometheus"
+)]
+pub struct InvalidExportFormat(String);
+
+impl FromStr for ExportFormat {
+    type Err = InvalidExportFormat;
+
+    fn from_str(format: &str) -> Result<Self, Self::Err> {
+        match format {
+            "jsonl" => Ok(ExportFormat::JsonLines),
+            "csv" => Ok(ExportFormat::Csv),
+            "columnar" => Ok(ExportFormat::Columnar),
+            "chrome-trace" => Ok(ExportFormat::ChromeTrace),
+            "folded" => Ok(ExportFormat::FoldedStacks),
+            "metrics-csv" => Ok(ExportFormat::MetricsCsv),
+            "prometheus" => Ok(ExportFormat::Prometheus),
+            _ => Err(InvalidExportFormat(format.to_owned())),
+        }
+    }
+}
+
+/// Writes decoded logs in a structured format.
+pub trait Exporter {
+    fn export(&mut self, log: &Log) -> io::Result<()>;
+    /// Writes the logs exported so far to the output, while following a log. Formats that can
+    /// only be written once all logs are known write nothing until `finish`.
+    fn flush(&mut self) -> io::Result<()> {
+        Ok(())
+    }
+    /// Writes anything still buffered. Must be called once all logs are exported.
+    fn finish(&mut self) -> io::Result<()>;
+}
+
+/// Creates the exporter for the given format.
+pub fn create_exporter(format: ExportFormat, output: Box<dyn Write>) -> Box<dyn Exporter> {
+    match format {
+        ExportFormat::JsonLines => Box::new(JsonLinesExporter { output }),
+        ExportFormat::Csv => Box::new(CsvExporter {
+            output,
+            header_written: false,
+        }),
+        ExportFormat::Columnar => Box::new(ColumnarExporter {
+            output,
+            groups: BTreeMap::new(),
+        }),
+        ExportFormat::ChromeTrace => Box::new(ChromeTraceExporter { output, events: 0 }),
+        ExportFormat::FoldedStacks => Box::new(FoldedStacksExporter {
+            output,
+            stack: vec![],
+            stacks: BTreeMap::new(),
+        }),
+        ExportFormat::MetricsCsv => Box::new(MetricsCsvExporter {
+            output,
+            header_written: false,
+            metrics: BTreeMap::new(),
+        }),
+        ExportFormat::Prometheus => Box::new(PrometheusExporter {
+            output,
+            metrics: BTreeMap::new(),
+        }),
+    }
+}
+
+fn argument_type(argument: &Argument) -> &'static str {
+    match argument {
+        Argument::Signed(_) => "signed",
+        Argument::Unsigned(_) => "unsigned",
+        Argument::Pointer(_) => "pointer",
+        Argument::String(_) => "string",
+        Argument::InternedString(_) => "interned_string",
+        Argument::Float(_) => "float",
+        Argument::Bytes(_) => "bytes",
+        Argument::SignedArray(_) => "signed_array",
+        Argument::UnsignedArray(_) => "unsigned_array",
+        Argument::Enum { .. } => "enum",
+    }
+}
+
+fn argument_to_json(argument: &Argument) -> serde_json::Value {
+    let value = match argument {
+        Argument::Signed(value) => serde_json::json!(value),
+        Argument::Unsigned(value) | Argument::Pointer(value) => serde_json::json!(value),
+        Argument::String(value) | Argument::InternedString(value) => serde_json::json!(value),
+        Argument::Float(value) => serde_json::json!(value),
+        Argument::Bytes(value) => serde_json::json!(format_hex(value)),
+        Argument::SignedArray(values) => serde_json::json!(values),
+        Argument::UnsignedArray(values) => serde_json::json!(values),
+        Argument::Enum { value, name } => {
+            return serde_json::json!({ "type": argument_type(argument), "value": value, "name": name })
+        }
+    };
+    serde_json::json!({ "type": argument_type(argument), "value": value })
+}
+
+struct JsonLinesExporter {
+    output: Box<dyn Write>,
+}
+
+impl Exporter for JsonLinesExporter {
+    fn export(&mut self, log: &Log) -> io::Result<()> {
+        let object = serde_json::json!({
+            "timestamp": log.timestamp,
+            "level": log.level.to_string(),
+            "file": log.file_name,
+            "line": log.line_number,
+            "format_id": log.format_id,
+            "format": log.format,
+            "message": log.message,
+            "arguments": log.arguments.iter().map(argument_to_json).collect::<Vec<_>>(),
+        });
+        serde_json::to_writer(&mut self.output, &object)?;
+        self.output.write_all(b"\n")
+    }
+
+    fn flush(&mut self) -> io::Result<()> {
+        self.output.flush()
+    }
+
+    fn finish(&mut self) -> io::Result<()> {
+        self.output.flush()
+    }
+}
+
+struct CsvExporter {
+    output: Box<dyn Write>,
+    header_written: bool,
+}
+
+/// Quotes a CSV field if needed.
+fn csv_field(field: &str) -> String {
+    if field.contains(|c| c == ',' || c == '"' || c == '\n' || c == '\r') {
+        format!("\"{}\"", field.replace('"', "\"\""))
+    } else {
+        field.to_owned()
+    }
+}
+
+impl Exporter for CsvExporter {
+    fn export(&mut self, log: &Log) -> io::Result<()> {
+        if !self.header_written {
+            let mut header = String::from("timestamp,level,file,line,format_id,format,message");
+            for i in 0..MAX_ARGUMENTS {
+                header.push_str(&format!(",arg{}", i));
+            }
+            writeln!(self.output, "{}", header)?;
+            self.header_written = true;
+        }
+
+        write!(
+            self.output,
+            "{},{},{},{},{},{},{}",
+            log.timestamp,
+            log.level.to_string(),
+            csv_field(&log.file_name),
+            log.line_number,
+            log.format_id,
+            csv_field(&log.format),
+            csv_field(&log.message)
+        )?;
+        for i in 0..MAX_ARGUMENTS {
+            let field = match log.arguments.get(i) {
+                Some(Argument::Signed(value)) => value.to_string(),
+                Some(Argument::Unsigned(value)) | Some(Argument::Pointer(value)) => {
+                    value.to_string()
+                }
+                Some(Argument::String(value)) | Some(Argument::InternedString(value)) => {
+                    csv_field(value)
+                }
+                Some(Argument::Float(value)) => value.to_string(),
+                Some(Argument::Bytes(value)) => format_hex(value),
+                Some(Argument::SignedArray(values)) => csv_field(&format!("{:?}", values)),
+                Some(Argument::UnsignedArray(values)) => csv_field(&format!("{:?}", values)),
+                Some(Argument::Enum {
+                    name: Some(name), ..
+                }) => csv_field(name),
+                Some(Argument::Enum { value, .. }) => value.to_string(),
+                None => String::new(),
+            };
+            write!(self.output, ",{}", field)?;
+        }
+        writeln!(self.output)
+    }
+
+    fn flush(&mut self) -> io::Result<()> {
+        self.output.flush()
+    }
+
+    fn finish(&mut self) -> io::Result<()> {
+        self.output.flush()
+    }
+}
+
+/// Column of a columnar export.
+enum Column {
+    Signed(Vec<i64>),
+    Unsigned(Vec<u64>),
+    Pointer(Vec<u64>),
+    String(Vec<String>),
+    InternedString(Vec<String>),
+    Float(Vec<f64>),
+    Bytes(Vec<Vec<u8>>),
+    SignedArray(Vec<Vec<i64>>),
+    UnsignedArray(Vec<Vec<u64>>),
+    Enum(Vec<(i64, Option<String>)>),
+}
+
+impl Column {
+    fn new(argument: &Argument) -> Self {
+        match argument {
+            Argument::Signed(_) => Column::Signed(vec![]),
+            Argument::Unsigned(_) => Column::Unsigned(vec![]),
+            Argument::Pointer(_) => Column::Pointer(vec![]),
+            Argument::String(_) => Column::String(vec![]),
+            Argument::InternedString(_) => Column::InternedString(vec![]),
+            Argument::Float(_) => Column::Float(vec![]),
+            Argument::Bytes(_) => Column::Bytes(vec![]),
+            Argument::SignedArray(_) => Column::SignedArray(vec![]),
+            Argument::UnsignedArray(_) => Column::UnsignedArray(vec![]),
+            Argument::Enum { .. } => Column::Enum(vec![]),
+        }
+    }
+
+    /// Appends the argument, which must match the type of the column.
+    fn push(&mut self, argument: &Argument) {
+        match (self, argument) {
+            (Column::Signed(values), Argument::Signed(value)) => values.push(*value),
+            (Column::Unsigned(values), Argument::Unsigned(value)) => values.push(*value),
+            (Column::Pointer(values), Argument::Pointer(value)) => values.push(*value),
+            (Column::String(values), Argument::String(value)) => values.push(value.clone()),
+            (Column::InternedString(values), Argument::InternedString(value)) => {
+                values.push(value.clone())
+            }
+            (Column::Float(values), Argument::Float(value)) => values.push(*value),
+            (Column::Bytes(values), Argument::Bytes(value)) => values.push(value.clone()),
+            (Column::SignedArray(values), Argument::SignedArray(value)) => {
+                values.push(value.clone())
+            }
+            (Column::UnsignedArray(values), Argument::UnsignedArray(value)) => {
+                values.push(value.clone())
+            }
+            (Column::Enum(values), Argument::Enum { value, name }) => {
+                values.push((*value, name.clone()))
+            }
+            _ => unreachable!("Argument type does not match its column"),
+        }
+    }
+
+    fn write(&self, output: &mut dyn Write) -> io::Result<()> {
+        let write_strings = |output: &mut dyn Write, values: &[String]| -> io::Result<()> {
+            for value in values {
+                write_bytes(output, value.as_bytes())?;
+            }
+            Ok(())
+        };
+        match self {
+            Column::Signed(values) => {
+                output.write_all(&[0])?;
+                values
+                    .iter()
+                    .try_for_each(|value| output.write_all(&value.to_le_bytes()))
+            }
+            Column::Unsigned(values) => {
+                output.write_all(&[1])?;
+                values
+                    .iter()
+                    .try_for_each(|value| output.write_all(&value.to_le_bytes()))
+            }
+            Column::Pointer(values) => {
+                output.write_all(&[2])?;
+                values
+                    .iter()
+                    .try_for_each(|value| output.write_all(&value.to_le_bytes()))
+            }
+            Column::String(values) => {
+                output.write_all(&[3])?;
+                write_strings(output, values)
+            }
+            Column::InternedString(values) => {
+                output.write_all(&[4])?;
+                write_strings(output, values)
+            }
+            Column::Float(values) => {
+                output.write_all(&[5])?;
+                values
+                    .iter()
+                    .try_for_each(|value| output.write_all(&value.to_le_bytes()))
+            }
+            Column::Bytes(values) => {
+                output.write_all(&[6])?;
+                values
+                    .iter()
+                    .try_for_each(|value| write_bytes(output, value))
+            }
+            Column::SignedArray(values) => {
+                output.write_all(&[7])?;
+                values.iter().try_for_each(|value| {
+                    output.write_all(&(value.len() as u32).to_le_bytes())?;
+                    value
+                        .iter()
+                        .try_for_each(|element| output.write_all(&element.to_le_bytes()))
+                })
+            }
+            Column::UnsignedArray(values) => {
+                output.write_all(&[8])?;
+                values.iter().try_for_each(|value| {
+                    output.write_all(&(value.len() as u32).to_le_bytes())?;
+                    value
+                        .iter()
+                        .try_for_each(|element| output.write_all(&element.to_le_bytes()))
+                })
+            }
+            Column::Enum(values) => {
+                output.write_all(&[9])?;
+                values.iter().try_for_each(|(value, name)| {
+                    output.write_all(&value.to_le_bytes())?;
+                    write_bytes(output, name.as_deref().unwrap_or_default().as_bytes())
+                })
+            }
+        }
+    }
+}
+
+/// Writes a byte string preceded by its length as a little endian u32.
+fn write_bytes(output: &mut dyn Write, bytes: &[u8]) -> io::Result<()> {
+    output.write_all(&(bytes.len() as u32).to_le_bytes())?;
+    output.write_all(bytes)
+}
+
+/// All the logs of a single format ID.
+struct ColumnGroup {
+    file_name: String,
+    line_number: u32,
+    format: String,
+    timestamps: Vec<f64>,
+    columns: Vec<Column>,
+}
+
+/// Exports logs as typed columns, grouped by format ID.
+///
+/// All values are little endian. The file starts with `COLUMNAR_MAGIC` and the number of groups
+/// as a u32. Each group is made of:
+///
+/// * format ID (u64), number of rows (u64) and number of argument columns (u32).
+/// * file name, line number (u32) and format string. Strings are stored as their length (u32)
+///   followed by their UTF-8 bytes.
+/// * The timestamp column, as f64 seconds.
+/// * Every argument column: a type tag (u8) followed by all its values. Tags are 0 for signed
+///   (i64), 1 for unsigned (u64), 2 for pointers (u64), 3 for strings, 4 for interned
+///   strings, 5 for floats (f64) and 6 for binary buffers, stored as strings are. Tags 7 and 8
+///   are arrays of signed (i64) and unsigned (u64) integers, stored as their number of
+///   elements (u32) followed by the elements. Tag 9 is for enums, stored as their value (i64)
+///   followed by the name of their enumerator as a string, empty if it is not known.
+///
+/// Groups are kept in memory until `finish` is called.
+pub struct ColumnarExporter {
+    output: Box<dyn Write>,
+    groups: BTreeMap<usize, ColumnGroup>,
+}
+
+impl Exporter for ColumnarExporter {
+    fn export(&mut self, log: &Log) -> io::Result<()> {
+        let group = self
+            .groups
+            .entry(log.format_id)
+            .or_insert_with(|| ColumnGroup {
+                file_name: log.file_name.clone(),
+                line_number: log.line_number,
+                format: log.format.clone(),
+                timestamps: vec![],
+                columns: log.arguments.iter().map(Column::new).collect(),
+            });
+
+        let matches_columns = group.columns.len() == log.arguments.len()
+            && group
+                .columns
+                .iter()
+                .zip(&log.arguments)
+                .all(|(column, argument)| {
+                    std::mem::discriminant(column) == std::mem::discriminant(&Column::new(argument))
+                });
+        if !matches_columns {
+            return Err(io::Error::new(
+                io::ErrorKind::InvalidData,
+                format!("Arguments of format ID {} changed type", log.format_id),
+            ));
+        }
+
+        group.timestamps.push(log.timestamp);
+        for (column, argument) in group.columns.iter_mut().zip(&log.arguments) {
+            column.push(argument);
+        }
+        Ok(())
+    }
+
+    fn finish(&mut self) -> io::Result<()> {
+        let output = &mut self.output;
+        output.write_all(COLUMNAR_MAGIC)?;
+        output.write_all(&(self.groups.len() as u32).to_le_bytes())?;
+        for (format_id, group) in &self.groups {
+            output.write_all(&(*format_id as u64).to_le_bytes())?;
+            output.write_all(&(group.timestamps.len() as u64).to_le_bytes())?;
+            output.write_all(&(group.columns.len() as u32).to_le_bytes())?;
+            write_bytes(output.as_mut(), group.file_name.as_bytes())?;
+            output.write_all(&group.line_number.to_le_bytes())?;
+            write_bytes(output.as_mut(), group.format.as_bytes())?;
+            for timestamp in &group.timestamps {
+                output.write_all(&timestamp.to_le_bytes())?;
+            }
+            for column in &group.columns {
+                column.write(output.as_mut())?;
+            }
+        }
+        self.groups.clear();
+        output.flush()
+    }
+}
+
+/// Exports logs as a Chrome `trace_event` JSON array, which can be opened with `chrome://tracing`
+/// or Perfetto.
+///
+/// Trace events become begin (`B`) and end (`E`) events, while regular logs become instant
+/// events with their level, file and line as arguments. Timestamps are in microseconds.
+struct ChromeTraceExporter {
+    output: Box<dyn Write>,
+    events: u64,
+}
+
+impl Exporter for ChromeTraceExporter {
+    fn export(&mut self, log: &Log) -> io::Result<()> {
+        let timestamp = log.timestamp * 1_000_000f64;
+        let event = match log.trace_event() {
+            Some(event) => serde_json::json!({
+                "name": log.format,
+                "ph": if event == TraceEvent::Begin { "B" } else { "E" },
+                "ts": timestamp,
+                "pid": 0,
+                "tid": 0,
+            }),
+            None => serde_json::json!({
+                "name": log.message,
+                "ph": "i",
+                "s": "t",
+                "ts": timestamp,
+                "pid": 0,
+                "tid": 0,
+                "args": {
+                    "level": log.level.to_string(),
+                    "file": log.file_name,
+                    "line": log.line_number,
+                },
+            }),
+        };
+        self.output
+            .write_all(if self.events == 0 { b"[\n" } else { b",\n" })?;
+        serde_json::to_writer(&mut self.output, &event)?;
+        self.events += 1;
+        Ok(())
+    }
+
+    /// The array is left open until `finish`, which the trace viewers accept, so a followed
+    /// export can be opened at any time.
+    fn flush(&mut self) -> io::Result<()> {
+        self.output.flush()
+    }
+
+    fn finish(&mut self) -> io::Result<()> {
+        if self.events == 0 {
+            self.output.write_all(b"[")?;
+        }
+        self.output.write_all(b"\n]\n")?;
+        self.output.flush()
+    }
+}
+
+/// Span that began and has not ended yet.
+struct OpenSpan {
+    name: String,
+    start: f64,
+    /// Time spent in the spans nested in this one.
+    children: f64,
+}
+
+/// Exports trace spans as folded stacks, the input of flame graph tools such as `flamegraph.pl`
+/// or `inferno`.
+///
+/// Each line holds a stack of nested spans separated by `;`, followed by the time spent in the
+/// innermost span itself, excluding its children, in microseconds. Spans must be properly nested.
+/// When a span ends, any span nested in it that is still open ends with it. Regular logs are
+/// ignored.
+struct FoldedStacksExporter {
+    output: Box<dyn Write>,
+    stack: Vec<OpenSpan>,
+    stacks: BTreeMap<String, f64>,
+}
+
+impl Exporter for FoldedStacksExporter {
+    fn export(&mut self, log: &Log) -> io::Result<()> {
+        match log.trace_event() {
+            Some(TraceEvent::Begin) => self.stack.push(OpenSpan {
+                name: log.format.clone(),
+                start: log.timestamp,
+                children: 0f64,
+            }),
+            Some(TraceEvent::End) => {
+                let position = match self.stack.iter().rposition(|span| span.name == log.format) {
+                    Some(position) => position,
+                    // The span began before the start of the log
+                    None => return Ok(()),
+                };
+                while self.stack.len() > position {
+                    let path: Vec<_> = self.stack.iter().map(|span| span.name.as_str()).collect();
+                    let path = path.join(";");
+                    let span = self.stack.pop().unwrap();
+                    let duration = log.timestamp - span.start;
+                    *self.stacks.entry(path).or_default() += duration - span.children;
+                    if let Some(parent) = self.stack.last_mut() {
+                        parent.children += duration;
+                    }
+                }
+            }
+            None => {}
+        }
+        Ok(())
+    }
+
+    fn finish(&mut self) -> io::Result<()> {
+        for (path, time) in &self.stacks {
+            let micros = (time * 1_000_000f64).round() as u64;
+            if micros > 0 {
+                writeln!(self.output, "{} {}", path, micros)?;
+            }
+        }
+        self.stacks.clear();
+        self.output.flush()
+    }
+}
+
+/// Kind of a metric. Metrics of different kinds may share a name, so they are identified by
+/// both.
+#[derive(Clone, Copy, Debug, PartialEq, Eq, PartialOrd, Ord)]
+enum MetricKind {
+    Counter,
+    Gauge,
+    Histogram,
+}
+
+impl MetricKind {
+    fn of(sample: &MetricSample) -> Self {
+        match sample {
+            MetricSample::Counter(_) => MetricKind::Counter,
+            MetricSample::Gauge(_) => MetricKind::Gauge,
+            MetricSample::Histogram(_) => MetricKind::Histogram,
+        }
+    }
+}
+
+/// Aggregated state of a metric.
+#[derive(Default)]
+struct MetricState {
+    /// Sum of the increments of a counter, last value of a gauge or number of samples of a
+    /// histogram.
+    value: i128,
+    /// Timestamp of the last sample.
+    timestamp: f64,
+    samples: u64,
+    /// Buckets of a histogram, merged across all its records.
+    histogram: Option<Histogram>,
+}
+
+impl MetricState {
+    /// Adds the sample of the log to the metric, returning the rate of a counter or of the
+    /// samples of a histogram since its previous record, in units per second.
+    fn update(&mut self, log: &Log, sample: &MetricSample) -> Option<f64> {
+        let first = self.samples == 0;
+        let elapsed = log.timestamp - self.timestamp;
+        self.timestamp = log.timestamp;
+        self.samples += 1;
+        let delta = match sample {
+            MetricSample::Counter(delta) => *delta,
+            MetricSample::Gauge(value) => {
+                self.value = *value as i128;
+                return None;
+            }
+            MetricSample::Histogram(histogram) => {
+                match &mut self.histogram {
+                    Some(merged) => merged.merge(histogram),
+                    None => self.histogram = Some(histogram.clone()),
+                }
+                histogram.count()
+            }
+        };
+        self.value += delta as i128;
+        if first || elapsed <= 0f64 {
+            None
+        } else {
+            Some(delta as f64 / elapsed)
+        }
+    }
+}
+
+/// Exports the time series of all metrics as CSV, one row per sample. Regular logs are ignored.
+///
+/// Rows hold the timestamp, name and type of the metric and the value of the sample. Counters
+/// also hold their running total and their rate since the previous sample, per second. For
+/// histograms, the value is the number of samples of the record.
+struct MetricsCsvExporter {
+    output: Box<dyn Write>,
+    header_written: bool,
+    metrics: BTreeMap<(String, MetricKind), MetricState>,
+}
+
+impl Exporter for MetricsCsvExporter {
+    fn export(&mut self, log: &Log) -> io::Result<()> {
+        let (name, sample) = match log.metric() {
+            Some(metric) => metric,
+            None => return Ok(()),
+        };
+        if !self.header_written {
+            writeln!(self.output, "timestamp,metric,type,value,total,rate")?;
+            self.header_written = true;
+        }
+
+        let metric = self
+            .metrics
+            .entry((name.to_owned(), MetricKind::of(&sample)))
+            .or_default();
+        let rate = metric.update(log, &sample);
+        let rate = rate.map(|rate| rate.to_string()).unwrap_or_default();
+        match sample {
+            MetricSample::Counter(delta) => writeln!(
+                self.output,
+                "{},{},counter,{},{},{}",
+                log.timestamp,
+                csv_field(name),
+                delta,
+                metric.value,
+                rate
+            ),
+            MetricSample::Gauge(value) => writeln!(
+                self.output,
+                "{},{},gauge,{},,",
+                log.timestamp,
+                csv_field(name),
+                value
+            ),
+            MetricSample::Histogram(histogram) => writeln!(
+                self.output,
+                "{},{},histogram,{},{},{}",
+                log.timestamp,
+                csv_field(name),
+                histogram.count(),
+                metric.value,
+                rate
+            ),
+        }
+    }
+
+    fn flush(&mut self) -> io::Result<()> {
+        self.output.flush()
+    }
+
+    fn finish(&mut self) -> io::Result<()> {
+        self.output.flush()
+    }
+}
+
+/// Exports the final value of all metrics in the Prometheus text exposition format. Counters
+/// are exported as `<name>_total`, and histograms with a bucket per non-empty bucket of the
+/// device histogram. Characters not allowed in Prometheus names become `_`.
+struct PrometheusExporter {
+    output: Box<dyn Write>,
+    metrics: BTreeMap<(String, MetricKind), MetricState>,
+}
+
+fn prometheus_name(name: &str) -> String {
+    let mut sanitized: String = name
+        .chars()
+        .map(|c| {
+            if c.is_ascii_alphanumeric() || c == '_' || c == ':' {
+                c
+            } else {
+                '_'
+            }
+        })
+        .collect();
+    if sanitized.starts_with(|c: char| c.is_ascii_digit()) || sanitized.is_empty() {
+        sanitized.insert(0, '_');
+    }
+    sanitized
+}
+
+impl Exporter for PrometheusExporter {
+    fn export(&mut self, log: &Log) -> io::Result<()> {
+        if let Some((name, sample)) = log.metric() {
+            let metric = self
+                .metrics
+                .entry((name.to_owned(), MetricKind::of(&sample)))
+                .or_default();
+            metric.update(log, &sample);
+        }
+        Ok(())
+    }
+
+    fn finish(&mut self) -> io::Result<()> {
+        for ((name, kind), metric) in &self.metrics {
+            let name = prometheus_name(name);
+            match (kind, &metric.histogram) {
+                (MetricKind::Histogram, Some(histogram)) => {
+                    writeln!(self.output, "# TYPE {} histogram", name)?;
+                    let mut cumulative = 0;
+                    for (upper, count) in histogram.buckets() {
+                        cumulative += count;
+                        writeln!(
+                            self.output,
+                            "{}_bucket{{le=\"{}\"}} {}",
+                            name, upper, cumulative
+                        )?;
+                    }
+                    writeln!(self.output, "{}_bucket{{le=\"+Inf\"}} {}", name, cumulative)?;
+                    writeln!(self.output, "{}_count {}", name, cumulative)?;
+                }
+                (MetricKind::Counter, _) => {
+                    writeln!(self.output, "# TYPE {}_total counter", name)?;
+                    writeln!(self.output, "{}_total {}", name, metric.value)?;
+                }
+                _ => {
+                    writeln!(self.output, "# TYPE {} gauge", name)?;
+                    writeln!(self.output, "{} {}", name, metric.value)?;
+                }
+            }
+        }
+        self.metrics.clear();
+        self.output.flush()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use postform_decoder::LogLevel;
+    use std::cell::RefCell;
+    use std::rc::Rc;
+
+    /// Output shared with the test after the exporter takes ownership of it.
+    #[derive(Clone, Default)]
+    struct SharedOutput(Rc<RefCell<Vec<u8>>>);
+
+    impl Write for SharedOutput {
+        fn write(&mut self, data: &[u8]) -> io::Result<usize> {
+            self.0.borrow_mut().write(data)
+        }
+
+        fn flush(&mut self) -> io::Result<()> {
+            Ok(())
+        }
+    }
+
+    fn trace(timestamp: f64, span: &str, event: u64) -> Log {
+        Log {
+            timestamp,
+            level: LogLevel::Trace,
+            message: String::new(),
+            file_name: String::new(),
+            line_number: 0,
+            format_id: 0,
+            format: span.to_owned(),
+            arguments: vec![Argument::Unsigned(event)],
+        }
+    }
+
+    fn metric(timestamp: f64, metric: &str, arguments: &[Argument]) -> Log {
+        Log {
+            level: LogLevel::Metric,
+            arguments: arguments.to_vec(),
+            ..trace(timestamp, metric, 0)
+        }
+    }
+
+    fn export(format: ExportFormat, logs: &[Log]) -> String {
+        let output = SharedOutput::default();
+        let mut exporter = create_exporter(format, Box::new(output.clone()));
+        for log in logs {
+            exporter.export(log).unwrap();
+        }
+        exporter.finish().unwrap();
+        let data = output.0.borrow().clone();
+        String::from_utf8(data).unwrap()
+    }
+
+    #[test]
+    fn test_flush_writes_streamed_formats() {
+        let log = metric(1.0, "c@rx_bytes", &[Argument::Unsigned(3)]);
+        for format in &[
+            ExportFormat::JsonLines,
+            ExportFormat::Csv,
+            ExportFormat::ChromeTrace,
+            ExportFormat::MetricsCsv,
+        ] {
+            let output = SharedOutput::default();
+            let mut exporter =
+                create_exporter(*format, Box::new(io::BufWriter::new(output.clone())));
+            exporter.export(&log).unwrap();
+            assert!(output.0.borrow().is_empty());
+            exporter.flush().unwrap();
+            assert!(!output.0.borrow().is_empty(), "{:?}", format);
+        }
+    }
+
+    #[test]
+    fn test_folded_stacks() {
+        let logs = [
+            trace(1.0, "main", 0),
+            trace(1.5, "parse", 0),
+            trace(2.0, "parse", 1),
+            trace(2.5, "parse", 0),
+            trace(3.0, "parse", 1),
+            trace(4.0, "main", 1),
+            // Unbalanced end of a span that began before the log
+            trace(5.0, "irq", 1),
+        ];
+        assert_eq!(
+            export(ExportFormat::FoldedStacks, &logs),
+            "main 2000000\nmain;parse 1000000\n"
+        );
+    }
+
+    #[test]
+    fn test_chrome_trace() {
+        let logs = [trace(0.5, "main", 0), trace(1.0, "main", 1)];
+        let json: serde_json::Value =
+            serde_json::from_str(&export(ExportFormat::ChromeTrace, &logs)).unwrap();
+        assert_eq!(json[0]["ph"], "B");
+        assert_eq!(json[0]["ts"], 500000.0);
+        assert_eq!(json[1]["ph"], "E");
+        assert_eq!(json[1]["name"], "main");
+
+        let json: serde_json::Value =
+            serde_json::from_str(&export(ExportFormat::ChromeTrace, &[])).unwrap();
+        assert_eq!(json, serde_json::json!([]));
+    }
+
+    #[test]
+    fn test_metrics() {
+        let logs = [
+            metric(1.0, "c@rx bytes", &[Argument::Unsigned(100)]),
+            metric(1.5, "g@temperature", &[Argument::Signed(-2)]),
+            metric(3.0, "c@rx bytes", &[Argument::Unsigned(50)]),
+            metric(4.0, "g@temperature", &[Argument::Signed(21)]),
+            // Sub-bucket bits, then bucket 3 with 2 samples and bucket 47 with 1
+            metric(4.0, "h@latency", &[3, 3, 2, 47, 1].map(Argument::Unsigned)),
+        ];
+        assert_eq!(
+            export(ExportFormat::MetricsCsv, &logs),
+            "timestamp,metric,type,value,total,rate\n\
+             1,rx bytes,counter,100,100,\n\
+             1.5,temperature,gauge,-2,,\n\
+             3,rx bytes,counter,50,150,25\n\
+             4,temperature,gauge,21,,\n\
+             4,latency,histogram,3,3,\n"
+        );
+        assert_eq!(
+            export(ExportFormat::Prometheus, &logs),
+            "# TYPE latency histogram\n\
+             latency_bucket{le=\"3\"} 2\n\
+             latency_bucket{le=\"255\"} 3\n\
+             latency_bucket{le=\"+Inf\"} 3\n\
+             latency_count 3\n\
+             # TYPE rx_bytes_total counter\n\
+             rx_bytes_total 150\n\
+             # TYPE temperature gauge\n\
+             temperature 21\n"
+        );
+    }
+
+    #[test]
+    fn test_counter_and_gauge_sharing_a_name() {
+        let logs = [
+            metric(1.0, "c@queue", &[Argument::Unsigned(10)]),
+            metric(2.0, "g@queue", &[Argument::Signed(3)]),
+            metric(3.0, "c@queue", &[Argument::Unsigned(5)]),
+        ];
+        assert_eq!(
+            export(ExportFormat::MetricsCsv, &logs),
+            "timestamp,metric,type,value,total,rate\n\
+             1,queue,counter,10,10,\n\
+             2,queue,gauge,3,,\n\
+             3,queue,counter,5,15,2.5\n"
+        );
+        assert_eq!(
+            export(ExportFormat::Prometheus, &logs),
+            "# TYPE queue_total counter\n\
+             queue_total 15\n\
+             # TYPE queue gauge\n\
+             queue 3\n"
+        );
+    }
+}
@@ -0,0 +1,146 @@
+use crate::{for_each_record, Framing};
+use std::fs::File;
+use std::io::{self, Read, Seek, SeekFrom};
+use std::ops::ControlFlow;
+use std::os::unix::ffi::OsStrExt;
+use std::os::unix::io::RawFd;
+use std::path::Path;
+use std::time::Duration;
+
+/// Sleep between polls of the file size when inotify is not available.
+const POLL_INTERVAL: Duration = Duration::from_millis(1);
+/// Maximum time to wait for an inotify event before checking the file anyway.
+const INOTIFY_TIMEOUT_MS: libc::c_int = 100;
+
+/// Waits for data to be appended to a file.
+///
+/// Uses inotify when available, which wakes up as soon as the writer commits a record.
+/// Otherwise it falls back to polling the file.
+pub struct FileWatcher {
+    inotify_fd: Option<RawFd>,
+}
+
+impl FileWatcher {
+    pub fn new(path: &Path) -> Self {
+        Self {
+            inotify_fd: Self::watch(path),
+        }
+    }
+
+    fn watch(path: &Path) -> Option<RawFd> {
+        let c_path = std::ffi::CString::new(path.as_os_str().as_bytes()).ok()?;
+        let fd = unsafe { libc::inotify_init1(libc::IN_CLOEXEC | libc::IN_NONBLOCK) };
+        if fd < 0 {
+            return None;
+        }
+        let mask = libc::IN_MODIFY | libc::IN_ATTRIB;
+        if unsafe { libc::inotify_add_watch(fd, c_path.as_ptr(), mask) } < 0 {
+            unsafe { libc::close(fd) };
+            return None;
+        }
+        Some(fd)
+    }
+
+    /// Blocks until the file might have changed.
+    pub fn wait(&self) {
+        let fd = match self.inotify_fd {
+            Some(fd) => fd,
+            None => return std::thread::sleep(POLL_INTERVAL),
+        };
+
+        let mut poll_fd = libc::pollfd {
+            fd,
+            events: libc::POLLIN,
+            revents: 0,
+        };
+        if unsafe { libc::poll(&mut poll_fd, 1, INOTIFY_TIMEOUT_MS) } > 0 {
+            // Drain the pending events, the file is read as a whole afterwards anyway.
+            let mut events = [0u8; 4096];
+            while unsafe { libc::read(fd, events.as_mut_ptr() as *mut _, events.len()) } > 0 {}
+        }
+    }
+}
+
+impl Drop for FileWatcher {
+    fn drop(&mut self) {
+        if let Some(fd) = self.inotify_fd {
+            unsafe { libc::close(fd) };
+        }
+    }
+}
+
+/// Decodes the records of a log file as they are appended to it.
+///
+/// `after_batch` runs after the records read at once are handled, before waiting for more, so
+/// that buffered consumers can flush their output. Following stops when it breaks or fails, and
+/// on errors reading the file.
+///
+/// A trailing record that is only partially written is kept until the rest of it arrives. If the
+/// file is truncated, decoding starts again from its beginning.
+pub fn follow_file(
+    path: &Path,
+    framing: Framing,
+    mut handler: impl FnMut(&[u8]),
+    mut after_batch: impl FnMut() -> io::Result<ControlFlow<()>>,
+) -> io::Result<()> {
+    let watcher = FileWatcher::new(path);
+    let mut file = File::open(path)?;
+    let mut position = 0u64;
+    let mut pending = vec![];
+
+    loop {
+        if file.metadata()?.len() < position {
+            file.seek(SeekFrom::Start(0))?;
+            position = 0;
+            pending.clear();
+        }
+
+        let count = file.read_to_end(&mut pending)?;
+        position += count as u64;
+        if count > 0 {
+            let consumed = for_each_record(&pending, framing, &mut handler);
+            pending.drain(..consumed);
+            if after_batch()?.is_break() {
+                return Ok(());
+            }
+        }
+        watcher.wait();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::fs;
+
+    #[test]
+    fn test_follow_stops_after_batch() {
+        let path = std::env::temp_dir().join(format!("postform_follow_{}.log", std::process::id()));
+        // Two records and the first byte of the size of a third one
+        fs::write(&path, [1, 0, 0, 0, 0xAA, 2, 0, 0, 0, 0xBB, 0xCC, 3]).unwrap();
+
+        let mut records = vec![];
+        let mut batches = 0;
+        let result = follow_file(
+            &path,
+            Framing::LengthPrefixed,
+            |record| records.push(record.to_vec()),
+            || {
+                batches += 1;
+                Ok(ControlFlow::Break(()))
+            },
+        );
+        assert!(result.is_ok());
+        assert_eq!(batches, 1);
+        assert_eq!(records, vec![vec![0xAA], vec![0xBB, 0xCC]]);
+
+        let error = follow_file(
+            &path,
+            Framing::LengthPrefixed,
+            |_| {},
+            || Err(io::Error::new(io::ErrorKind::Other, "full")),
+        );
+        assert_eq!(error.unwrap_err().to_string(), "full");
+        fs::remove_file(&path).unwrap();
+    }
+}
@@ -1,9 +1,211 @@
-use postform_decoder::{Decoder, ElfMetadata, LogLevel};
+use cobs::CobsDecoder;
+use postform_decoder::{Decoder, ElfMetadata, Log, LogLevel};
+use std::convert::TryInto;
+use std::fs;
+use std::io::{self, Read};
+use std::net::SocketAddr;
+use std::os::unix::fs::FileTypeExt;
+use std::os::unix::net::UnixListener;
+use std::path::{Path, PathBuf};
+use std::str::FromStr;
+use std::time::{Duration, Instant};
 use termion::color;
 
+pub mod export;
+pub mod follow;
+pub mod merge;
+pub mod stats;
+pub mod throughput;
+
+/// Size of a single read from a live stream.
+const STREAM_READ_SIZE: usize = 64 * 1024;
+
+/// Framing of the records contained in a log file.
+#[derive(Copy, Clone, Debug)]
+pub enum Framing {
+    /// Each record is preceded by its size as a little endian u32, as written by the
+    /// `FileLogger`.
+    LengthPrefixed,
+    /// Records are COBS encoded and delimited by a zero byte, as captured from RTT by
+    /// `postform_rtt --capture`.
+    Cobs,
+}
+
+/// Splits the log data into records and calls the handler with each of them.
+///
+/// A truncated trailing record is ignored. Returns the number of bytes consumed.
+pub fn for_each_record(data: &[u8], framing: Framing, handler: impl FnMut(&[u8])) -> usize {
+    match framing {
+        Framing::LengthPrefixed => for_each_length_prefixed_record(data, handler),
+        Framing::Cobs => for_each_cobs_record(data, handler),
+    }
+}
+
+/// Returns the length of the longest prefix of `data` made only of complete records.
+pub fn complete_records_len(data: &[u8], framing: Framing) -> usize {
+    match framing {
+        Framing::LengthPrefixed => for_each_length_prefixed_record(data, |_| {}),
+        Framing::Cobs => data.iter().rposition(|&c| c == 0).map_or(0, |pos| pos + 1),
+    }
+}
+
+fn for_each_length_prefixed_record(data: &[u8], mut handler: impl FnMut(&[u8])) -> usize {
+    const SIZE_LEN: usize = std::mem::size_of::<u32>();
+    let mut consumed = 0;
+    while data.len() - consumed >= SIZE_LEN {
+        let rest = &data[consumed..];
+        let size = u32::from_le_bytes(rest[..SIZE_LEN].try_into().unwrap()) as usize;
+        if rest.len() - SIZE_LEN < size {
+            break;
+        }
+        handler(&rest[SIZE_LEN..SIZE_LEN + size]);
+        consumed += SIZE_LEN + size;
+    }
+    consumed
+}
+
+fn for_each_cobs_record(data: &[u8], mut handler: impl FnMut(&[u8])) -> usize {
+    let mut consumed = 0;
+    let mut dec_buf = vec![];
+    for frame in data.split_inclusive(|&c| c == 0) {
+        if frame.last() != Some(&0) {
+            break;
+        }
+        consumed += frame.len();
+        dec_buf.resize(frame.len(), 0);
+        let mut decoder = CobsDecoder::new(&mut dec_buf[..]);
+        let mut result = Ok(None);
+        for data_byte in frame {
+            result = decoder.feed(*data_byte);
+            if result != Ok(None) {
+                break;
+            }
+        }
+        drop(decoder);
+        match result {
+            Ok(Some(msg_len)) => handler(&dec_buf[..msg_len]),
+            Ok(None) => {}
+            Err(decoded_len) => println!("Cobs decoding failed after {} bytes", decoded_len),
+        }
+    }
+    consumed
+}
+
+/// Address a live receiver listens on for a `SocketLogger` to connect.
+#[derive(Clone, Debug)]
+pub enum ListenAddress {
+    /// Unix-domain socket at the given path, written as `unix:<path>`.
+    Unix(PathBuf),
+    /// TCP socket, written as `tcp:<ip>:<port>`.
+    Tcp(SocketAddr),
+}
+
+/// Error parsing a `ListenAddress`
+#[derive(Debug, thiserror::Error)]
+#[error("Invalid address {0}, expected unix:<path> or tcp:<ip>:<port>")]
+pub struct InvalidAddress(String);
+
+impl FromStr for ListenAddress {
+    type Err = InvalidAddress;
+
+    fn from_str(address: &str) -> Result<Self, Self::Err> {
+        if let Some(path) = address.strip_prefix("unix:") {
+            Ok(ListenAddress::Unix(PathBuf::from(path)))
+        } else if let Some(socket_addr) = address.strip_prefix("tcp:") {
+            socket_addr
+                .parse()
+                .map(ListenAddress::Tcp)
+                .map_err(|_| InvalidAddress(address.to_owned()))
+        } else {
+            Err(InvalidAddress(address.to_owned()))
+        }
+    }
+}
+
+/// Binds a Unix-domain socket at the path. A socket left behind by a previous receiver is
+/// replaced, but any other file at the path is an error rather than deleted.
+pub fn bind_unix_listener(path: &Path) -> io::Result<UnixListener> {
+    match fs::symlink_metadata(path) {
+        Ok(metadata) if metadata.file_type().is_socket() => fs::remove_file(path)?,
+        Ok(_) => {
+            return Err(io::Error::new(
+                io::ErrorKind::AlreadyExists,
+                format!("{} exists and is not a socket", path.display()),
+            ))
+        }
+        Err(error) if error.kind() == io::ErrorKind::NotFound => {}
+        Err(error) => return Err(error),
+    }
+    UnixListener::bind(path)
+}
+
+/// Statistics of a live stream.
+#[derive(Debug, Default)]
+pub struct StreamStats {
+    /// Total number of bytes received.
+    pub bytes: u64,
+    /// Number of records received.
+    pub records: u64,
+    /// Time elapsed between the first and the last chunk of data.
+    pub active_time: Duration,
+}
+
+impl StreamStats {
+    /// Prints the throughput achieved while data was flowing.
+    pub fn print_throughput(&self) {
+        let secs = self.active_time.as_secs_f64();
+        if secs == 0.0 {
+            eprintln!("Received {} records ({} bytes)", self.records, self.bytes);
+            return;
+        }
+        eprintln!(
+            "Received {} records ({} bytes) in {:.3} s: {:.0} records/s, {:.1} KiB/s",
+            self.records,
+            self.bytes,
+            secs,
+            self.records as f64 / secs,
+            self.bytes as f64 / 1024.0 / secs
+        );
+    }
+}
+
+/// Reads records from a live stream until it is closed, calling the handler with each of them
+/// as soon as it is complete.
+pub fn receive_stream(
+    mut stream: impl Read,
+    framing: Framing,
+    mut handler: impl FnMut(&[u8]),
+) -> io::Result<StreamStats> {
+    let mut stats = StreamStats::default();
+    let mut first_data = None;
+    let mut data = vec![];
+    let mut chunk = vec![0u8; STREAM_READ_SIZE];
+    loop {
+        let count = match stream.read(&mut chunk) {
+            Ok(0) => break,
+            Ok(count) => count,
+            Err(e) if e.kind() == io::ErrorKind::Interrupted => continue,
+            Err(e) => return Err(e),
+        };
+        let now = Instant::now();
+        stats.active_time = now - *first_data.get_or_insert(now);
+        stats.bytes += count as u64;
+
+        data.extend_from_slice(&chunk[..count]);
+        let consumed = for_each_record(&data, framing, |record| {
+            stats.records += 1;
+            handler(record)
+        });
+        data.drain(..consumed);
+    }
+    Ok(stats)
+}
+
 /// Returns the associated color for the log level
 fn color_for_level(level: LogLevel) -> String {
     match level {
+        LogLevel::Trace => String::from(color::Cyan.fg_str()),
+        LogLevel::Metric => String::from(color::Magenta.fg_str()),
         LogLevel::Debug => String::from(color::Green.fg_str()),
         LogLevel::Info => String::from(color::Yellow.fg_str()),
         LogLevel::Warning => color::Rgb(255u8, 0xA5u8, 0u8).fg_string(),
@@ -12,34 +214,73 @@ fn color_for_level(level: LogLevel) -> String {
     }
 }
 
-/// Reads a log from buffer and prints it to stdout
-pub fn handle_log(elf_metadata: &ElfMetadata, buffer: &[u8]) {
+/// Formats a decoded log for display.
+pub fn format_decoded_log(log: &Log) -> String {
+    // Trace events and metrics have no call site
+    if log.level == LogLevel::Trace || log.level == LogLevel::Metric {
+        return format!(
+            "{timestamp:<12.6} {color}{level:<11}{reset_color}: {msg}\n",
+            timestamp = log.timestamp,
+            color = color_for_level(log.level),
+            level = log.level.to_string(),
+            reset_color = color::Fg(color::Reset),
+            msg = log.message,
+        );
+    }
+    format!(
+        "{timestamp:<12.6} {color}{level:<11}{reset_color}: {msg}\n\
+         {file_color}└── File: {file_name}, Line number: {line_number}{reset}\n",
+        timestamp = log.timestamp,
+        color = color_for_level(log.level),
+        level = log.level.to_string(),
+        reset_color = color::Fg(color::Reset),
+        msg = log.message,
+        file_color = color::Fg(color::LightBlack),
+        file_name = log.file_name,
+        line_number = log.line_number,
+        reset = color::Fg(color::Reset)
+    )
+}
+
+/// Formats the error of a log that could not be decoded.
+pub(crate) fn format_error(error: postform_decoder::Error) -> String {
+    format!(
+        "{color}Error parsing log:{reset_color} {error}.\n",
+        color = color::Fg(color::Red),
+        error = error,
+        reset_color = color::Fg(color::Reset)
+    )
+}
+
+/// Decodes a log from the buffer and formats it for display.
+pub fn format_log(elf_metadata: &ElfMetadata, buffer: &[u8]) -> String {
     let mut decoder = Decoder::new(&elf_metadata);
     match decoder.decode(buffer) {
-        Ok(log) => {
-            println!(
-                "{timestamp:<12.6} {color}{level:<11}{reset_color}: {msg}",
-                timestamp = log.timestamp,
-                color = color_for_level(log.level),
-                level = log.level.to_string(),
-                reset_color = color::Fg(color::Reset),
-                msg = log.message
-            );
-            println!(
-                "{color}└── File: {file_name}, Line number: {line_number}{reset}",
-                color = color::Fg(color::LightBlack),
-                file_name = log.file_name,
-                line_number = log.line_number,
-                reset = color::Fg(color::Reset)
-            );
-        }
-        Err(error) => {
-            println!(
-                "{color}Error parsing log:{reset_color} {error}.",
-                color = color::Fg(color::Red),
-                error = error,
-                reset_color = color::Fg(color::Reset)
-            );
-        }
+        Ok(log) => format_decoded_log(&log),
+        Err(error) => format_error(error),
+    }
+}
+
+/// Reads a log from buffer and prints it to stdout
+pub fn handle_log(elf_metadata: &ElfMetadata, buffer: &[u8]) {
+    print!("{}", format_log(elf_metadata, buffer));
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_bind_unix_listener_keeps_other_files() {
+        let path = std::env::temp_dir().join(format!("postform_listen_{}", std::process::id()));
+        fs::write(&path, b"firmware").unwrap();
+        assert!(bind_unix_listener(&path).is_err());
+        assert_eq!(fs::read(&path).unwrap(), b"firmware");
+        fs::remove_file(&path).unwrap();
+
+        // A stale socket is replaced
+        drop(bind_unix_listener(&path).unwrap());
+        drop(bind_unix_listener(&path).unwrap());
+        fs::remove_file(&path).unwrap();
     }
 }
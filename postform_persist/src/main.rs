@@ -1,8 +1,17 @@
+use color_eyre::eyre::eyre;
 use color_eyre::eyre::Result;
-use postform_decoder::{ElfMetadata, POSTFORM_VERSION};
-use postform_persist::handle_log;
-use std::convert::TryInto;
-use std::io::prelude::*;
+use postform_decoder::counters::{format_report, MemoryImage};
+use postform_decoder::{filter::Filter, Decoder, ElfMetadata, LogLevel, POSTFORM_VERSION};
+use postform_persist::export::{create_exporter, ExportFormat};
+use postform_persist::follow::follow_file;
+use postform_persist::merge::{merge, MergeOutput, MergeSource};
+use postform_persist::stats::BandwidthStats;
+use postform_persist::{bind_unix_listener, handle_log, receive_stream, Framing, ListenAddress};
+use std::cell::RefCell;
+use std::io::{self, Write};
+use std::net::TcpListener;
+use std::ops::ControlFlow;
+use std::str::FromStr;
 use std::{fs, path::PathBuf};
 use structopt::StructOpt;
 
@@ -13,24 +22,215 @@ fn print_version() {
 }
 
 #[derive(Debug, StructOpt)]
-#[structopt()]
+#[structopt(
+    setting = structopt::clap::AppSettings::SubcommandsNegateReqs,
+    setting = structopt::clap::AppSettings::ArgsNegateSubcommands
+)]
 struct Opts {
-    /// Path to an ELF firmware file.
+    /// Path to an ELF firmware file. Write `--` before it if it is named like a subcommand.
     #[structopt(name = "ELF", parse(from_os_str), required_unless_one(&["version"]))]
     elf: Option<PathBuf>,
 
     /// Path to the binary log file.
-    #[structopt(name = "LOG_FILE", parse(from_os_str), required_unless_one(&["version"]))]
+    #[structopt(
+        name = "LOG_FILE",
+        parse(from_os_str),
+        required_unless_one(&["version", "listen"])
+    )]
     log_file: Option<PathBuf>,
 
+    /// Receive logs live from a `SocketLogger` instead of reading a file. The address is either
+    /// `unix:<path>` or `tcp:<ip>:<port>`.
+    #[structopt(long, conflicts_with("capture"))]
+    listen: Option<ListenAddress>,
+
+    /// Decode a raw RTT capture recorded with `postform_rtt --capture` instead of a
+    /// `FileLogger` log.
+    #[structopt(long)]
+    capture: bool,
+
+    /// Keep the log file open and decode records as they are appended to it.
+    #[structopt(long, short = "f", conflicts_with("listen"))]
+    follow: bool,
+
+    /// Only show logs of this level or above (trace, metric, debug, info, warning or
+    /// error).
+    #[structopt(long)]
+    level: Option<LogLevel>,
+
+    /// Only show logs whose file name contains this text.
+    #[structopt(long)]
+    file: Option<String>,
+
+    /// Only show logs emitted from this line number.
+    #[structopt(long)]
+    line: Option<u32>,
+
+    /// Only show logs whose format string contains this text.
+    #[structopt(long)]
+    grep: Option<String>,
+
+    /// Export the logs as jsonl, csv, columnar, chrome-trace, folded, metrics-csv or prometheus
+    /// instead of printing them.
+    #[structopt(long, conflicts_with("listen"))]
+    export: Option<ExportFormat>,
+
+    /// File to export the logs to. Defaults to stdout.
+    #[structopt(long, short = "o", parse(from_os_str), requires("export"))]
+    output: Option<PathBuf>,
+
+    /// Print the bandwidth used by each format ID instead of the logs. Records are not
+    /// formatted.
+    #[structopt(long, conflicts_with_all(&["listen", "follow", "export"]))]
+    stats: bool,
+
+    /// Number of format IDs shown by `--stats`.
+    #[structopt(long, default_value = "20")]
+    top: usize,
+
     #[structopt(long, short = "V")]
     version: bool,
+
+    #[structopt(subcommand)]
+    command: Option<Command>,
+}
+
+#[derive(Debug, StructOpt)]
+enum Command {
+    /// Merges the logs of several sources into a single log ordered by time.
+    Merge(MergeOpts),
+    /// Ranks the log call sites of the firmware by the hits recorded in a memory image.
+    Counters(CountersOpts),
+}
+
+/// Options of `postform_persist merge`.
+#[derive(Debug, StructOpt)]
+struct MergeOpts {
+    /// Logs to merge, as ELF=LOCATION[@OFFSET]. LOCATION is file:<path> for `FileLogger` logs
+    /// or capture:<path> for raw RTT captures. OFFSET, in seconds, is added to all timestamps of
+    /// the source.
+    #[structopt(name = "SOURCE", required = true)]
+    sources: Vec<MergeSource>,
+
+    /// Write a binary log that can be decoded with the ELF of the sources instead of text. All
+    /// sources must come from the same firmware build.
+    #[structopt(long)]
+    binary: bool,
+
+    /// File to write the merged logs to. Defaults to stdout.
+    #[structopt(long, short = "o", parse(from_os_str))]
+    output: Option<PathBuf>,
+}
+
+/// Merges the logs of several sources into a single log ordered by time.
+fn merge_logs(opts: MergeOpts) -> Result<()> {
+    let writer: Box<dyn Write> = match &opts.output {
+        Some(path) => Box::new(io::BufWriter::new(fs::File::create(path)?)),
+        None => Box::new(io::BufWriter::new(io::stdout())),
+    };
+    let output = if opts.binary {
+        MergeOutput::Binary(writer)
+    } else {
+        MergeOutput::Text(writer)
+    };
+    let records = merge(&opts.sources, output)?;
+    eprintln!(
+        "Merged {} records from {} sources",
+        records,
+        opts.sources.len()
+    );
+    Ok(())
+}
+
+/// Options of `postform_persist counters`.
+#[derive(Debug, StructOpt)]
+struct CountersOpts {
+    /// Path to an ELF firmware file.
+    #[structopt(name = "ELF", parse(from_os_str))]
+    elf: PathBuf,
+
+    /// Memory image of the target holding the call site counters, as PATH@ADDRESS. ADDRESS is
+    /// the address of the first byte of the image, e.g. 0x20000000.
+    #[structopt(name = "IMAGE")]
+    image: ImageLocation,
+
+    /// Number of call sites shown in each ranking.
+    #[structopt(long, default_value = "20")]
+    top: usize,
+}
+
+/// Memory image file and the address of its first byte.
+#[derive(Debug)]
+struct ImageLocation {
+    path: PathBuf,
+    base: u64,
+}
+
+impl FromStr for ImageLocation {
+    type Err = String;
+
+    fn from_str(location: &str) -> Result<Self, Self::Err> {
+        let separator = location
+            .rfind('@')
+            .ok_or_else(|| format!("Missing address in '{}'", location))?;
+        let address = &location[separator + 1..];
+        let base = match address.strip_prefix("0x") {
+            Some(hex) => u64::from_str_radix(hex, 16),
+            None => address.parse(),
+        }
+        .map_err(|_| format!("Invalid address '{}'", address))?;
+        Ok(Self {
+            path: PathBuf::from(&location[..separator]),
+            base,
+        })
+    }
+}
+
+/// Ranks the log call sites of the firmware by the hits recorded in a memory image.
+fn report_counters(opts: CountersOpts) -> Result<()> {
+    let elf_metadata = ElfMetadata::from_elf_file(&opts.elf)?;
+    let (start, end) = elf_metadata
+        .counters_range()
+        .ok_or_else(|| eyre!("The firmware has no call site counters"))?;
+    let memory = MemoryImage {
+        base: opts.image.base,
+        data: fs::read(opts.image.path)?,
+    };
+    let mut hits = elf_metadata
+        .call_site_hits(&memory)
+        .map_err(|error| eyre!("{}. The image must cover 0x{:x}..0x{:x}", error, start, end))?;
+    print!("{}", format_report(&mut hits, opts.top));
+    Ok(())
+}
+
+/// Decodes the streams of the `SocketLogger`s connecting to the address, one at a time.
+fn serve(address: &ListenAddress, handler: impl Fn(&[u8]) + Copy) -> Result<()> {
+    match address {
+        ListenAddress::Unix(path) => {
+            let listener = bind_unix_listener(path)?;
+            for stream in listener.incoming() {
+                receive_stream(stream?, Framing::LengthPrefixed, handler)?.print_throughput();
+            }
+        }
+        ListenAddress::Tcp(socket_addr) => {
+            let listener = TcpListener::bind(socket_addr)?;
+            for stream in listener.incoming() {
+                receive_stream(stream?, Framing::LengthPrefixed, handler)?.print_throughput();
+            }
+        }
+    }
+    Ok(())
 }
 
 fn main() -> Result<()> {
     color_eyre::install()?;
 
     let opts = Opts::from_args();
+    match opts.command {
+        Some(Command::Merge(merge_opts)) => return merge_logs(merge_opts),
+        Some(Command::Counters(counters_opts)) => return report_counters(counters_opts),
+        None => {}
+    }
 
     if opts.version {
         print_version();
@@ -40,19 +240,97 @@ fn main() -> Result<()> {
     let elf_name = opts.elf.unwrap();
     let elf_metadata = ElfMetadata::from_elf_file(&elf_name)?;
 
-    let mut log_file = fs::File::open(opts.log_file.unwrap())?;
-    let mut log_data = vec![];
-    log_file.read_to_end(&mut log_data)?;
-
-    let mut log_data = &log_data[..];
-    loop {
-        let (size_bits, rest) = log_data.split_at(std::mem::size_of::<u32>());
-        let size = u32::from_le_bytes(size_bits.try_into().unwrap()) as usize;
-        handle_log(&elf_metadata, &rest[..size]);
-        log_data = &log_data[4 + size..];
-        if log_data.is_empty() {
-            break;
+    let filter = Filter {
+        min_level: opts.level,
+        file: opts.file,
+        line: opts.line,
+        text: opts.grep,
+    };
+    // Logs filtered out are skipped after reading their format ID, before any formatting.
+    let format_ids = if filter.is_empty() {
+        None
+    } else {
+        Some(filter.resolve(&elf_metadata))
+    };
+    let handler = |record: &[u8]| {
+        if format_ids.as_ref().map_or(true, |ids| ids.contains(record)) {
+            handle_log(&elf_metadata, record)
+        }
+    };
+
+    if let Some(address) = &opts.listen {
+        return serve(address, &handler);
+    }
+
+    let log_path = opts.log_file.unwrap();
+    let framing = if opts.capture {
+        Framing::Cobs
+    } else {
+        Framing::LengthPrefixed
+    };
+
+    if opts.stats {
+        let mut stats = BandwidthStats::new(elf_metadata.timestamp_frequency());
+        receive_stream(fs::File::open(log_path)?, framing, |record: &[u8]| {
+            if format_ids.as_ref().map_or(true, |ids| ids.contains(record)) {
+                stats.add(record)
+            }
+        })?;
+        print!("{}", stats.format_report(&elf_metadata, opts.top));
+        return Ok(());
+    }
+
+    if let Some(export_format) = opts.export {
+        if opts.follow
+            && (export_format == ExportFormat::Columnar
+                || export_format == ExportFormat::FoldedStacks
+                || export_format == ExportFormat::Prometheus)
+        {
+            return Err(eyre!(
+                "Columnar, folded and prometheus exports can't be followed"
+            ));
+        }
+        let output: Box<dyn Write> = match &opts.output {
+            Some(path) => Box::new(io::BufWriter::new(fs::File::create(path)?)),
+            None => Box::new(io::BufWriter::new(io::stdout())),
+        };
+        // Shared by the record handler and, when following, the flush after every batch
+        let exporter = RefCell::new(create_exporter(export_format, output));
+        // The first export error, which stops exporting
+        let result = RefCell::new(Ok(()));
+        let export_handler = |record: &[u8]| {
+            if result.borrow().is_err()
+                || !format_ids.as_ref().map_or(true, |ids| ids.contains(record))
+            {
+                return;
+            }
+            match Decoder::new(&elf_metadata).decode(record) {
+                Ok(log) => *result.borrow_mut() = exporter.borrow_mut().export(&log),
+                Err(error) => eprintln!("Error parsing log: {}.", error),
+            }
+        };
+        if opts.follow {
+            // Following only stops on errors, so the records are flushed after every batch
+            // rather than on finish
+            follow_file(&log_path, framing, export_handler, || {
+                result.replace(Ok(()))?;
+                exporter.borrow_mut().flush()?;
+                Ok(ControlFlow::Continue(()))
+            })?;
+            return Ok(());
         }
+        receive_stream(fs::File::open(log_path)?, framing, export_handler)?;
+        result.into_inner()?;
+        exporter.into_inner().finish()?;
+        return Ok(());
+    }
+
+    if opts.follow {
+        follow_file(&log_path, framing, handler, || {
+            Ok(ControlFlow::Continue(()))
+        })?;
+    } else {
+        receive_stream(fs::File::open(log_path)?, framing, handler)?;
     }
 
     Ok(())
@@ -0,0 +1,326 @@
+use crate::{format_decoded_log, format_error, Framing};
+use postform_decoder::{build_id, decode_timestamp, Decoder, ElfMetadata};
+use std::cmp::Reverse;
+use std::collections::BinaryHeap;
+use std::fs::{self, File};
+use std::io::{self, BufRead, BufReader, Write};
+use std::path::PathBuf;
+use std::rc::Rc;
+use std::str::FromStr;
+
+/// Size of the read buffer of each merged log.
+const READ_BUFFER_SIZE: usize = 64 * 1024;
+
+/// A log file to merge, written as `ELF=LOCATION[@OFFSET]`.
+///
+/// LOCATION is `file:<path>` for logs written by a `FileLogger` or `capture:<path>` for raw RTT
+/// captures. OFFSET is added to every timestamp of the log, in seconds, to align sources whose
+/// clocks started at different times.
+#[derive(Clone, Debug)]
+pub struct MergeSource {
+    pub elf: PathBuf,
+    pub log_file: PathBuf,
+    pub framing: Framing,
+    pub offset: f64,
+    /// Location as given by the user, used to label the output.
+    pub name: String,
+}
+
+/// Error parsing a `MergeSource`
+#[derive(Debug, thiserror::Error)]
+#[error(
+    "Invalid source {0}, expected ELF=LOCATION[@OFFSET] with LOCATION one of file:<path> or \
+     capture:<path>"
+)]
+pub struct InvalidMergeSource(String);
+
+impl FromStr for MergeSource {
+    type Err = InvalidMergeSource;
+
+    fn from_str(spec: &str) -> Result<Self, Self::Err> {
+        let invalid = || InvalidMergeSource(spec.to_owned());
+        let mut parts = spec.splitn(2, '=');
+        let elf = parts
+            .next()
+            .filter(|elf| !elf.is_empty())
+            .ok_or_else(invalid)?;
+        let mut name = parts.next().ok_or_else(invalid)?;
+
+        let mut offset = 0f64;
+        if let Some((location, value)) = name.rsplit_once('@') {
+            offset = value.parse().map_err(|_| invalid())?;
+            name = location;
+        }
+
+        let (log_file, framing) = if let Some(path) = name.strip_prefix("file:") {
+            (path, Framing::LengthPrefixed)
+        } else if let Some(path) = name.strip_prefix("capture:") {
+            (path, Framing::Cobs)
+        } else {
+            return Err(invalid());
+        };
+        Ok(Self {
+            elf: PathBuf::from(elf),
+            log_file: PathBuf::from(log_file),
+            framing,
+            offset,
+            name: name.to_owned(),
+        })
+    }
+}
+
+/// Reads the records of a log one at a time.
+pub struct RecordReader<R: BufRead> {
+    input: R,
+    framing: Framing,
+    frame: Vec<u8>,
+}
+
+impl<R: BufRead> RecordReader<R> {
+    pub fn new(input: R, framing: Framing) -> Self {
+        Self {
+            input,
+            framing,
+            frame: vec![],
+        }
+    }
+
+    /// Reads the next record into `record`. Returns false at the end of the log, including when
+    /// the last record is truncated.
+    pub fn read(&mut self, record: &mut Vec<u8>) -> io::Result<bool> {
+        loop {
+            record.clear();
+            match self.framing {
+                Framing::LengthPrefixed => {
+                    let mut size = [0u8; 4];
+                    if let Err(e) = self.input.read_exact(&mut size) {
+                        return end_of_log(e);
+                    }
+                    record.resize(u32::from_le_bytes(size) as usize, 0);
+                    if let Err(e) = self.input.read_exact(record) {
+                        return end_of_log(e);
+                    }
+                    return Ok(true);
+                }
+                Framing::Cobs => {
+                    self.frame.clear();
+                    self.input.read_until(0, &mut self.frame)?;
+                    if self.frame.last() != Some(&0) {
+                        return Ok(false);
+                    }
+                    // Frames that fail to decode are reported and skipped.
+                    crate::for_each_record(&self.frame, Framing::Cobs, |data| {
+                        record.extend_from_slice(data)
+                    });
+                    if !record.is_empty() {
+                        return Ok(true);
+                    }
+                }
+            }
+        }
+    }
+}
+
+fn end_of_log(error: io::Error) -> io::Result<bool> {
+    if error.kind() == io::ErrorKind::UnexpectedEof {
+        Ok(false)
+    } else {
+        Err(error)
+    }
+}
+
+/// How merged logs are written.
+pub enum MergeOutput {
+    /// Decoded logs, prefixed with the name of their source.
+    Text(Box<dyn Write>),
+    /// Records framed as written by a `FileLogger`, with their timestamps converted to the
+    /// common timebase. All sources must come from the same firmware build, whose ELF decodes
+    /// the merged log.
+    Binary(Box<dyn Write>),
+}
+
+/// A merged log, holding only the next record not yet written.
+struct Input {
+    name: String,
+    elf_metadata: Rc<ElfMetadata>,
+    reader: RecordReader<BufReader<File>>,
+    offset: f64,
+    record: Vec<u8>,
+}
+
+impl Input {
+    /// Reads the next valid record, returning its time in nanoseconds of the common timebase.
+    fn advance(&mut self) -> io::Result<Option<i64>> {
+        while self.reader.read(&mut self.record)? {
+            match decode_timestamp(&self.record) {
+                Ok((ticks, _)) => {
+                    let seconds =
+                        ticks as f64 / self.elf_metadata.timestamp_frequency() + self.offset;
+                    return Ok(Some((seconds * 1_000_000_000f64).round() as i64));
+                }
+                Err(error) => eprintln!("[{}] Error parsing log: {}.", self.name, error),
+            }
+        }
+        Ok(None)
+    }
+}
+
+/// Writes the records of all sources ordered by their time in the common timebase.
+///
+/// Each log must be ordered by time, as written by a single logger. Only the next record of each
+/// source is kept in memory, in a heap ordered by time. Records with the same time are written
+/// in the order of their sources. Returns the number of records written.
+pub fn merge(sources: &[MergeSource], output: MergeOutput) -> color_eyre::Result<u64> {
+    let mut builds: Vec<(PathBuf, String, Rc<ElfMetadata>)> = vec![];
+    let mut inputs = vec![];
+    for source in sources {
+        let elf_metadata = match builds.iter().find(|(elf, _, _)| *elf == source.elf) {
+            Some((_, _, elf_metadata)) => elf_metadata.clone(),
+            None => {
+                let elf_data = fs::read(&source.elf)?;
+                let elf_metadata = Rc::new(ElfMetadata::from_elf_data(&elf_data)?);
+                builds.push((
+                    source.elf.clone(),
+                    build_id(&elf_data)?,
+                    elf_metadata.clone(),
+                ));
+                elf_metadata
+            }
+        };
+        let file = File::open(&source.log_file)?;
+        inputs.push(Input {
+            name: source.name.clone(),
+            elf_metadata,
+            reader: RecordReader::new(
+                BufReader::with_capacity(READ_BUFFER_SIZE, file),
+                source.framing,
+            ),
+            offset: source.offset,
+            record: vec![],
+        });
+    }
+
+    if let MergeOutput::Binary(_) = output {
+        if builds.iter().any(|(_, id, _)| *id != builds[0].1) {
+            return Err(color_eyre::eyre::eyre!(
+                "Binary merges need all sources to come from the same firmware build"
+            ));
+        }
+    }
+
+    let mut heap = BinaryHeap::with_capacity(inputs.len());
+    for (index, input) in inputs.iter_mut().enumerate() {
+        if let Some(time) = input.advance()? {
+            heap.push(Reverse((time, index)));
+        }
+    }
+
+    let mut records = 0;
+    let mut output = output;
+    while let Some(Reverse((time, index))) = heap.pop() {
+        let input = &mut inputs[index];
+        match &mut output {
+            MergeOutput::Text(writer) => write_text(writer, input, time)?,
+            MergeOutput::Binary(writer) => write_binary(writer, input, time)?,
+        }
+        records += 1;
+        if let Some(time) = input.advance()? {
+            heap.push(Reverse((time, index)));
+        }
+    }
+
+    match &mut output {
+        MergeOutput::Text(writer) | MergeOutput::Binary(writer) => writer.flush()?,
+    }
+    Ok(records)
+}
+
+fn write_text(output: &mut Box<dyn Write>, input: &Input, time: i64) -> io::Result<()> {
+    let text = match Decoder::new(&input.elf_metadata).decode(&input.record) {
+        Ok(mut log) => {
+            log.timestamp = time as f64 / 1_000_000_000f64;
+            format_decoded_log(&log)
+        }
+        Err(error) => format_error(error),
+    };
+    for line in text.lines() {
+        writeln!(output, "[{}] {}", input.name, line)?;
+    }
+    Ok(())
+}
+
+/// Writes the record framed by its size, with its timestamp replaced by the time in the common
+/// timebase. Times before the start of the timebase are clamped to 0.
+fn write_binary(output: &mut Box<dyn Write>, input: &Input, time: i64) -> io::Result<()> {
+    let (_, rest) = decode_timestamp(&input.record).expect("Timestamp was decoded before");
+    let ticks = (time.max(0) as f64 / 1_000_000_000f64 * input.elf_metadata.timestamp_frequency())
+        .round() as u64;
+
+    let mut timestamp = vec![];
+    write_unsigned_leb128(&mut timestamp, ticks);
+    output.write_all(&((timestamp.len() + rest.len()) as u32).to_le_bytes())?;
+    output.write_all(&timestamp)?;
+    output.write_all(rest)
+}
+
+fn write_unsigned_leb128(output: &mut Vec<u8>, mut value: u64) {
+    loop {
+        let byte = (value & 0x7f) as u8;
+        value >>= 7;
+        if value == 0 {
+            output.push(byte);
+            return;
+        }
+        output.push(byte | 0x80);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_parse_merge_source() {
+        let source: MergeSource = "fw.elf=capture:logs/a.cap@-1.5".parse().unwrap();
+        assert_eq!(source.elf, PathBuf::from("fw.elf"));
+        assert_eq!(source.log_file, PathBuf::from("logs/a.cap"));
+        assert_eq!(source.offset, -1.5);
+        assert_eq!(source.name, "capture:logs/a.cap");
+
+        let source: MergeSource = "fw.elf=file:host.log".parse().unwrap();
+        assert_eq!(source.offset, 0f64);
+        assert!(matches!(source.framing, Framing::LengthPrefixed));
+
+        assert!("fw.elf=host.log".parse::<MergeSource>().is_err());
+        assert!("fw.elf=file:host.log@soon".parse::<MergeSource>().is_err());
+    }
+
+    #[test]
+    fn test_record_reader() {
+        let data = [2u8, 0, 0, 0, 10, 11, 1, 0, 0, 0, 12, 3, 0, 0, 0, 13];
+        let mut reader = RecordReader::new(&data[..], Framing::LengthPrefixed);
+        let mut record = vec![];
+        assert!(reader.read(&mut record).unwrap());
+        assert_eq!(record, vec![10, 11]);
+        assert!(reader.read(&mut record).unwrap());
+        assert_eq!(record, vec![12]);
+        // The last record is truncated
+        assert!(!reader.read(&mut record).unwrap());
+
+        let data = [3u8, 10, 11, 0, 2, 12, 0, 2, 13];
+        let mut reader = RecordReader::new(&data[..], Framing::Cobs);
+        assert!(reader.read(&mut record).unwrap());
+        assert_eq!(record, vec![10, 11]);
+        assert!(reader.read(&mut record).unwrap());
+        assert_eq!(record, vec![12]);
+        assert!(!reader.read(&mut record).unwrap());
+    }
+
+    #[test]
+    fn test_leb128() {
+        let mut encoded = vec![];
+        write_unsigned_leb128(&mut encoded, 300);
+        assert_eq!(encoded, vec![0xAC, 0x02]);
+        assert_eq!(decode_timestamp(&encoded).unwrap().0, 300);
+    }
+}
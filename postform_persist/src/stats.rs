@@ -0,0 +1,219 @@
+use postform_decoder::{decode_header, decode_timestamp, Decoder, ElfMetadata, LogLevel};
+use std::collections::HashMap;
+use std::fmt::Write;
+
+/// Length of the windows used to find the peak rate of a format ID, in seconds.
+const PEAK_WINDOW: f64 = 1.0;
+
+/// Bandwidth used by the records of a single format ID.
+#[derive(Debug, Default)]
+pub struct FormatStats {
+    pub records: u64,
+    /// Bytes used by the timestamps of the records.
+    pub timestamp_bytes: u64,
+    /// Bytes used by the format IDs of the records.
+    pub format_id_bytes: u64,
+    /// Bytes used by the arguments of the records.
+    pub argument_bytes: u64,
+    /// Largest number of bytes sent within a single peak window.
+    pub peak_window_bytes: u64,
+    window: u64,
+    window_bytes: u64,
+    /// First record of the format ID, decoded once to describe it in the report.
+    first_record: Vec<u8>,
+}
+
+impl FormatStats {
+    /// Total size of the records, without framing.
+    pub fn bytes(&self) -> u64 {
+        self.timestamp_bytes + self.format_id_bytes + self.argument_bytes
+    }
+}
+
+/// Attributes the bandwidth used by a log to the format IDs of its records.
+///
+/// Records are only split into timestamp, format ID and arguments, their arguments are neither
+/// decoded nor formatted.
+pub struct BandwidthStats {
+    timestamp_freq: f64,
+    by_format_id: HashMap<usize, FormatStats>,
+    /// Records whose timestamp or format ID could not be read.
+    pub invalid_records: u64,
+    first_ticks: Option<u64>,
+    last_ticks: u64,
+}
+
+impl BandwidthStats {
+    /// Creates empty stats for logs whose timestamps count at the given frequency.
+    pub fn new(timestamp_freq: f64) -> Self {
+        Self {
+            timestamp_freq,
+            by_format_id: HashMap::new(),
+            invalid_records: 0,
+            first_ticks: None,
+            last_ticks: 0,
+        }
+    }
+
+    /// Accounts for a record.
+    pub fn add(&mut self, record: &[u8]) {
+        let (ticks, format_id, arguments) = match decode_header(record) {
+            Ok(header) => header,
+            Err(_) => {
+                self.invalid_records += 1;
+                return;
+            }
+        };
+        let first_ticks = *self.first_ticks.get_or_insert(ticks);
+        self.last_ticks = self.last_ticks.max(ticks);
+        let (_, after_timestamp) = decode_timestamp(record).expect("Header was decoded before");
+        let timestamp_bytes = (record.len() - after_timestamp.len()) as u64;
+        let format_id_bytes = (after_timestamp.len() - arguments.len()) as u64;
+
+        let stats = self.by_format_id.entry(format_id).or_default();
+        if stats.records == 0 {
+            stats.first_record = record.to_vec();
+        }
+        stats.records += 1;
+        stats.timestamp_bytes += timestamp_bytes;
+        stats.format_id_bytes += format_id_bytes;
+        stats.argument_bytes += arguments.len() as u64;
+
+        let elapsed = ticks.saturating_sub(first_ticks) as f64 / self.timestamp_freq;
+        let window = (elapsed / PEAK_WINDOW) as u64;
+        if window != stats.window {
+            stats.window = window;
+            stats.window_bytes = 0;
+        }
+        stats.window_bytes += record.len() as u64;
+        stats.peak_window_bytes = stats.peak_window_bytes.max(stats.window_bytes);
+    }
+
+    /// Returns the stats of a format ID, if any of its records was seen.
+    pub fn get(&self, format_id: usize) -> Option<&FormatStats> {
+        self.by_format_id.get(&format_id)
+    }
+
+    /// Time between the first and the last record, in seconds.
+    pub fn duration(&self) -> f64 {
+        self.first_ticks.map_or(0f64, |first| {
+            self.last_ticks.saturating_sub(first) as f64 / self.timestamp_freq
+        })
+    }
+
+    /// Formats the totals and the `top` format IDs using the most bytes, along with their call
+    /// sites.
+    pub fn format_report(&self, elf_metadata: &ElfMetadata, top: usize) -> String {
+        let mut by_bytes: Vec<(&usize, &FormatStats)> = self.by_format_id.iter().collect();
+        by_bytes.sort_by(|(a_id, a), (b_id, b)| b.bytes().cmp(&a.bytes()).then(a_id.cmp(b_id)));
+
+        let records: u64 = by_bytes.iter().map(|(_, s)| s.records).sum();
+        let timestamp_bytes: u64 = by_bytes.iter().map(|(_, s)| s.timestamp_bytes).sum();
+        let format_id_bytes: u64 = by_bytes.iter().map(|(_, s)| s.format_id_bytes).sum();
+        let argument_bytes: u64 = by_bytes.iter().map(|(_, s)| s.argument_bytes).sum();
+        let bytes = timestamp_bytes + format_id_bytes + argument_bytes;
+        let duration = self.duration();
+        let share = |value: u64| {
+            if bytes == 0 {
+                0f64
+            } else {
+                value as f64 * 100f64 / bytes as f64
+            }
+        };
+        let rate = |value: u64| {
+            if duration == 0f64 {
+                "-".to_owned()
+            } else {
+                format!("{:.1}", value as f64 / duration)
+            }
+        };
+
+        let mut report = String::new();
+        writeln!(
+            report,
+            "{} records, {} bytes in {:.3} s ({} B/s) from {} format IDs",
+            records,
+            bytes,
+            duration,
+            rate(bytes),
+            by_bytes.len()
+        )
+        .unwrap();
+        writeln!(
+            report,
+            "timestamps: {} bytes ({:.1}%), format IDs: {} bytes ({:.1}%), arguments: {} bytes ({:.1}%)",
+            timestamp_bytes,
+            share(timestamp_bytes),
+            format_id_bytes,
+            share(format_id_bytes),
+            argument_bytes,
+            share(argument_bytes)
+        )
+        .unwrap();
+        if self.invalid_records != 0 {
+            writeln!(report, "{} invalid records", self.invalid_records).unwrap();
+        }
+
+        writeln!(
+            report,
+            "\n{:>9} {:>10} {:>6} {:>8} {:>8} {:>10} {:>6} {:>10} {:>10}  {:<7}  site",
+            "records", "bytes", "%", "ts", "id", "args", "avg", "B/s", "peak B/s", "level"
+        )
+        .unwrap();
+        let mut decoder = Decoder::new(elf_metadata);
+        for (format_id, stats) in by_bytes.iter().take(top) {
+            let (level, site) = match decoder.decode(&stats.first_record) {
+                Ok(log) if log.file_name.is_empty() => (log.level, log.format),
+                Ok(log) => (
+                    log.level,
+                    format!("{}:{} \"{}\"", log.file_name, log.line_number, log.format),
+                ),
+                Err(_) => (LogLevel::Unknown, format!("format ID {:#x}", format_id)),
+            };
+            writeln!(
+                report,
+                "{:>9} {:>10} {:>5.1}% {:>8} {:>8} {:>10} {:>6.1} {:>10} {:>10.1}  {:<7}  {}",
+                stats.records,
+                stats.bytes(),
+                share(stats.bytes()),
+                stats.timestamp_bytes,
+                stats.format_id_bytes,
+                stats.argument_bytes,
+                stats.bytes() as f64 / stats.records as f64,
+                rate(stats.bytes()),
+                stats.peak_window_bytes as f64 / PEAK_WINDOW,
+                level.to_string(),
+                site
+            )
+            .unwrap();
+        }
+        report
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_bandwidth_stats() {
+        let mut stats = BandwidthStats::new(100f64);
+        // Timestamp 5, format ID 128 and two bytes of arguments
+        stats.add(&[5, 0x80, 0x01, 1, 2]);
+        // Timestamp 300 and format ID 128, without arguments
+        stats.add(&[0xAC, 0x02, 0x80, 0x01]);
+        stats.add(&[0x80]);
+
+        assert_eq!(stats.invalid_records, 1);
+        assert_eq!(stats.duration(), 2.95);
+        let format_stats = stats.get(128).unwrap();
+        assert_eq!(format_stats.records, 2);
+        assert_eq!(format_stats.timestamp_bytes, 3);
+        assert_eq!(format_stats.format_id_bytes, 4);
+        assert_eq!(format_stats.argument_bytes, 2);
+        assert_eq!(format_stats.bytes(), 9);
+        // The records are in different windows
+        assert_eq!(format_stats.peak_window_bytes, 5);
+        assert!(stats.get(5).is_none());
+    }
+}
@@ -0,0 +1,151 @@
+use serde_json::{json, Value};
+use std::fmt::Write;
+
+/// A measurement of the throughput of the logging pipeline.
+#[derive(Copy, Clone, Debug, PartialEq)]
+pub struct Metric {
+    pub name: &'static str,
+    pub value: f64,
+    /// Whether larger values are better, as for rates, or worse, as for sizes.
+    pub higher_is_better: bool,
+}
+
+/// Result of comparing a metric with its baseline.
+#[derive(Debug, PartialEq)]
+pub enum Verdict {
+    /// Within the tolerance of the baseline, or better.
+    Pass,
+    /// Worse than the baseline by more than the tolerance.
+    Regression,
+    /// The metric is not in the baseline.
+    Missing,
+}
+
+/// Relative change allowed by default when a baseline is first written.
+const DEFAULT_TOLERANCE: f64 = 0.25;
+
+/// Compares a metric with its baseline, an object with its `value` and the allowed relative
+/// `tolerance`.
+pub fn compare(metric: &Metric, baseline: &Value) -> Verdict {
+    let expected = match baseline[metric.name]["value"].as_f64() {
+        Some(expected) => expected,
+        None => return Verdict::Missing,
+    };
+    let tolerance = baseline[metric.name]["tolerance"]
+        .as_f64()
+        .unwrap_or(DEFAULT_TOLERANCE);
+    let regressed = if metric.higher_is_better {
+        metric.value < expected * (1f64 - tolerance)
+    } else {
+        metric.value > expected * (1f64 + tolerance)
+    };
+    if regressed {
+        Verdict::Regression
+    } else {
+        Verdict::Pass
+    }
+}
+
+/// Returns the baseline updated with the measured metrics, keeping the tolerances it had.
+pub fn updated_baseline(metrics: &[Metric], baseline: &Value) -> Value {
+    let mut updated = baseline.clone();
+    if !updated.is_object() {
+        updated = json!({});
+    }
+    for metric in metrics {
+        let tolerance = baseline[metric.name]["tolerance"]
+            .as_f64()
+            .unwrap_or(DEFAULT_TOLERANCE);
+        updated[metric.name] = json!({ "value": metric.value, "tolerance": tolerance });
+    }
+    updated
+}
+
+/// Formats the metrics next to their baselines. Returns the report and the names of the metrics
+/// that regressed.
+pub fn format_comparison(metrics: &[Metric], baseline: &Value) -> (String, Vec<&'static str>) {
+    let mut report = String::new();
+    let mut regressed = vec![];
+    writeln!(
+        report,
+        "{:<24} {:>14} {:>14} {:>8} {:>6}  result",
+        "metric", "measured", "baseline", "change", "tol"
+    )
+    .unwrap();
+    for metric in metrics {
+        let verdict = compare(metric, baseline);
+        if verdict == Verdict::Regression {
+            regressed.push(metric.name);
+        }
+        let expected = baseline[metric.name]["value"].as_f64();
+        let tolerance = baseline[metric.name]["tolerance"]
+            .as_f64()
+            .unwrap_or(DEFAULT_TOLERANCE);
+        writeln!(
+            report,
+            "{:<24} {:>14.2} {:>14} {:>8} {:>5.0}%  {}",
+            metric.name,
+            metric.value,
+            expected.map_or("-".to_owned(), |expected| format!("{:.2}", expected)),
+            expected.map_or("-".to_owned(), |expected| format!(
+                "{:+.1}%",
+                (metric.value - expected) * 100f64 / expected
+            )),
+            tolerance * 100f64,
+            match verdict {
+                Verdict::Pass => "ok",
+                Verdict::Regression => "REGRESSION",
+                Verdict::Missing => "no baseline",
+            }
+        )
+        .unwrap();
+    }
+    (report, regressed)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_compare_with_tolerance() {
+        let baseline = json!({
+            "decode_records_per_s": { "value": 1000.0, "tolerance": 0.1 },
+            "bytes_per_record": { "value": 10.0, "tolerance": 0.05 },
+        });
+        let rate = |value| Metric {
+            name: "decode_records_per_s",
+            value,
+            higher_is_better: true,
+        };
+        let size = |value| Metric {
+            name: "bytes_per_record",
+            value,
+            higher_is_better: false,
+        };
+        assert_eq!(compare(&rate(950.0), &baseline), Verdict::Pass);
+        assert_eq!(compare(&rate(2000.0), &baseline), Verdict::Pass);
+        assert_eq!(compare(&rate(850.0), &baseline), Verdict::Regression);
+        assert_eq!(compare(&size(10.4), &baseline), Verdict::Pass);
+        assert_eq!(compare(&size(10.6), &baseline), Verdict::Regression);
+        let missing = Metric {
+            name: "encode_records_per_s",
+            value: 1.0,
+            higher_is_better: true,
+        };
+        assert_eq!(compare(&missing, &baseline), Verdict::Missing);
+
+        let (report, regressed) = format_comparison(&[rate(850.0), size(10.0)], &baseline);
+        assert_eq!(regressed, ["decode_records_per_s"]);
+        assert!(report.lines().nth(1).unwrap().ends_with("REGRESSION"));
+
+        let updated = updated_baseline(&[rate(850.0), missing], &baseline);
+        assert_eq!(updated["decode_records_per_s"]["value"], 850.0);
+        assert_eq!(updated["decode_records_per_s"]["tolerance"], 0.1);
+        assert_eq!(
+            updated["encode_records_per_s"]["tolerance"],
+            DEFAULT_TOLERANCE
+        );
+        assert_eq!(updated["bytes_per_record"]["value"], 10.0);
+    }
+}
@@ -0,0 +1,89 @@
+//! Runs the `format_bench` firmware under QEMU and reports the cost of every logging call site.
+//!
+//! QEMU does not model the DWT cycle counter of the Cortex-M3, so the firmware falls back to the
+//! SysTick timer. With `-icount` QEMU advances the virtual clock a fixed amount of time per
+//! instruction, which makes SysTick ticks a deterministic instruction count.
+
+use color_eyre::eyre::{eyre, Result};
+use object::read::{File as ElfFile, Object, ObjectSymbol};
+use postform_rtt::emulator_bench::{format_report, parse_output};
+use std::collections::HashMap;
+use std::fs;
+use std::path::PathBuf;
+use std::process::{Command, Stdio};
+use structopt::StructOpt;
+
+#[derive(Debug, StructOpt)]
+#[structopt(name = "postform_qemu_bench")]
+struct Opts {
+    /// Path to the `format_bench` firmware.
+    #[structopt(parse(from_os_str))]
+    elf: PathBuf,
+
+    /// QEMU binary used to run the firmware.
+    #[structopt(long, default_value = "qemu-system-arm")]
+    qemu: String,
+
+    /// Cortex-M3 machine emulated by QEMU.
+    #[structopt(long, default_value = "stm32vldiscovery")]
+    machine: String,
+
+    /// Clock of the emulated CPU in Hz, which also drives its SysTick timer.
+    #[structopt(long, default_value = "24000000")]
+    cpu_clock: u64,
+
+    /// Every instruction takes 2^shift ns of virtual time.
+    #[structopt(long, default_value = "6")]
+    icount_shift: u32,
+}
+
+/// Size of every function in the firmware, which for the benchmark call sites is the flash they
+/// use.
+fn read_symbol_sizes(elf_path: &PathBuf) -> Result<HashMap<String, u64>> {
+    let file_contents = fs::read(elf_path)?;
+    let elf_file = ElfFile::parse(&file_contents[..])?;
+    Ok(elf_file
+        .symbols()
+        .filter_map(|symbol| {
+            symbol
+                .name()
+                .ok()
+                .map(|name| (name.to_owned(), symbol.size()))
+        })
+        .collect())
+}
+
+fn main() -> Result<()> {
+    color_eyre::install()?;
+    let opts = Opts::from_args();
+
+    let symbol_sizes = read_symbol_sizes(&opts.elf)?;
+    let output = Command::new(&opts.qemu)
+        .arg("-M")
+        .arg(&opts.machine)
+        .arg("-nographic")
+        .arg("-monitor")
+        .arg("none")
+        .arg("-serial")
+        .arg("none")
+        .arg("-semihosting-config")
+        .arg("enable=on,target=native")
+        .arg("-icount")
+        .arg(format!("shift={}", opts.icount_shift))
+        .arg("-kernel")
+        .arg(&opts.elf)
+        .stderr(Stdio::inherit())
+        .output()?;
+    if !output.status.success() {
+        return Err(eyre!("{} failed: {}", opts.qemu, output.status));
+    }
+    let run = parse_output(&String::from_utf8_lossy(&output.stdout))?;
+
+    let ns_per_instruction = (1u64 << opts.icount_shift) as f64;
+    let ticks_per_instruction = ns_per_instruction * opts.cpu_clock as f64 / 1e9;
+    print!(
+        "{}",
+        format_report(&run, ticks_per_instruction, &symbol_sizes)
+    );
+    Ok(())
+}
@@ -0,0 +1,184 @@
+//! Parses and reports the results of the `format_bench` firmware.
+
+use std::collections::HashMap;
+use std::fmt::Write;
+
+/// Counter the firmware measured the benchmarks with.
+#[derive(Copy, Clone, Debug, PartialEq)]
+pub enum Clock {
+    /// CPU cycles counted by the DWT.
+    Dwt,
+    /// Ticks of the SysTick timer, clocked by the CPU clock.
+    SysTick,
+}
+
+/// Result of a single benchmark, as printed by the firmware.
+#[derive(Clone, Debug, PartialEq)]
+pub struct BenchResult {
+    pub writer: String,
+    pub shape: String,
+    pub records: u64,
+    pub ticks: u64,
+    pub bytes: u64,
+    pub stack_bytes: u64,
+}
+
+/// Results of a run of the benchmark firmware.
+#[derive(Clone, Debug, PartialEq)]
+pub struct BenchRun {
+    pub clock: Clock,
+    pub results: Vec<BenchResult>,
+}
+
+#[derive(Debug, thiserror::Error, PartialEq)]
+pub enum BenchError {
+    #[error("Malformed benchmark output line: {0}")]
+    MalformedLine(String),
+    #[error("The benchmark firmware did not report its clock")]
+    MissingClock,
+    #[error("The benchmark firmware did not finish")]
+    Unfinished,
+}
+
+/// Parses the semihosting output of the benchmark firmware.
+pub fn parse_output(output: &str) -> Result<BenchRun, BenchError> {
+    let mut clock = None;
+    let mut results = vec![];
+    let mut finished = false;
+    for line in output
+        .lines()
+        .map(str::trim)
+        .filter(|line| !line.is_empty())
+    {
+        let fields: Vec<&str> = line.split_whitespace().collect();
+        match fields[..] {
+            ["clock", "dwt"] => clock = Some(Clock::Dwt),
+            ["clock", "systick"] => clock = Some(Clock::SysTick),
+            ["done"] => finished = true,
+            [writer, shape, records, ticks, bytes, stack_bytes] => {
+                let parse = |field: &str| {
+                    field
+                        .parse()
+                        .map_err(|_| BenchError::MalformedLine(line.to_owned()))
+                };
+                results.push(BenchResult {
+                    writer: writer.to_owned(),
+                    shape: shape.to_owned(),
+                    records: parse(records)?,
+                    ticks: parse(ticks)?,
+                    bytes: parse(bytes)?,
+                    stack_bytes: parse(stack_bytes)?,
+                });
+            }
+            _ => return Err(BenchError::MalformedLine(line.to_owned())),
+        }
+    }
+    if !finished {
+        return Err(BenchError::Unfinished);
+    }
+    Ok(BenchRun {
+        clock: clock.ok_or(BenchError::MissingClock)?,
+        results,
+    })
+}
+
+/// Name of the function of the firmware that holds a benchmarked call site.
+pub fn call_site_symbol(writer: &str, shape: &str) -> String {
+    format!("postform_bench_{}_{}", writer, shape)
+}
+
+/// Formats a table with the cost of every benchmark.
+///
+/// SysTick ticks are converted to instructions with `ticks_per_instruction`, which depends on the
+/// clock of the emulated CPU and on the time QEMU accounts for each instruction with `-icount`.
+/// `symbol_sizes` holds the size of the functions of the firmware, used as the flash usage of
+/// each call site.
+pub fn format_report(
+    run: &BenchRun,
+    ticks_per_instruction: f64,
+    symbol_sizes: &HashMap<String, u64>,
+) -> String {
+    let unit = match run.clock {
+        Clock::Dwt => "cycles",
+        Clock::SysTick => "instructions",
+    };
+    let mut report = String::new();
+    writeln!(
+        report,
+        "{:<10} {:<16} {:>14} {:>14} {:>12} {:>12}",
+        "writer",
+        "shape",
+        format!("{}/record", unit),
+        "bytes/record",
+        "flash bytes",
+        "stack bytes"
+    )
+    .unwrap();
+    for result in &run.results {
+        let records = result.records.max(1) as f64;
+        let ticks = match run.clock {
+            Clock::Dwt => result.ticks as f64,
+            Clock::SysTick => result.ticks as f64 / ticks_per_instruction,
+        };
+        let flash = symbol_sizes
+            .get(&call_site_symbol(&result.writer, &result.shape))
+            .map_or("-".to_owned(), |size| size.to_string());
+        writeln!(
+            report,
+            "{:<10} {:<16} {:>14.1} {:>14.2} {:>12} {:>12}",
+            result.writer,
+            result.shape,
+            ticks / records,
+            result.bytes as f64 / records,
+            flash,
+            result.stack_bytes
+        )
+        .unwrap();
+    }
+    report
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_parse_and_report() {
+        let output =
+            "clock systick\nnull no_args 1024 3072 9216 24\nnull int_1 1024 6144 13312 32\ndone\n";
+        let run = parse_output(output).unwrap();
+        assert_eq!(run.clock, Clock::SysTick);
+        assert_eq!(run.results.len(), 2);
+        assert_eq!(
+            run.results[1],
+            BenchResult {
+                writer: "null".to_owned(),
+                shape: "int_1".to_owned(),
+                records: 1024,
+                ticks: 6144,
+                bytes: 13312,
+                stack_bytes: 32,
+            }
+        );
+
+        let mut sizes = HashMap::new();
+        sizes.insert(call_site_symbol("null", "int_1"), 48);
+        let report = format_report(&run, 1.5, &sizes);
+        let lines: Vec<&str> = report.lines().collect();
+        assert!(lines[0].contains("instructions/record"));
+        assert_eq!(
+            lines[1].split_whitespace().collect::<Vec<_>>(),
+            ["null", "no_args", "2.0", "9.00", "-", "24"]
+        );
+        assert_eq!(
+            lines[2].split_whitespace().collect::<Vec<_>>(),
+            ["null", "int_1", "4.0", "13.00", "48", "32"]
+        );
+
+        assert_eq!(
+            parse_output("clock dwt\nnull no_args 1024\n"),
+            Err(BenchError::MalformedLine("null no_args 1024".to_owned()))
+        );
+        assert_eq!(parse_output("clock dwt\n"), Err(BenchError::Unfinished));
+    }
+}
@@ -1,5 +1,6 @@
 use color_eyre::eyre::Result;
 use object::read::{File as ElfFile, Object, ObjectSymbol};
+use postform_decoder::counters::{CallSiteHits, MemoryImage};
 use postform_decoder::{Decoder, ElfMetadata, LogLevel};
 use probe_rs::{
     flashing::{download_file, Format},
@@ -14,6 +15,10 @@ use std::{
 };
 use termion::color;
 
+pub mod emulator_bench;
+pub mod pipeline;
+pub mod shm;
+
 /// RTT Errors for Postform Rtt
 #[derive(Debug, thiserror::Error)]
 pub enum RttError {
@@ -96,6 +101,8 @@ pub fn disable_cdebugen(session: Arc<Mutex<Session>>) -> Result<()> {
 
 fn color_for_level(level: LogLevel) -> String {
     match level {
+        LogLevel::Trace => String::from(color::Cyan.fg_str()),
+        LogLevel::Metric => String::from(color::Magenta.fg_str()),
         LogLevel::Debug => String::from(color::Green.fg_str()),
         LogLevel::Info => String::from(color::Yellow.fg_str()),
         LogLevel::Warning => color::Rgb(255u8, 0xA5u8, 0u8).fg_string(),
@@ -104,36 +111,127 @@ fn color_for_level(level: LogLevel) -> String {
     }
 }
 
-/// Decodes a log from the buffer and prints it to stdout.
-pub fn handle_log(elf_metadata: &ElfMetadata, buffer: &[u8]) {
+/// Decodes a log from the buffer and formats it for display, including the trailing newline.
+pub fn format_log(elf_metadata: &ElfMetadata, buffer: &[u8]) -> String {
     let mut decoder = Decoder::new(&elf_metadata);
     match decoder.decode(buffer) {
-        Ok(log) => {
-            println!(
-                "{timestamp:<12.6} {color}{level:<11}{reset_color}: {msg}",
-                timestamp = log.timestamp,
-                color = color_for_level(log.level),
-                level = log.level.to_string(),
-                reset_color = color::Fg(color::Reset),
-                msg = log.message
-            );
-            println!(
-                "{color}└── File: {file_name}, Line number: {line_number}{reset}",
-                color = color::Fg(color::LightBlack),
-                file_name = log.file_name,
-                line_number = log.line_number,
-                reset = color::Fg(color::Reset)
-            );
-        }
-        Err(error) => {
-            println!(
-                "{color}Error parsing log:{reset_color} {error}.",
-                color = color::Fg(color::Red),
-                error = error,
-                reset_color = color::Fg(color::Reset)
-            );
+        // Trace events and metrics have no call site
+        Ok(log) if log.level == LogLevel::Trace || log.level == LogLevel::Metric => format!(
+            "{timestamp:<12.6} {color}{level:<11}{reset_color}: {msg}\n",
+            timestamp = log.timestamp,
+            color = color_for_level(log.level),
+            level = log.level.to_string(),
+            reset_color = color::Fg(color::Reset),
+            msg = log.message,
+        ),
+        Ok(log) => format!(
+            "{timestamp:<12.6} {color}{level:<11}{reset_color}: {msg}\n\
+             {file_color}└── File: {file_name}, Line number: {line_number}{reset}\n",
+            timestamp = log.timestamp,
+            color = color_for_level(log.level),
+            level = log.level.to_string(),
+            reset_color = color::Fg(color::Reset),
+            msg = log.message,
+            file_color = color::Fg(color::LightBlack),
+            file_name = log.file_name,
+            line_number = log.line_number,
+            reset = color::Fg(color::Reset)
+        ),
+        Err(error) => format!(
+            "{color}Error parsing log:{reset_color} {error}.\n",
+            color = color::Fg(color::Red),
+            error = error,
+            reset_color = color::Fg(color::Reset)
+        ),
+    }
+}
+
+/// Decodes a log from the buffer and prints it to stdout.
+pub fn handle_log(elf_metadata: &ElfMetadata, buffer: &[u8]) {
+    print!("{}", format_log(elf_metadata, buffer));
+}
+
+/// Counters of the `Postform::LoggerStats` declared by the firmware with
+/// `DECLARE_POSTFORM_STATS`.
+#[derive(Debug, Default, PartialEq)]
+pub struct LoggerStats {
+    pub records: u32,
+    pub bytes: u32,
+    pub dropped_busy: u32,
+    pub dropped_full: u32,
+    pub blocked_ticks: u32,
+    pub max_record_ticks: u32,
+    pub buffer_high_water: u32,
+}
+
+impl LoggerStats {
+    /// Number of 32-bit words of the counters, at the start of the struct.
+    const WORDS: usize = 7;
+
+    fn from_words(words: [u32; Self::WORDS]) -> Self {
+        Self {
+            records: words[0],
+            bytes: words[1],
+            dropped_busy: words[2],
+            dropped_full: words[3],
+            blocked_ticks: words[4],
+            max_record_ticks: words[5],
+            buffer_high_water: words[6],
         }
     }
+
+    /// Prints the counters, converting ticks to time with the timestamp frequency of the
+    /// firmware.
+    pub fn print(&self, timestamp_frequency: f64) {
+        println!(
+            "Logger wrote {} records ({} bytes), dropped {} while busy and {} while full",
+            self.records, self.bytes, self.dropped_busy, self.dropped_full
+        );
+        println!(
+            "Logger blocked for {:.6} s, slowest record took {:.1} us, buffer high-water {} bytes",
+            self.blocked_ticks as f64 / timestamp_frequency,
+            self.max_record_ticks as f64 * 1e6 / timestamp_frequency,
+            self.buffer_high_water
+        );
+    }
+}
+
+/// Reads the logger stats of the firmware through the probe, without using RTT bandwidth.
+/// Returns None if the firmware doesn't declare them.
+pub fn read_logger_stats(
+    session: &Arc<Mutex<Session>>,
+    elf_file: &ElfFile,
+) -> Result<Option<LoggerStats>> {
+    let symbol = match elf_file
+        .symbols()
+        .find(|s| s.name().unwrap() == "_postform_stats")
+    {
+        Some(symbol) => symbol,
+        None => return Ok(None),
+    };
+    let mut session_lock = session.lock().unwrap();
+    let mut core = session_lock.core(0)?;
+    let mut words = [0u32; LoggerStats::WORDS];
+    core.read_32(symbol.address() as u32, &mut words)?;
+    Ok(Some(LoggerStats::from_words(words)))
+}
+
+/// Reads the hit counters of the log call sites of the firmware through the probe. Returns None
+/// if the firmware was built without them.
+pub fn read_call_site_hits(
+    session: &Arc<Mutex<Session>>,
+    elf_metadata: &ElfMetadata,
+) -> Result<Option<Vec<CallSiteHits>>> {
+    let (start, end) = match elf_metadata.counters_range() {
+        Some(range) => range,
+        None => return Ok(None),
+    };
+    let mut session_lock = session.lock().unwrap();
+    let mut core = session_lock.core(0)?;
+    let mut data = vec![0u8; (end - start) as usize];
+    core.read_8(start as u32, &mut data)?;
+    let memory = MemoryImage { base: start, data };
+    Ok(Some(elf_metadata.call_site_hits(&memory)?))
 }
 
 /// Attaches to RTT at the address of the `_SEGGER_RTT` symbol
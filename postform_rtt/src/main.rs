@@ -1,9 +1,11 @@
-use cobs::CobsDecoder;
 use color_eyre::eyre::Result;
 use object::read::{File as ElfFile, Object, ObjectSymbol};
-use postform_decoder::{ElfMetadata, POSTFORM_VERSION};
+use postform_decoder::{counters::format_report, ElfMetadata, POSTFORM_VERSION};
 use postform_rtt::{
-    attach_rtt, configure_rtt_mode, disable_cdebugen, download_firmware, handle_log, run_core,
+    attach_rtt, configure_rtt_mode, disable_cdebugen, download_firmware,
+    pipeline::{run_capture, run_pipeline},
+    read_call_site_hits, read_logger_stats, run_core,
+    shm::ShmUpChannel,
     RttError, RttMode,
 };
 use probe_rs::Probe;
@@ -59,7 +61,7 @@ struct Opts {
     list_probes: bool,
 
     /// The chip.
-    #[structopt(long, required_unless_one(&["list-chips", "list-probes", "version"]), env = "PROBE_RUN_CHIP")]
+    #[structopt(long, required_unless_one(&["list-chips", "list-probes", "version", "shm"]), env = "PROBE_RUN_CHIP")]
     chip: Option<String>,
 
     /// Path to an ELF firmware file.
@@ -74,6 +76,49 @@ struct Opts {
 
     #[structopt(long, short)]
     gdb_server: bool,
+
+    /// Record the raw RTT stream to this file instead of decoding it.
+    /// The capture can be decoded later with `postform_persist --capture`.
+    #[structopt(long, parse(from_os_str))]
+    capture: Option<PathBuf>,
+
+    /// Read RTT from the named POSIX shared-memory segment of a host application instead of a
+    /// probe, e.g. `/postform_rtt`.
+    #[structopt(long)]
+    shm: Option<String>,
+
+    /// Read the hit counters of the log call sites through the probe when exiting, and rank the
+    /// call sites by hits and by estimated bytes.
+    #[structopt(long)]
+    counters: bool,
+}
+
+/// Returns a flag that is cleared once the user asks the application to exit.
+fn install_exit_handler() -> Result<Arc<AtomicBool>> {
+    let is_app_running = Arc::new(AtomicBool::new(true));
+    {
+        let is_app_running = is_app_running.clone();
+        ctrlc::set_handler(move || {
+            println!("Exiting application");
+            is_app_running.store(false, Ordering::Relaxed);
+        })?;
+    }
+    Ok(is_app_running)
+}
+
+/// Reads logs from a host application through its shared-memory RTT segment.
+fn run_shm(shm_name: &str, elf_metadata: ElfMetadata, capture: Option<PathBuf>) -> Result<()> {
+    let is_app_running = install_exit_handler()?;
+    let log_channel = ShmUpChannel::attach(shm_name, Duration::from_secs(10))?;
+    println!("Attached to shared-memory segment {}", shm_name);
+    log_channel.configure_mode(RttMode::Blocking);
+
+    let stats = match capture {
+        Some(capture_path) => run_capture(log_channel, &capture_path, is_app_running)?,
+        None => run_pipeline(log_channel, elf_metadata, is_app_running)?,
+    };
+    stats.print_throughput();
+    Ok(())
 }
 
 fn main() -> Result<()> {
@@ -99,6 +144,10 @@ fn main() -> Result<()> {
     let elf_name = opts.elf.unwrap();
     let elf_metadata = ElfMetadata::from_elf_file(&elf_name)?;
 
+    if let Some(shm_name) = opts.shm {
+        return run_shm(&shm_name, elf_metadata, opts.capture);
+    }
+
     let probes = Probe::list_all();
     if probes.len() > 1 {
         println!("More than one probe conected! {:?}", probes);
@@ -116,15 +165,7 @@ fn main() -> Result<()> {
             .find(|s| s.name().unwrap() == "_SEGGER_RTT")
             .ok_or(RttError::MissingSymbol("_SEGGER_RTT"))?;
         let segger_rtt_addr = segger_rtt.address();
-        let is_app_running = Arc::new(AtomicBool::new(true));
-
-        {
-            let is_app_running = is_app_running.clone();
-            ctrlc::set_handler(move || {
-                println!("Exiting application");
-                is_app_running.store(false, Ordering::Relaxed);
-            })?;
-        }
+        let is_app_running = install_exit_handler()?;
         if !opts.attach {
             download_firmware(&session, &elf_name)?;
         }
@@ -149,32 +190,23 @@ fn main() -> Result<()> {
             }));
         }
 
+        let timestamp_frequency = elf_metadata.timestamp_frequency();
         if let Some(log_channel) = rtt.up_channels().take(0) {
-            let mut dec_buf = [0u8; 4096];
-            let mut buf = [0u8; 4096];
-            let mut decoder = CobsDecoder::new(&mut dec_buf);
-            loop {
-                let count = log_channel.read(&mut buf[..])?;
-                for data_byte in buf.iter().take(count) {
-                    match decoder.feed(*data_byte) {
-                        Ok(Some(msg_len)) => {
-                            drop(decoder);
-                            handle_log(&elf_metadata, &dec_buf[..msg_len]);
-                            decoder = CobsDecoder::new(&mut dec_buf[..]);
-                        }
-                        Err(decoded_len) => {
-                            drop(decoder);
-                            println!("Cobs decoding failed after {} bytes", decoded_len);
-                            println!("Decoded buffer: {:?}", &dec_buf[..decoded_len]);
-                            decoder = CobsDecoder::new(&mut dec_buf[..]);
-                        }
-                        Ok(None) => {}
-                    }
-                }
-                if !is_app_running.load(Ordering::Relaxed) {
-                    break;
-                }
-                std::thread::sleep(Duration::from_millis(10));
+            let stats = match opts.capture {
+                Some(capture_path) => run_capture(log_channel, &capture_path, is_app_running)?,
+                None => run_pipeline(log_channel, elf_metadata, is_app_running)?,
+            };
+            stats.print_throughput();
+        }
+        if let Some(logger_stats) = read_logger_stats(&session, &elf_file)? {
+            logger_stats.print(timestamp_frequency);
+        }
+        if opts.counters {
+            // The metadata was handed over to the decoder, load it again
+            let elf_metadata = ElfMetadata::from_elf_file(&elf_name)?;
+            match read_call_site_hits(&session, &elf_metadata)? {
+                Some(mut hits) => print!("{}", format_report(&mut hits, 20)),
+                None => println!("The firmware has no call site counters"),
             }
         }
         if let Some(thread_handle) = gdb_thread_handle {
@@ -0,0 +1,226 @@
+use cobs::CobsDecoder;
+use color_eyre::eyre::Result;
+use postform_decoder::ElfMetadata;
+use probe_rs_rtt::UpChannel;
+use std::fs::File;
+use std::io::{self, Write};
+use std::path::Path;
+use std::sync::{
+    atomic::{AtomicBool, Ordering},
+    mpsc::{self, Receiver, SyncSender, TryRecvError},
+    Arc,
+};
+use std::{
+    thread::{self, JoinHandle},
+    time::{Duration, Instant},
+};
+
+use crate::format_log;
+
+/// Size of a single read from the RTT up channel.
+const READ_CHUNK_SIZE: usize = 4096;
+/// Number of raw chunks buffered between the reader and the decoder.
+const RAW_QUEUE_DEPTH: usize = 1024;
+/// Number of formatted logs buffered between the decoder and the output.
+const LOG_QUEUE_DEPTH: usize = 4096;
+/// Size of the file buffer used in capture mode.
+const CAPTURE_BUFFER_SIZE: usize = 1 << 20;
+/// Initial sleep after the first empty read.
+const MIN_IDLE_BACKOFF: Duration = Duration::from_micros(100);
+/// Maximum sleep between polls while the channel stays empty.
+const MAX_IDLE_BACKOFF: Duration = Duration::from_millis(10);
+
+/// Source of raw data for the reader stage.
+pub trait ChannelReader: Send + 'static {
+    /// Reads as many bytes as available into `buf`, returning the number of bytes read.
+    fn read(&self, buf: &mut [u8]) -> Result<usize>;
+}
+
+impl ChannelReader for UpChannel {
+    fn read(&self, buf: &mut [u8]) -> Result<usize> {
+        Ok(UpChannel::read(self, buf)?)
+    }
+}
+
+/// Statistics collected by the reader stage.
+#[derive(Debug, Default)]
+pub struct ReaderStats {
+    /// Total number of bytes read from the up channel.
+    pub bytes: u64,
+    /// Time elapsed between the first and the last chunk of data.
+    pub active_time: Duration,
+}
+
+/// Statistics collected by the whole pipeline.
+#[derive(Debug, Default)]
+pub struct PipelineStats {
+    pub reader: ReaderStats,
+    /// Number of logs decoded from the stream.
+    pub logs: u64,
+}
+
+impl PipelineStats {
+    /// Prints the sustained throughput achieved while data was flowing.
+    pub fn print_throughput(&self) {
+        let secs = self.reader.active_time.as_secs_f64();
+        if secs == 0.0 {
+            println!("Received {} bytes ({} logs)", self.reader.bytes, self.logs);
+            return;
+        }
+        println!(
+            "Received {} bytes ({} logs) in {:.3} s: {:.1} KiB/s, {:.0} logs/s",
+            self.reader.bytes,
+            self.logs,
+            secs,
+            self.reader.bytes as f64 / 1024.0 / secs,
+            self.logs as f64 / secs
+        );
+    }
+}
+
+/// Spawns the reader stage.
+///
+/// The reader polls the up channel as fast as it can while there is data and backs off
+/// exponentially while it is empty. Chunks are forwarded untouched to the decoder stage. The
+/// queue is bounded: if the host cannot keep up, the reader stops draining the channel and the
+/// target applies backpressure instead of losing data.
+pub fn spawn_reader<C: ChannelReader>(
+    channel: C,
+    is_app_running: Arc<AtomicBool>,
+    sender: SyncSender<Vec<u8>>,
+) -> JoinHandle<Result<ReaderStats>> {
+    thread::spawn(move || {
+        let mut stats = ReaderStats::default();
+        let mut buf = [0u8; READ_CHUNK_SIZE];
+        let mut backoff = MIN_IDLE_BACKOFF;
+        let mut first_data = None;
+
+        while is_app_running.load(Ordering::Relaxed) {
+            let count = channel.read(&mut buf[..])?;
+            if count == 0 {
+                thread::sleep(backoff);
+                backoff = std::cmp::min(backoff * 2, MAX_IDLE_BACKOFF);
+                continue;
+            }
+
+            backoff = MIN_IDLE_BACKOFF;
+            let now = Instant::now();
+            let start = *first_data.get_or_insert(now);
+            stats.active_time = now - start;
+            stats.bytes += count as u64;
+            if sender.send(buf[..count].to_vec()).is_err() {
+                // The decoder is gone, nobody will consume more data.
+                break;
+            }
+        }
+        Ok(stats)
+    })
+}
+
+/// Spawns the decoder stage.
+///
+/// Splits the raw stream into COBS frames and formats each of them as a log. Returns the number
+/// of decoded logs once the reader stage closes its end of the queue.
+pub fn spawn_decoder(
+    elf_metadata: ElfMetadata,
+    receiver: Receiver<Vec<u8>>,
+    sender: SyncSender<String>,
+) -> JoinHandle<u64> {
+    thread::spawn(move || {
+        let mut logs = 0u64;
+        let mut dec_buf = [0u8; READ_CHUNK_SIZE];
+        let mut decoder = CobsDecoder::new(&mut dec_buf);
+
+        for chunk in receiver {
+            for data_byte in chunk {
+                let output = match decoder.feed(data_byte) {
+                    Ok(Some(msg_len)) => {
+                        drop(decoder);
+                        logs += 1;
+                        let log = format_log(&elf_metadata, &dec_buf[..msg_len]);
+                        decoder = CobsDecoder::new(&mut dec_buf[..]);
+                        log
+                    }
+                    Err(decoded_len) => {
+                        drop(decoder);
+                        let log = format!(
+                            "Cobs decoding failed after {} bytes\nDecoded buffer: {:?}\n",
+                            decoded_len,
+                            &dec_buf[..decoded_len]
+                        );
+                        decoder = CobsDecoder::new(&mut dec_buf[..]);
+                        log
+                    }
+                    Ok(None) => continue,
+                };
+                if sender.send(output).is_err() {
+                    return logs;
+                }
+            }
+        }
+        logs
+    })
+}
+
+/// Runs the whole capture pipeline for the given up channel until the application is stopped.
+///
+/// The calling thread becomes the output stage. Output is buffered and only flushed once the
+/// queue of formatted logs runs dry, so terminal I/O never stalls the reader.
+pub fn run_pipeline<C: ChannelReader>(
+    channel: C,
+    elf_metadata: ElfMetadata,
+    is_app_running: Arc<AtomicBool>,
+) -> Result<PipelineStats> {
+    let (raw_sender, raw_receiver) = mpsc::sync_channel(RAW_QUEUE_DEPTH);
+    let (log_sender, log_receiver) = mpsc::sync_channel(LOG_QUEUE_DEPTH);
+
+    let reader = spawn_reader(channel, is_app_running, raw_sender);
+    let decoder = spawn_decoder(elf_metadata, raw_receiver, log_sender);
+
+    // Stdout is not locked for the whole loop, other threads (e.g. the exit handler) may print.
+    let mut out = io::BufWriter::new(io::stdout());
+    loop {
+        let log = match log_receiver.try_recv() {
+            Ok(log) => log,
+            Err(TryRecvError::Empty) => {
+                out.flush()?;
+                match log_receiver.recv() {
+                    Ok(log) => log,
+                    Err(_) => break,
+                }
+            }
+            Err(TryRecvError::Disconnected) => break,
+        };
+        out.write_all(log.as_bytes())?;
+    }
+    out.flush()?;
+
+    let logs = decoder.join().expect("Decoder thread panicked");
+    let reader = reader.join().expect("Reader thread panicked")?;
+    Ok(PipelineStats { reader, logs })
+}
+
+/// Records the raw stream of the given up channel into a file until the application is stopped.
+///
+/// COBS frames are stored untouched, so the capture can be decoded offline with
+/// `postform_persist --capture`. The only processing done is counting frame delimiters, which
+/// keeps the host out of the way of the target even at its full output rate.
+pub fn run_capture<C: ChannelReader>(
+    channel: C,
+    capture_path: &Path,
+    is_app_running: Arc<AtomicBool>,
+) -> Result<PipelineStats> {
+    let (raw_sender, raw_receiver) = mpsc::sync_channel(RAW_QUEUE_DEPTH);
+    let reader = spawn_reader(channel, is_app_running, raw_sender);
+
+    let mut logs = 0u64;
+    let mut out = io::BufWriter::with_capacity(CAPTURE_BUFFER_SIZE, File::create(capture_path)?);
+    for chunk in raw_receiver {
+        logs += chunk.iter().filter(|&&c| c == 0).count() as u64;
+        out.write_all(&chunk)?;
+    }
+    out.flush()?;
+
+    let reader = reader.join().expect("Reader thread panicked")?;
+    Ok(PipelineStats { reader, logs })
+}
@@ -0,0 +1,182 @@
+use crate::pipeline::ChannelReader;
+use crate::RttMode;
+use color_eyre::eyre::Result;
+use std::ffi::CString;
+use std::sync::atomic::{AtomicU32, Ordering};
+use std::time::{Duration, Instant};
+
+/// Magic number stored by libpostform once the segment is initialized ("PFRT").
+const SHM_MAGIC: u32 = 0x5452_4650;
+
+/// Mirror of `Postform::Rtt::ShmDescriptor` in `postform/rtt/shm_segment.h`.
+#[repr(C)]
+struct ShmDescriptor {
+    magic: AtomicU32,
+    segment_size: u32,
+    up_buffer_offset: u32,
+    up_buffer_size: u32,
+    up_write_offset: u32,
+    up_read_offset: u32,
+    up_flags_offset: u32,
+}
+
+/// Errors attaching to the shared-memory RTT segment
+#[derive(Debug, thiserror::Error)]
+pub enum ShmError {
+    #[error("Unable to open shared-memory segment {0}: {1}")]
+    OpenFailed(String, std::io::Error),
+    #[error("Unable to map shared-memory segment {0}: {1}")]
+    MapFailed(String, std::io::Error),
+    #[error("Shared-memory segment {0} was not initialized in time")]
+    NotInitialized(String),
+    #[error("Shared-memory segment {0} has an invalid layout")]
+    InvalidLayout(String),
+}
+
+/// Up channel of an RTT control block placed in POSIX shared memory by a host application
+/// linked against `libpostform_host`.
+pub struct ShmUpChannel {
+    base: *mut u8,
+    mapping_size: usize,
+    buffer: *const u8,
+    size: u32,
+    write: *const AtomicU32,
+    read: *const AtomicU32,
+    flags: *const AtomicU32,
+}
+
+// The channel only touches the shared memory through atomics and a single reader is allowed,
+// as with the probe-based channel.
+unsafe impl Send for ShmUpChannel {}
+
+impl ShmUpChannel {
+    /// Attaches to the named segment, waiting up to `timeout` for the writer to initialize it.
+    pub fn attach(name: &str, timeout: Duration) -> Result<Self> {
+        let c_name = CString::new(name)?;
+        let start = Instant::now();
+        loop {
+            match Self::try_attach(name, &c_name) {
+                Ok(Some(channel)) => return Ok(channel),
+                Ok(None) | Err(ShmError::OpenFailed(..)) if start.elapsed() < timeout => {
+                    std::thread::sleep(Duration::from_millis(10));
+                }
+                Ok(None) => return Err(ShmError::NotInitialized(name.to_owned()).into()),
+                Err(e) => return Err(e.into()),
+            }
+        }
+    }
+
+    fn try_attach(name: &str, c_name: &CString) -> Result<Option<Self>, ShmError> {
+        let fd = unsafe { libc::shm_open(c_name.as_ptr(), libc::O_RDWR, 0) };
+        if fd < 0 {
+            return Err(ShmError::OpenFailed(
+                name.to_owned(),
+                std::io::Error::last_os_error(),
+            ));
+        }
+
+        let mut stat: libc::stat = unsafe { std::mem::zeroed() };
+        let mapping_size = if unsafe { libc::fstat(fd, &mut stat) } == 0 {
+            stat.st_size as usize
+        } else {
+            0
+        };
+        if mapping_size < std::mem::size_of::<ShmDescriptor>() {
+            unsafe { libc::close(fd) };
+            return Ok(None);
+        }
+
+        let base = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                mapping_size,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_SHARED,
+                fd,
+                0,
+            )
+        };
+        unsafe { libc::close(fd) };
+        if base == libc::MAP_FAILED {
+            return Err(ShmError::MapFailed(
+                name.to_owned(),
+                std::io::Error::last_os_error(),
+            ));
+        }
+        let base = base as *mut u8;
+
+        let descriptor = unsafe { &*(base as *const ShmDescriptor) };
+        if descriptor.magic.load(Ordering::Acquire) != SHM_MAGIC {
+            unsafe { libc::munmap(base as *mut libc::c_void, mapping_size) };
+            return Ok(None);
+        }
+
+        let fits = |offset: u32, len: u32| offset as usize + len as usize <= mapping_size;
+        let word = std::mem::size_of::<u32>() as u32;
+        if descriptor.segment_size as usize > mapping_size
+            || !fits(descriptor.up_buffer_offset, descriptor.up_buffer_size)
+            || !fits(descriptor.up_write_offset, word)
+            || !fits(descriptor.up_read_offset, word)
+            || !fits(descriptor.up_flags_offset, word)
+        {
+            unsafe { libc::munmap(base as *mut libc::c_void, mapping_size) };
+            return Err(ShmError::InvalidLayout(name.to_owned()));
+        }
+
+        let at = |offset: u32| unsafe { base.add(offset as usize) };
+        Ok(Some(Self {
+            base,
+            mapping_size,
+            buffer: at(descriptor.up_buffer_offset),
+            size: descriptor.up_buffer_size,
+            write: at(descriptor.up_write_offset) as *const AtomicU32,
+            read: at(descriptor.up_read_offset) as *const AtomicU32,
+            flags: at(descriptor.up_flags_offset) as *const AtomicU32,
+        }))
+    }
+
+    /// Configures the RTT mode of the writer, equivalent to `configure_rtt_mode` for a probe.
+    pub fn configure_mode(&self, mode: RttMode) {
+        println!("Setting mode to {:?}", mode);
+        unsafe { &*self.flags }.store(mode as u32, Ordering::Relaxed);
+    }
+}
+
+impl ChannelReader for ShmUpChannel {
+    fn read(&self, buf: &mut [u8]) -> Result<usize> {
+        let (write, read) = unsafe { (&*self.write, &*self.read) };
+        let write_ptr = write.load(Ordering::Acquire) as usize;
+        let mut read_ptr = read.load(Ordering::Relaxed) as usize;
+        let size = self.size as usize;
+        if write_ptr >= size || read_ptr >= size {
+            return Ok(0);
+        }
+
+        let mut count = 0;
+        while read_ptr != write_ptr && count < buf.len() {
+            let end = if write_ptr > read_ptr {
+                write_ptr
+            } else {
+                size
+            };
+            let chunk = std::cmp::min(end - read_ptr, buf.len() - count);
+            let src = unsafe { std::slice::from_raw_parts(self.buffer.add(read_ptr), chunk) };
+            buf[count..count + chunk].copy_from_slice(src);
+            count += chunk;
+            read_ptr += chunk;
+            if read_ptr == size {
+                read_ptr = 0;
+            }
+        }
+        read.store(read_ptr as u32, Ordering::Release);
+        Ok(count)
+    }
+}
+
+impl Drop for ShmUpChannel {
+    fn drop(&mut self) {
+        // Never leave the writer blocked on a reader that is gone.
+        unsafe { &*self.flags }.store(RttMode::NonBlocking as u32, Ordering::Relaxed);
+        unsafe { libc::munmap(self.base as *mut libc::c_void, self.mapping_size) };
+    }
+}
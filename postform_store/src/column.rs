@@ -0,0 +1,355 @@
+//! Block encoding of the columns of the store.
+//!
+//! Columns are sequences of blocks of at most `BLOCK_SIZE` values. Every column of a partition
+//! splits its rows at the same points, so block N of any column holds the same rows.
+//!
+//! Integer blocks store their first value followed by the differences between consecutive
+//! values, zigzag encoded and bit-packed with the smallest width that fits all of them. Their
+//! header also holds the minimum and maximum value, so queries can skip whole blocks without
+//! unpacking them. String blocks store a dictionary of their distinct values and the bit-packed
+//! index of the value of every row.
+//!
+//! All values are little endian.
+
+use std::collections::HashMap;
+use std::convert::TryInto;
+use std::io::{self, Read, Write};
+
+/// Maximum number of values in a block.
+pub const BLOCK_SIZE: usize = 1024;
+
+/// Size of the header of an integer block: count, packed length, min, max, first and width.
+const INTEGER_HEADER_SIZE: usize = 4 + 4 + 8 + 8 + 8 + 1;
+/// Size of the header of a string block: count and data length.
+const STRING_HEADER_SIZE: usize = 4 + 4;
+
+fn zigzag(value: i64) -> u64 {
+    ((value << 1) ^ (value >> 63)) as u64
+}
+
+fn unzigzag(value: u64) -> i64 {
+    ((value >> 1) as i64) ^ -((value & 1) as i64)
+}
+
+/// Bit-packs the values with `width` bits each, least significant bits first.
+fn pack(values: &[u64], width: u8) -> Vec<u8> {
+    let mut packed = vec![];
+    let mut accumulator = 0u128;
+    let mut bits = 0;
+    for &value in values {
+        accumulator |= (value as u128) << bits;
+        bits += width as u32;
+        while bits >= 8 {
+            packed.push(accumulator as u8);
+            accumulator >>= 8;
+            bits -= 8;
+        }
+    }
+    if bits > 0 {
+        packed.push(accumulator as u8);
+    }
+    packed
+}
+
+/// Unpacks `count` values of `width` bits each.
+fn unpack(packed: &[u8], width: u8, count: usize) -> io::Result<Vec<u64>> {
+    let mask = if width == 64 {
+        u64::MAX
+    } else {
+        (1u64 << width) - 1
+    };
+    let mut values = Vec::with_capacity(count);
+    let mut bytes = packed.iter();
+    let mut accumulator = 0u128;
+    let mut bits = 0u32;
+    for _ in 0..count {
+        while bits < width as u32 {
+            let byte = *bytes.next().ok_or_else(|| corrupted("Truncated block"))?;
+            accumulator |= (byte as u128) << bits;
+            bits += 8;
+        }
+        values.push((accumulator as u64) & mask);
+        accumulator >>= width;
+        bits -= width as u32;
+    }
+    Ok(values)
+}
+
+/// Number of bits needed to store the value.
+fn bit_width(value: u64) -> u8 {
+    (64 - value.leading_zeros()) as u8
+}
+
+/// Header of an integer block.
+#[derive(Copy, Clone, Debug, PartialEq)]
+pub struct IntegerBlockHeader {
+    pub count: u32,
+    packed_len: u32,
+    /// Minimum value of the block, as signed or unsigned depending on the column.
+    pub min: u64,
+    /// Maximum value of the block, as signed or unsigned depending on the column.
+    pub max: u64,
+    first: u64,
+    width: u8,
+}
+
+/// Encodes an integer block.
+///
+/// `signed` selects whether values are compared as i64 or as u64 for the block min/max.
+pub fn write_integer_block(
+    output: &mut impl Write,
+    values: &[u64],
+    signed: bool,
+) -> io::Result<()> {
+    let (min, max) = if signed {
+        let signed_values = values.iter().map(|&value| value as i64);
+        (
+            signed_values.clone().min().unwrap_or(0) as u64,
+            signed_values.max().unwrap_or(0) as u64,
+        )
+    } else {
+        (
+            values.iter().copied().min().unwrap_or(0),
+            values.iter().copied().max().unwrap_or(0),
+        )
+    };
+
+    let deltas: Vec<u64> = values
+        .windows(2)
+        .map(|pair| zigzag(pair[1].wrapping_sub(pair[0]) as i64))
+        .collect();
+    let width = deltas.iter().copied().map(bit_width).max().unwrap_or(0);
+
+    let packed = pack(&deltas, width);
+
+    output.write_all(&(values.len() as u32).to_le_bytes())?;
+    output.write_all(&(packed.len() as u32).to_le_bytes())?;
+    output.write_all(&min.to_le_bytes())?;
+    output.write_all(&max.to_le_bytes())?;
+    output.write_all(&values.first().copied().unwrap_or(0).to_le_bytes())?;
+    output.write_all(&[width])?;
+    output.write_all(&packed)
+}
+
+/// Reads the header of the next integer block, or None at the end of the column.
+pub fn read_integer_header(input: &mut impl Read) -> io::Result<Option<IntegerBlockHeader>> {
+    let mut header = [0u8; INTEGER_HEADER_SIZE];
+    if !read_exact_or_eof(input, &mut header)? {
+        return Ok(None);
+    }
+    let u32_at = |pos: usize| u32::from_le_bytes(header[pos..pos + 4].try_into().unwrap());
+    let u64_at = |pos: usize| u64::from_le_bytes(header[pos..pos + 8].try_into().unwrap());
+    Ok(Some(IntegerBlockHeader {
+        count: u32_at(0),
+        packed_len: u32_at(4),
+        min: u64_at(8),
+        max: u64_at(16),
+        first: u64_at(24),
+        width: header[32],
+    }))
+}
+
+/// Skips the data of the block whose header was just read.
+pub fn skip_integer_block(input: &mut impl Read, header: &IntegerBlockHeader) -> io::Result<()> {
+    skip(input, header.packed_len as u64)
+}
+
+/// Decodes the values of the block whose header was just read.
+pub fn read_integer_block(
+    input: &mut impl Read,
+    header: &IntegerBlockHeader,
+) -> io::Result<Vec<u64>> {
+    let mut packed = vec![0u8; header.packed_len as usize];
+    input.read_exact(&mut packed)?;
+
+    let mut values = Vec::with_capacity(header.count as usize);
+    if header.count == 0 {
+        return Ok(values);
+    }
+    values.push(header.first);
+
+    let mut value = header.first;
+    for delta in unpack(&packed, header.width, header.count as usize - 1)? {
+        value = value.wrapping_add(unzigzag(delta) as u64);
+        values.push(value);
+    }
+    Ok(values)
+}
+
+/// Encodes a string block.
+///
+/// Logs of a call site tend to repeat the same few strings (interned strings always do), so the
+/// block stores each distinct value once, followed by the bit-packed index of the value of every
+/// row. The data of the block is:
+///
+/// * number of distinct values (u32), then each of them as its length (u32) and UTF-8 bytes.
+/// * width of the indices (u8) and the packed indices.
+pub fn write_string_block(output: &mut impl Write, values: &[String]) -> io::Result<()> {
+    let mut dictionary: Vec<&str> = vec![];
+    let mut positions: HashMap<&str, u64> = HashMap::new();
+    let indices: Vec<u64> = values
+        .iter()
+        .map(|value| {
+            *positions.entry(value.as_str()).or_insert_with(|| {
+                dictionary.push(value);
+                dictionary.len() as u64 - 1
+            })
+        })
+        .collect();
+    let width = bit_width(dictionary.len().saturating_sub(1) as u64);
+
+    let mut data = vec![];
+    data.extend_from_slice(&(dictionary.len() as u32).to_le_bytes());
+    for value in &dictionary {
+        data.extend_from_slice(&(value.len() as u32).to_le_bytes());
+        data.extend_from_slice(value.as_bytes());
+    }
+    data.push(width);
+    data.extend_from_slice(&pack(&indices, width));
+
+    output.write_all(&(values.len() as u32).to_le_bytes())?;
+    output.write_all(&(data.len() as u32).to_le_bytes())?;
+    output.write_all(&data)
+}
+
+/// Reads the next string block, or None at the end of the column. Returns the values only if
+/// `decode` is set, otherwise the block is skipped.
+pub fn read_string_block(input: &mut impl Read, decode: bool) -> io::Result<Option<Vec<String>>> {
+    let mut header = [0u8; STRING_HEADER_SIZE];
+    if !read_exact_or_eof(input, &mut header)? {
+        return Ok(None);
+    }
+    let count = u32::from_le_bytes(header[0..4].try_into().unwrap());
+    let data_len = u32::from_le_bytes(header[4..8].try_into().unwrap());
+    if !decode {
+        skip(input, data_len as u64)?;
+        return Ok(Some(vec![]));
+    }
+
+    let mut data = vec![0u8; data_len as usize];
+    input.read_exact(&mut data)?;
+    let truncated = || corrupted("Truncated string block");
+    let read_u32 = |rest: &mut &[u8]| -> io::Result<usize> {
+        let bytes = rest.get(..4).ok_or_else(truncated)?;
+        *rest = &rest[4..];
+        Ok(u32::from_le_bytes(bytes.try_into().unwrap()) as usize)
+    };
+
+    let mut rest = &data[..];
+    let dictionary_len = read_u32(&mut rest)?;
+    let mut dictionary = Vec::with_capacity(dictionary_len);
+    for _ in 0..dictionary_len {
+        let len = read_u32(&mut rest)?;
+        let value = rest.get(..len).ok_or_else(truncated)?;
+        dictionary.push(String::from_utf8_lossy(value).to_string());
+        rest = &rest[len..];
+    }
+    let width = *rest.first().ok_or_else(truncated)?;
+
+    unpack(&rest[1..], width, count as usize)?
+        .into_iter()
+        .map(|index| {
+            dictionary
+                .get(index as usize)
+                .cloned()
+                .ok_or_else(|| corrupted("Invalid string index"))
+        })
+        .collect::<io::Result<Vec<_>>>()
+        .map(Some)
+}
+
+fn corrupted(msg: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, msg)
+}
+
+fn skip(input: &mut impl Read, len: u64) -> io::Result<()> {
+    let skipped = io::copy(&mut input.take(len), &mut io::sink())?;
+    if skipped != len {
+        return Err(corrupted("Truncated block"));
+    }
+    Ok(())
+}
+
+/// Fills the buffer, returning false if the input was already at its end.
+fn read_exact_or_eof(input: &mut impl Read, buffer: &mut [u8]) -> io::Result<bool> {
+    let mut filled = 0;
+    while filled < buffer.len() {
+        match input.read(&mut buffer[filled..]) {
+            Ok(0) if filled == 0 => return Ok(false),
+            Ok(0) => return Err(corrupted("Truncated block header")),
+            Ok(count) => filled += count,
+            Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+            Err(e) => return Err(e),
+        }
+    }
+    Ok(true)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn round_trip(values: &[u64], signed: bool) -> (IntegerBlockHeader, Vec<u64>, usize) {
+        let mut encoded = vec![];
+        write_integer_block(&mut encoded, values, signed).unwrap();
+        let mut input = &encoded[..];
+        let header = read_integer_header(&mut input).unwrap().unwrap();
+        let decoded = read_integer_block(&mut input, &header).unwrap();
+        assert!(input.is_empty());
+        assert!(read_integer_header(&mut input).unwrap().is_none());
+        (header, decoded, encoded.len())
+    }
+
+    #[test]
+    fn test_integer_block_round_trip() {
+        let values: Vec<u64> = (0..BLOCK_SIZE as u64).map(|i| 1_000_000 + i * 3).collect();
+        let (header, decoded, len) = round_trip(&values, false);
+        assert_eq!(decoded, values);
+        assert_eq!(header.min, 1_000_000);
+        assert_eq!(header.max, 1_000_000 + 3 * 1023);
+        // Constant deltas of 3 only need 3 bits each
+        assert_eq!(len, INTEGER_HEADER_SIZE + (1023 * 3 + 7) / 8);
+    }
+
+    #[test]
+    fn test_signed_integer_block() {
+        let values: Vec<u64> = [5i64, -7, i64::MIN, i64::MAX, 0]
+            .iter()
+            .map(|&v| v as u64)
+            .collect();
+        let (header, decoded, _) = round_trip(&values, true);
+        assert_eq!(decoded, values);
+        assert_eq!(header.min as i64, i64::MIN);
+        assert_eq!(header.max as i64, i64::MAX);
+    }
+
+    #[test]
+    fn test_single_value_block() {
+        let (header, decoded, len) = round_trip(&[42], false);
+        assert_eq!(decoded, vec![42]);
+        assert_eq!(header.count, 1);
+        assert_eq!(len, INTEGER_HEADER_SIZE);
+    }
+
+    #[test]
+    fn test_string_block() {
+        let values = vec![
+            "a".to_owned(),
+            String::new(),
+            "hello".to_owned(),
+            "a".to_owned(),
+        ];
+        let mut encoded = vec![];
+        write_string_block(&mut encoded, &values).unwrap();
+        write_string_block(&mut encoded, &values[..1]).unwrap();
+        write_string_block(&mut encoded, &values).unwrap();
+        let mut input = &encoded[..];
+        assert_eq!(read_string_block(&mut input, false).unwrap(), Some(vec![]));
+        assert_eq!(
+            read_string_block(&mut input, true).unwrap(),
+            Some(vec!["a".to_owned()])
+        );
+        assert_eq!(read_string_block(&mut input, true).unwrap(), Some(values));
+        assert_eq!(read_string_block(&mut input, true).unwrap(), None);
+    }
+}
@@ -0,0 +1,212 @@
+use color_eyre::eyre::eyre;
+use color_eyre::eyre::Result;
+use postform_decoder::{build_id, format_hex, Argument, Decoder, ElfMetadata};
+use postform_persist::{receive_stream, Framing};
+use postform_store::store::{PartitionMeta, Query, Store, StoreWriter};
+use std::io::{self, Write};
+use std::{fs, path::PathBuf};
+use structopt::StructOpt;
+
+#[derive(Debug, StructOpt)]
+#[structopt()]
+enum Opts {
+    /// Decodes a binary log file and appends its logs to a store.
+    Ingest {
+        /// Directory of the store. Created if it doesn't exist.
+        #[structopt(name = "STORE", parse(from_os_str))]
+        store: PathBuf,
+
+        /// Path to the ELF firmware file that produced the logs.
+        #[structopt(name = "ELF", parse(from_os_str))]
+        elf: PathBuf,
+
+        /// Path to the binary log file.
+        #[structopt(name = "LOG_FILE", parse(from_os_str))]
+        log_file: PathBuf,
+
+        /// Read a raw RTT capture recorded with `postform_rtt --capture` instead of a
+        /// `FileLogger` log.
+        #[structopt(long)]
+        capture: bool,
+    },
+    /// Lists the call sites in a store.
+    List {
+        #[structopt(name = "STORE", parse(from_os_str))]
+        store: PathBuf,
+    },
+    /// Prints the timestamp and value of an argument of every log of a call site.
+    Query {
+        #[structopt(name = "STORE", parse(from_os_str))]
+        store: PathBuf,
+
+        /// Call site as `FILE:LINE`. The file only needs to be a suffix of the file name.
+        #[structopt(long, required_unless("format-id"))]
+        site: Option<String>,
+
+        /// Format ID of the call site, as shown by `list`.
+        #[structopt(long, conflicts_with("site"))]
+        format_id: Option<usize>,
+
+        /// Index of the argument to print, starting at 0.
+        #[structopt(long)]
+        arg: usize,
+
+        /// Only print logs at or after this time, in seconds.
+        #[structopt(long)]
+        from: Option<f64>,
+
+        /// Only print logs at or before this time, in seconds.
+        #[structopt(long)]
+        to: Option<f64>,
+
+        /// Only print values greater or equal than this one. Integer arguments only.
+        #[structopt(long, allow_hyphen_values(true))]
+        min: Option<i128>,
+
+        /// Only print values lower or equal than this one. Integer arguments only.
+        #[structopt(long, allow_hyphen_values(true))]
+        max: Option<i128>,
+    },
+}
+
+fn ingest(store: PathBuf, elf: PathBuf, log_file: PathBuf, capture: bool) -> Result<()> {
+    let elf_data = fs::read(&elf)?;
+    let elf_metadata = ElfMetadata::from_elf_data(&elf_data)?;
+    let mut writer = StoreWriter::open(&store, &build_id(&elf_data)?)?;
+    let framing = if capture {
+        Framing::Cobs
+    } else {
+        Framing::LengthPrefixed
+    };
+
+    let mut result = Ok(());
+    receive_stream(fs::File::open(log_file)?, framing, |record: &[u8]| {
+        if result.is_err() {
+            return;
+        }
+        match Decoder::new(&elf_metadata).decode(record) {
+            Ok(log) => result = writer.append(&log),
+            Err(error) => eprintln!("Error parsing log: {}.", error),
+        }
+    })?;
+    result?;
+    writer.finish()?;
+    Ok(())
+}
+
+fn list(store: PathBuf) -> Result<()> {
+    let stdout = io::stdout();
+    let mut output = stdout.lock();
+    for meta in Store::open(&store).partitions()? {
+        writeln!(
+            output,
+            "{:>8} {:>10} {:<7} {}:{} \"{}\"",
+            meta.format_id, meta.rows, meta.level, meta.file, meta.line, meta.format
+        )?;
+    }
+    Ok(())
+}
+
+fn find_partition(
+    store: &Store,
+    site: Option<String>,
+    format_id: Option<usize>,
+) -> Result<PartitionMeta> {
+    let partitions = store.partitions()?;
+    let mut matching: Vec<_> = match (site, format_id) {
+        (_, Some(format_id)) => partitions
+            .into_iter()
+            .filter(|meta| meta.format_id == format_id)
+            .collect(),
+        (Some(site), None) => {
+            let (file, line) = site
+                .rsplit_once(':')
+                .and_then(|(file, line)| Some((file.to_owned(), line.parse::<u32>().ok()?)))
+                .ok_or_else(|| eyre!("Invalid call site {}, expected FILE:LINE", site))?;
+            partitions
+                .into_iter()
+                .filter(|meta| meta.line == line && meta.file.ends_with(&file))
+                .collect()
+        }
+        (None, None) => unreachable!("structopt requires a site or a format ID"),
+    };
+    match matching.len() {
+        0 => Err(eyre!("No logs in the store match the call site")),
+        1 => Ok(matching.remove(0)),
+        _ => Err(eyre!(
+            "Several call sites match, select one with --format-id: {:?}",
+            matching
+                .iter()
+                .map(|meta| (meta.format_id, &meta.format))
+                .collect::<Vec<_>>()
+        )),
+    }
+}
+
+fn to_nanoseconds(seconds: f64) -> u64 {
+    (seconds * 1_000_000_000f64).round().max(0f64) as u64
+}
+
+fn main() -> Result<()> {
+    color_eyre::install()?;
+
+    match Opts::from_args() {
+        Opts::Ingest {
+            store,
+            elf,
+            log_file,
+            capture,
+        } => ingest(store, elf, log_file, capture),
+        Opts::List { store } => list(store),
+        Opts::Query {
+            store,
+            site,
+            format_id,
+            arg,
+            from,
+            to,
+            min,
+            max,
+        } => {
+            let store = Store::open(&store);
+            let meta = find_partition(&store, site, format_id)?;
+            let query = Query {
+                column: arg,
+                from: from.map(to_nanoseconds),
+                to: to.map(to_nanoseconds),
+                min,
+                max,
+            };
+
+            let stdout = io::stdout();
+            let mut output = io::BufWriter::new(stdout.lock());
+            for (timestamp, value) in store.query(&meta, &query)? {
+                let timestamp = timestamp as f64 / 1_000_000_000f64;
+                match value {
+                    Argument::Signed(value) => writeln!(output, "{:.9} {}", timestamp, value)?,
+                    Argument::Unsigned(value) => writeln!(output, "{:.9} {}", timestamp, value)?,
+                    Argument::Pointer(value) => writeln!(output, "{:.9} {:#x}", timestamp, value)?,
+                    Argument::Float(value) => writeln!(output, "{:.9} {}", timestamp, value)?,
+                    Argument::Bytes(value) => {
+                        writeln!(output, "{:.9} {}", timestamp, format_hex(&value))?
+                    }
+                    Argument::String(value) | Argument::InternedString(value) => {
+                        writeln!(output, "{:.9} {}", timestamp, value)?
+                    }
+                    Argument::SignedArray(values) => {
+                        writeln!(output, "{:.9} {:?}", timestamp, values)?
+                    }
+                    Argument::UnsignedArray(values) => {
+                        writeln!(output, "{:.9} {:?}", timestamp, values)?
+                    }
+                    Argument::Enum {
+                        name: Some(name), ..
+                    } => writeln!(output, "{:.9} {}", timestamp, name)?,
+                    Argument::Enum { value, .. } => writeln!(output, "{:.9} {}", timestamp, value)?,
+                }
+            }
+            output.flush()?;
+            Ok(())
+        }
+    }
+}
@@ -0,0 +1,717 @@
+//! On-disk store of logs partitioned by format ID.
+//!
+//! A store is a directory holding the build ID of the firmware its logs come from, and one
+//! directory per format ID. Each partition directory contains `meta.json`, describing the call
+//! site and the types of its columns, a `timestamps` column with the time of every log in
+//! nanoseconds, and an `argN` column for each argument. Columns are encoded as described in
+//! the `column` module.
+
+use crate::column::{
+    read_integer_block, read_integer_header, read_string_block, skip_integer_block,
+    write_integer_block, write_string_block, BLOCK_SIZE,
+};
+use postform_decoder::{format_hex, Argument, Log};
+use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
+use std::fs::{self, File, OpenOptions};
+use std::io::{self, BufReader, BufWriter, Write};
+use std::path::{Path, PathBuf};
+
+const BUILD_ID_FILE: &str = "build_id";
+const META_FILE: &str = "meta.json";
+const TIMESTAMPS_FILE: &str = "timestamps";
+
+/// Errors of the store
+#[derive(Debug, thiserror::Error)]
+pub enum StoreError {
+    #[error("Store IO error")]
+    IoError {
+        #[from]
+        #[source]
+        io_err: io::Error,
+    },
+    #[error("Invalid partition metadata")]
+    InvalidMetadata {
+        #[from]
+        #[source]
+        source: serde_json::Error,
+    },
+    #[error("Store holds logs of build {0}, not {1}")]
+    MismatchedBuild(String, String),
+    #[error("Arguments of format ID {0} do not match the columns of its partition")]
+    MismatchedColumns(usize),
+    #[error("Format ID {0} has no argument {1}")]
+    MissingColumn(usize, usize),
+}
+
+/// Type of the values of a column.
+#[derive(Copy, Clone, Debug, PartialEq, Serialize, Deserialize)]
+#[serde(rename_all = "snake_case")]
+pub enum ColumnType {
+    Signed,
+    Unsigned,
+    Pointer,
+    String,
+    InternedString,
+    Float,
+    /// Binary buffers, stored as hex strings.
+    Bytes,
+    /// Arrays of integers, stored as strings of comma separated elements.
+    SignedArray,
+    UnsignedArray,
+    /// Enums, stored as strings of their value followed by the name of their enumerator if it is
+    /// known, separated by a space.
+    Enum,
+}
+
+/// Formats the elements of an array for a string column.
+fn join_elements<T: ToString>(values: &[T]) -> String {
+    values
+        .iter()
+        .map(ToString::to_string)
+        .collect::<Vec<_>>()
+        .join(",")
+}
+
+fn split_elements<T: std::str::FromStr>(value: &str) -> Vec<T> {
+    value
+        .split(',')
+        .filter_map(|element| element.parse().ok())
+        .collect()
+}
+
+/// Formats an enum for a string column.
+fn join_enum(value: i64, name: Option<&str>) -> String {
+    match name {
+        Some(name) => format!("{} {}", value, name),
+        None => value.to_string(),
+    }
+}
+
+fn split_enum(value: &str) -> Argument {
+    let (value, name) = match value.split_once(' ') {
+        Some((value, name)) => (value, Some(name.to_owned())),
+        None => (value, None),
+    };
+    Argument::Enum {
+        value: value.parse().unwrap_or_default(),
+        name,
+    }
+}
+
+const SIGN_BIT: u64 = 1 << 63;
+
+/// Maps a float to an integer with the same order, so that the min/max of its blocks can be
+/// compared as unsigned integers.
+fn float_to_ordered(value: f64) -> u64 {
+    let bits = value.to_bits();
+    if bits & SIGN_BIT != 0 {
+        !bits
+    } else {
+        bits | SIGN_BIT
+    }
+}
+
+fn ordered_to_float(raw: u64) -> f64 {
+    let bits = if raw & SIGN_BIT != 0 {
+        raw & !SIGN_BIT
+    } else {
+        !raw
+    };
+    f64::from_bits(bits)
+}
+
+impl ColumnType {
+    fn of(argument: &Argument) -> Self {
+        match argument {
+            Argument::Signed(_) => ColumnType::Signed,
+            Argument::Unsigned(_) => ColumnType::Unsigned,
+            Argument::Pointer(_) => ColumnType::Pointer,
+            Argument::String(_) => ColumnType::String,
+            Argument::InternedString(_) => ColumnType::InternedString,
+            Argument::Float(_) => ColumnType::Float,
+            Argument::Bytes(_) => ColumnType::Bytes,
+            Argument::SignedArray(_) => ColumnType::SignedArray,
+            Argument::UnsignedArray(_) => ColumnType::UnsignedArray,
+            Argument::Enum { .. } => ColumnType::Enum,
+        }
+    }
+
+    fn is_integer(self) -> bool {
+        !matches!(
+            self,
+            ColumnType::String
+                | ColumnType::InternedString
+                | ColumnType::Bytes
+                | ColumnType::SignedArray
+                | ColumnType::UnsignedArray
+                | ColumnType::Enum
+        )
+    }
+
+    /// Converts a raw integer value of the column to a comparable number. Floats are rounded
+    /// down.
+    fn to_number(self, raw: u64) -> i128 {
+        match self {
+            ColumnType::Signed => raw as i64 as i128,
+            ColumnType::Float => ordered_to_float(raw).floor() as i128,
+            _ => raw as i128,
+        }
+    }
+
+    fn to_argument(self, raw: u64) -> Argument {
+        match self {
+            ColumnType::Signed => Argument::Signed(raw as i64),
+            ColumnType::Pointer => Argument::Pointer(raw),
+            ColumnType::Float => Argument::Float(ordered_to_float(raw)),
+            _ => Argument::Unsigned(raw),
+        }
+    }
+
+    fn string_argument(self, value: String) -> Argument {
+        match self {
+            ColumnType::InternedString => Argument::InternedString(value),
+            ColumnType::Bytes => Argument::Bytes(
+                value
+                    .as_bytes()
+                    .chunks(2)
+                    .filter_map(|digits| {
+                        u8::from_str_radix(std::str::from_utf8(digits).ok()?, 16).ok()
+                    })
+                    .collect(),
+            ),
+            ColumnType::SignedArray => Argument::SignedArray(split_elements(&value)),
+            ColumnType::UnsignedArray => Argument::UnsignedArray(split_elements(&value)),
+            ColumnType::Enum => split_enum(&value),
+            _ => Argument::String(value),
+        }
+    }
+}
+
+/// Description of a partition, stored in its `meta.json`.
+#[derive(Clone, Debug, Serialize, Deserialize)]
+pub struct PartitionMeta {
+    pub format_id: usize,
+    pub level: String,
+    pub file: String,
+    pub line: u32,
+    pub format: String,
+    pub columns: Vec<ColumnType>,
+    pub rows: u64,
+    /// Size in bytes of the timestamps file and of every column file holding the rows.
+    /// Anything after it was written by an ingestion that didn't finish and is discarded.
+    #[serde(default)]
+    pub sizes: Vec<u64>,
+}
+
+fn column_file(index: usize) -> String {
+    format!("arg{}", index)
+}
+
+enum ColumnBuffer {
+    Integers(Vec<u64>),
+    Strings(Vec<String>),
+}
+
+struct PartitionWriter {
+    dir: PathBuf,
+    meta: PartitionMeta,
+    timestamps: Vec<u64>,
+    buffers: Vec<ColumnBuffer>,
+    /// The timestamps column followed by every argument column.
+    files: Vec<BufWriter<File>>,
+}
+
+impl PartitionWriter {
+    fn open(root: &Path, log: &Log) -> Result<Self, StoreError> {
+        let dir = root.join(log.format_id.to_string());
+        let columns: Vec<_> = log.arguments.iter().map(ColumnType::of).collect();
+        let meta = match fs::read(dir.join(META_FILE)) {
+            Ok(meta) => {
+                let meta: PartitionMeta = serde_json::from_slice(&meta)?;
+                if meta.columns != columns {
+                    return Err(StoreError::MismatchedColumns(log.format_id));
+                }
+                meta
+            }
+            Err(e) if e.kind() == io::ErrorKind::NotFound => {
+                fs::create_dir_all(&dir)?;
+                PartitionMeta {
+                    format_id: log.format_id,
+                    level: log.level.to_string(),
+                    file: log.file_name.clone(),
+                    line: log.line_number,
+                    format: log.format.clone(),
+                    columns,
+                    rows: 0,
+                    sizes: vec![],
+                }
+            }
+            Err(e) => return Err(e.into()),
+        };
+
+        let open = |index: usize, name: &str| -> io::Result<BufWriter<File>> {
+            let file = OpenOptions::new()
+                .create(true)
+                .append(true)
+                .open(dir.join(name))?;
+            // Stores written before the sizes were recorded are kept as they are
+            if let Some(&size) = meta.sizes.get(index) {
+                file.set_len(size)?;
+            }
+            Ok(BufWriter::new(file))
+        };
+        let mut files = vec![open(0, TIMESTAMPS_FILE)?];
+        for index in 0..meta.columns.len() {
+            files.push(open(index + 1, &column_file(index))?);
+        }
+        let buffers = meta
+            .columns
+            .iter()
+            .map(|column| {
+                if column.is_integer() {
+                    ColumnBuffer::Integers(vec![])
+                } else {
+                    ColumnBuffer::Strings(vec![])
+                }
+            })
+            .collect();
+
+        Ok(Self {
+            dir,
+            meta,
+            timestamps: vec![],
+            buffers,
+            files,
+        })
+    }
+
+    fn append(&mut self, log: &Log) -> Result<(), StoreError> {
+        let matches = log.arguments.len() == self.meta.columns.len()
+            && log
+                .arguments
+                .iter()
+                .zip(&self.meta.columns)
+                .all(|(argument, column)| ColumnType::of(argument) == *column);
+        if !matches {
+            return Err(StoreError::MismatchedColumns(log.format_id));
+        }
+
+        self.timestamps
+            .push((log.timestamp * 1_000_000_000f64).round() as u64);
+        for (buffer, argument) in self.buffers.iter_mut().zip(&log.arguments) {
+            match (buffer, argument) {
+                (ColumnBuffer::Integers(values), Argument::Signed(value)) => {
+                    values.push(*value as u64)
+                }
+                (ColumnBuffer::Integers(values), Argument::Unsigned(value))
+                | (ColumnBuffer::Integers(values), Argument::Pointer(value)) => values.push(*value),
+                (ColumnBuffer::Integers(values), Argument::Float(value)) => {
+                    values.push(float_to_ordered(*value))
+                }
+                (ColumnBuffer::Strings(values), Argument::String(value))
+                | (ColumnBuffer::Strings(values), Argument::InternedString(value)) => {
+                    values.push(value.clone())
+                }
+                (ColumnBuffer::Strings(values), Argument::Bytes(value)) => {
+                    values.push(format_hex(value))
+                }
+                (ColumnBuffer::Strings(values), Argument::SignedArray(value)) => {
+                    values.push(join_elements(value))
+                }
+                (ColumnBuffer::Strings(values), Argument::UnsignedArray(value)) => {
+                    values.push(join_elements(value))
+                }
+                (ColumnBuffer::Strings(values), Argument::Enum { value, name }) => {
+                    values.push(join_enum(*value, name.as_deref()))
+                }
+                _ => unreachable!("Argument type does not match its column"),
+            }
+        }
+
+        if self.timestamps.len() == BLOCK_SIZE {
+            self.flush_block()?;
+        }
+        Ok(())
+    }
+
+    /// Encodes the buffered rows as a block in every column, then records them in the
+    /// metadata so that the partition can be read if the ingestion is interrupted.
+    fn flush_block(&mut self) -> Result<(), StoreError> {
+        if self.timestamps.is_empty() {
+            return Ok(());
+        }
+        write_integer_block(&mut self.files[0], &self.timestamps, false)?;
+        for ((buffer, file), column) in self
+            .buffers
+            .iter_mut()
+            .zip(&mut self.files[1..])
+            .zip(&self.meta.columns)
+        {
+            match buffer {
+                ColumnBuffer::Integers(values) => {
+                    write_integer_block(file, values, *column == ColumnType::Signed)?;
+                    values.clear();
+                }
+                ColumnBuffer::Strings(values) => {
+                    write_string_block(file, values)?;
+                    values.clear();
+                }
+            }
+        }
+        self.meta.sizes.clear();
+        for file in &mut self.files {
+            file.flush()?;
+            self.meta.sizes.push(file.get_ref().metadata()?.len());
+        }
+        self.meta.rows += self.timestamps.len() as u64;
+        self.timestamps.clear();
+
+        // The metadata is replaced at once, so it always describes complete blocks
+        let temporary = self.dir.join(format!("{}.tmp", META_FILE));
+        fs::write(&temporary, serde_json::to_vec_pretty(&self.meta)?)?;
+        fs::rename(temporary, self.dir.join(META_FILE))?;
+        Ok(())
+    }
+
+    fn finish(&mut self) -> Result<(), StoreError> {
+        self.flush_block()
+    }
+}
+
+/// Appends logs to a store.
+pub struct StoreWriter {
+    root: PathBuf,
+    partitions: HashMap<usize, PartitionWriter>,
+}
+
+impl StoreWriter {
+    /// Opens the store at `root` for logs of the given build, creating it if needed.
+    pub fn open(root: &Path, build_id: &str) -> Result<Self, StoreError> {
+        fs::create_dir_all(root)?;
+        match fs::read_to_string(root.join(BUILD_ID_FILE)) {
+            Ok(stored) if stored != build_id => {
+                return Err(StoreError::MismatchedBuild(stored, build_id.to_owned()))
+            }
+            Ok(_) => {}
+            Err(e) if e.kind() == io::ErrorKind::NotFound => {
+                fs::write(root.join(BUILD_ID_FILE), build_id)?
+            }
+            Err(e) => return Err(e.into()),
+        }
+        Ok(Self {
+            root: root.to_owned(),
+            partitions: HashMap::new(),
+        })
+    }
+
+    pub fn append(&mut self, log: &Log) -> Result<(), StoreError> {
+        let partition = match self.partitions.get_mut(&log.format_id) {
+            Some(partition) => partition,
+            None => {
+                let partition = PartitionWriter::open(&self.root, log)?;
+                self.partitions.entry(log.format_id).or_insert(partition)
+            }
+        };
+        partition.append(log)
+    }
+
+    /// Writes every buffered row and the metadata of all partitions.
+    pub fn finish(mut self) -> Result<(), StoreError> {
+        for partition in self.partitions.values_mut() {
+            partition.finish()?;
+        }
+        Ok(())
+    }
+}
+
+/// Conditions on the rows returned by a query.
+#[derive(Debug, Default)]
+pub struct Query {
+    /// Index of the argument to return.
+    pub column: usize,
+    /// Earliest timestamp, in nanoseconds.
+    pub from: Option<u64>,
+    /// Latest timestamp, in nanoseconds.
+    pub to: Option<u64>,
+    /// Minimum value of an integer argument.
+    pub min: Option<i128>,
+    /// Maximum value of an integer argument.
+    pub max: Option<i128>,
+}
+
+impl Query {
+    fn overlaps(min: i128, max: i128, from: Option<i128>, to: Option<i128>) -> bool {
+        from.map_or(true, |from| max >= from) && to.map_or(true, |to| min <= to)
+    }
+}
+
+/// Read access to a store.
+pub struct Store {
+    root: PathBuf,
+}
+
+impl Store {
+    pub fn open(root: &Path) -> Self {
+        Self {
+            root: root.to_owned(),
+        }
+    }
+
+    /// Returns the description of every partition of the store.
+    pub fn partitions(&self) -> Result<Vec<PartitionMeta>, StoreError> {
+        let mut partitions = vec![];
+        for entry in fs::read_dir(&self.root)? {
+            let meta_path = entry?.path().join(META_FILE);
+            if meta_path.exists() {
+                partitions.push(serde_json::from_slice(&fs::read(meta_path)?)?);
+            }
+        }
+        partitions.sort_by_key(|meta: &PartitionMeta| (meta.file.clone(), meta.line));
+        Ok(partitions)
+    }
+
+    /// Returns the timestamp (in nanoseconds) and value of the selected argument of every row
+    /// of the partition matching the query.
+    ///
+    /// Only the timestamps column and the column of the argument are read. Blocks whose
+    /// timestamp or value range falls outside the query are skipped without decoding them.
+    pub fn query(
+        &self,
+        meta: &PartitionMeta,
+        query: &Query,
+    ) -> Result<Vec<(u64, Argument)>, StoreError> {
+        let column_type = *meta
+            .columns
+            .get(query.column)
+            .ok_or(StoreError::MissingColumn(meta.format_id, query.column))?;
+        let dir = self.root.join(meta.format_id.to_string());
+        let mut timestamps = BufReader::new(File::open(dir.join(TIMESTAMPS_FILE))?);
+        let mut values = BufReader::new(File::open(dir.join(column_file(query.column)))?);
+        let (from, to) = (query.from.map(i128::from), query.to.map(i128::from));
+
+        let mut rows = vec![];
+        // Blocks after the rows of the metadata may be incomplete
+        let mut remaining_rows = meta.rows;
+        while remaining_rows > 0 {
+            let ts_header = match read_integer_header(&mut timestamps)? {
+                Some(header) => header,
+                None => break,
+            };
+            remaining_rows = remaining_rows.saturating_sub(ts_header.count as u64);
+            let in_time = Query::overlaps(ts_header.min as i128, ts_header.max as i128, from, to);
+
+            if column_type.is_integer() {
+                let header = read_integer_header(&mut values)?
+                    .ok_or_else(|| io::Error::from(io::ErrorKind::UnexpectedEof))?;
+                let in_range = Query::overlaps(
+                    column_type.to_number(header.min),
+                    column_type.to_number(header.max),
+                    query.min,
+                    query.max,
+                );
+                if !in_time || !in_range {
+                    skip_integer_block(&mut timestamps, &ts_header)?;
+                    skip_integer_block(&mut values, &header)?;
+                    continue;
+                }
+
+                let block_timestamps = read_integer_block(&mut timestamps, &ts_header)?;
+                let block_values = read_integer_block(&mut values, &header)?;
+                for (timestamp, raw) in block_timestamps.into_iter().zip(block_values) {
+                    let value = column_type.to_number(raw);
+                    if Query::overlaps(timestamp as i128, timestamp as i128, from, to)
+                        && Query::overlaps(value, value, query.min, query.max)
+                    {
+                        rows.push((timestamp, column_type.to_argument(raw)));
+                    }
+                }
+            } else {
+                if !in_time {
+                    skip_integer_block(&mut timestamps, &ts_header)?;
+                    read_string_block(&mut values, false)?;
+                    continue;
+                }
+
+                let block_timestamps = read_integer_block(&mut timestamps, &ts_header)?;
+                let block_values = read_string_block(&mut values, true)?
+                    .ok_or_else(|| io::Error::from(io::ErrorKind::UnexpectedEof))?;
+                for (timestamp, value) in block_timestamps.into_iter().zip(block_values) {
+                    if Query::overlaps(timestamp as i128, timestamp as i128, from, to) {
+                        rows.push((timestamp, column_type.string_argument(value)));
+                    }
+                }
+            }
+        }
+        Ok(rows)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use postform_decoder::LogLevel;
+
+    fn log(timestamp: f64, value: i64, name: &str) -> Log {
+        Log {
+            timestamp,
+            level: LogLevel::Info,
+            message: String::new(),
+            file_name: "src/main.cpp".to_owned(),
+            line_number: 57,
+            format_id: 12,
+            format: "%d %s".to_owned(),
+            arguments: vec![Argument::Signed(value), Argument::String(name.to_owned())],
+        }
+    }
+
+    #[test]
+    fn test_store_round_trip() {
+        let root = std::env::temp_dir().join(format!("postform_store_test_{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+
+        // Two ingestions append to the same partition
+        for _ in 0..2 {
+            let mut writer = StoreWriter::open(&root, "build").unwrap();
+            for i in 0..BLOCK_SIZE + 10 {
+                writer
+                    .append(&log(i as f64, i as i64 - 100, &i.to_string()))
+                    .unwrap();
+            }
+            writer.finish().unwrap();
+        }
+        assert!(StoreWriter::open(&root, "other build").is_err());
+
+        let store = Store::open(&root);
+        let partitions = store.partitions().unwrap();
+        assert_eq!(partitions.len(), 1);
+        let meta = &partitions[0];
+        assert_eq!(meta.rows, 2 * (BLOCK_SIZE as u64 + 10));
+        assert_eq!(meta.columns, vec![ColumnType::Signed, ColumnType::String]);
+
+        let rows = store
+            .query(
+                meta,
+                &Query {
+                    column: 0,
+                    from: Some(1_000_000_000_000),
+                    max: Some(920),
+                    ..Query::default()
+                },
+            )
+            .unwrap();
+        let values: Vec<_> = rows.iter().map(|(_, value)| value.clone()).collect();
+        let expected: Vec<_> = (900..=920).chain(900..=920).map(Argument::Signed).collect();
+        assert_eq!(values, expected);
+
+        let rows = store
+            .query(
+                meta,
+                &Query {
+                    column: 1,
+                    to: Some(1_000_000_000),
+                    ..Query::default()
+                },
+            )
+            .unwrap();
+        assert_eq!(rows.len(), 4);
+        assert_eq!(rows[1], (1_000_000_000, Argument::String("1".to_owned())));
+
+        fs::remove_dir_all(&root).unwrap();
+    }
+
+    #[test]
+    fn test_floats_keep_their_order() {
+        let values = [f64::NEG_INFINITY, -2.5, -0.0, 0.0, 1e-300, 3.25, f64::MAX];
+        let ordered: Vec<_> = values.iter().copied().map(float_to_ordered).collect();
+        assert!(ordered.windows(2).all(|pair| pair[0] < pair[1]));
+        for (value, raw) in values.iter().zip(ordered) {
+            assert_eq!(ordered_to_float(raw).to_bits(), value.to_bits());
+        }
+        assert_eq!(ColumnType::Float.to_number(float_to_ordered(-2.5)), -3);
+    }
+
+    #[test]
+    fn test_bytes_round_trip_through_hex() {
+        let bytes = vec![0x00, 0x7f, 0xde, 0xff];
+        assert_eq!(
+            ColumnType::Bytes.string_argument(format_hex(&bytes)),
+            Argument::Bytes(bytes)
+        );
+    }
+
+    #[test]
+    fn test_arrays_round_trip_through_strings() {
+        let signed = vec![-1, 0, i64::MIN];
+        assert_eq!(
+            ColumnType::SignedArray.string_argument(join_elements(&signed)),
+            Argument::SignedArray(signed)
+        );
+        assert_eq!(
+            ColumnType::UnsignedArray.string_argument(join_elements::<u64>(&[])),
+            Argument::UnsignedArray(vec![])
+        );
+    }
+
+    #[test]
+    fn test_interrupted_ingestion() {
+        let root =
+            std::env::temp_dir().join(format!("postform_store_crash_{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+
+        // Rows of a full block are recorded before the ingestion finishes
+        let mut writer = StoreWriter::open(&root, "build").unwrap();
+        for i in 0..BLOCK_SIZE + 3 {
+            writer.append(&log(i as f64, i as i64, "row")).unwrap();
+        }
+        let store = Store::open(&root);
+        assert_eq!(store.partitions().unwrap()[0].rows, BLOCK_SIZE as u64);
+
+        // A block that was only partly written is ignored and then overwritten
+        drop(writer);
+        let dir = root.join("12");
+        for name in &[TIMESTAMPS_FILE, "arg0", "arg1"] {
+            let mut file = OpenOptions::new()
+                .append(true)
+                .open(dir.join(name))
+                .unwrap();
+            file.write_all(&[0xFF; 7]).unwrap();
+        }
+        let meta = &store.partitions().unwrap()[0];
+        assert_eq!(
+            store.query(meta, &Query::default()).unwrap().len(),
+            BLOCK_SIZE
+        );
+
+        let mut writer = StoreWriter::open(&root, "build").unwrap();
+        writer.append(&log(0f64, -1, "row")).unwrap();
+        writer.finish().unwrap();
+        let meta = &store.partitions().unwrap()[0];
+        let rows = store.query(meta, &Query::default()).unwrap();
+        assert_eq!(rows.len(), BLOCK_SIZE + 1);
+        assert_eq!(rows[BLOCK_SIZE], (0, Argument::Signed(-1)));
+
+        fs::remove_dir_all(&root).unwrap();
+    }
+
+    #[test]
+    fn test_corrupt_bytes_column() {
+        assert_eq!(
+            ColumnType::Bytes.string_argument("0é1ab".to_owned()),
+            Argument::Bytes(vec![0xab])
+        );
+    }
+
+    #[test]
+    fn test_enums_round_trip_through_strings() {
+        for (value, name) in [(-1, Some("kError")), (5, None)] {
+            assert_eq!(
+                ColumnType::Enum.string_argument(join_enum(value, name)),
+                Argument::Enum {
+                    value,
+                    name: name.map(str::to_owned)
+                }
+            );
+        }
+    }
+}